@@ -0,0 +1,27 @@
+#version 330 core
+#extension GL_ARB_separate_shader_objects : enable
+
+// Attributes ------------------------------------------------------------------
+
+layout (location = 0) in vec2 in_pos;     // Unit quad.
+
+// Per instance.
+layout (location = 1) in vec4 in_rect;    // x, y, width, height.
+layout (location = 2) in vec4 in_color;
+
+out vec4 color;
+
+// Uniforms --------------------------------------------------------------------
+
+layout (std140) uniform Camera {
+  mat4 proj;
+  mat4 view;
+} camera;
+
+// Code ------------------------------------------------------------------------
+
+void main() {
+  vec2 pos = in_rect.xy + in_pos * in_rect.zw;
+  gl_Position = camera.proj * camera.view * vec4(pos, 0, 1.0);
+  color = in_color;
+}
@@ -0,0 +1,163 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+// Compares FlatHashMap against std::unordered_map with uint64_t keys (like
+// the renderer resource uuids): inserts, lookups that hit (in random order),
+// lookups that miss and erases. Reports nanoseconds per operation.
+//
+// Usage: flat_hash_map_benchmark [thousands_of_keys] [rounds]
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <warhol/containers/flat_hash_map.h>
+#include <warhol/platform/platform.h>
+#include <warhol/utils/log.h>
+
+using namespace warhol;
+
+namespace {
+
+struct Timings {
+  double insert = 0;
+  double hit = 0;
+  double miss = 0;
+  double erase = 0;
+};
+
+// Keeps the compiler from dropping the lookups.
+volatile uint64_t sink = 0;
+
+double NsPerOp(uint64_t start, size_t count) {
+  return (double)(GetNanoseconds() - start) / (double)count;
+}
+
+Timings RunFlatHashMap(const std::vector<uint64_t>& keys,
+                       const std::vector<uint64_t>& lookups,
+                       const std::vector<uint64_t>& misses) {
+  Timings timings;
+  FlatHashMap<uint64_t, uint64_t> map;
+
+  uint64_t start = GetNanoseconds();
+  for (uint64_t key : keys)
+    Insert(&map, key, key);
+  timings.insert = NsPerOp(start, keys.size());
+
+  uint64_t sum = 0;
+  start = GetNanoseconds();
+  for (uint64_t key : lookups)
+    sum += *Find(&map, key);
+  timings.hit = NsPerOp(start, lookups.size());
+
+  start = GetNanoseconds();
+  for (uint64_t key : misses)
+    sum += Contains(&map, key);
+  timings.miss = NsPerOp(start, misses.size());
+
+  start = GetNanoseconds();
+  for (uint64_t key : lookups)
+    sum += Erase(&map, key);
+  timings.erase = NsPerOp(start, lookups.size());
+
+  sink = sum;
+  return timings;
+}
+
+Timings RunUnorderedMap(const std::vector<uint64_t>& keys,
+                        const std::vector<uint64_t>& lookups,
+                        const std::vector<uint64_t>& misses) {
+  Timings timings;
+  std::unordered_map<uint64_t, uint64_t> map;
+
+  uint64_t start = GetNanoseconds();
+  for (uint64_t key : keys)
+    map[key] = key;
+  timings.insert = NsPerOp(start, keys.size());
+
+  uint64_t sum = 0;
+  start = GetNanoseconds();
+  for (uint64_t key : lookups)
+    sum += map.find(key)->second;
+  timings.hit = NsPerOp(start, lookups.size());
+
+  start = GetNanoseconds();
+  for (uint64_t key : misses)
+    sum += map.count(key);
+  timings.miss = NsPerOp(start, misses.size());
+
+  start = GetNanoseconds();
+  for (uint64_t key : lookups)
+    sum += map.erase(key);
+  timings.erase = NsPerOp(start, lookups.size());
+
+  sink = sum;
+  return timings;
+}
+
+void Accumulate(Timings* total, const Timings& timings) {
+  total->insert += timings.insert;
+  total->hit += timings.hit;
+  total->miss += timings.miss;
+  total->erase += timings.erase;
+}
+
+void Report(const char* name, Timings timings, int rounds) {
+  LOG(INFO) << name << ": insert " << timings.insert / rounds
+            << " ns, hit " << timings.hit / rounds
+            << " ns, miss " << timings.miss / rounds
+            << " ns, erase " << timings.erase / rounds << " ns.";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t key_count = 1000 * 1000;
+  int rounds = 5;
+  if (argc > 1)
+    key_count = (uint64_t)atoll(argv[1]) * 1000;
+  if (argc > 2)
+    rounds = atoi(argv[2]);
+  if (key_count == 0 || rounds <= 0) {
+    LOG(ERROR) << "Usage: flat_hash_map_benchmark [thousands_of_keys] [rounds]";
+    return 1;
+  }
+
+  std::mt19937_64 rng(1234);
+
+  // Sequential keys (as uuids are handed out) are the best case for
+  // std::unordered_map, whose integer hash is the identity. Random keys are
+  // the general case.
+  std::vector<uint64_t> sequential(key_count);
+  std::vector<uint64_t> random(key_count);
+  for (uint64_t i = 0; i < key_count; i++) {
+    sequential[i] = i + 1;
+    random[i] = rng() | 1;    // Misses are even.
+  }
+
+  for (auto* keys : {&sequential, &random}) {
+    std::vector<uint64_t> lookups = *keys;
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+
+    std::vector<uint64_t> misses(key_count);
+    for (uint64_t i = 0; i < key_count; i++)
+      misses[i] = keys == &sequential ? key_count + 1 + i : rng() & ~1ull;
+
+    Timings flat_total;
+    Timings std_total;
+    for (int i = 0; i < rounds; i++) {
+      Accumulate(&flat_total, RunFlatHashMap(*keys, lookups, misses));
+      Accumulate(&std_total, RunUnorderedMap(*keys, lookups, misses));
+    }
+
+    LOG(INFO) << key_count << (keys == &sequential ? " sequential" : " random")
+              << " keys, " << rounds << " rounds.";
+    Report("FlatHashMap       ", flat_total, rounds);
+    Report("std::unordered_map", std_total, rounds);
+  }
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+// Copyright 2018, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+// Times the multithreaded update of a voxel sphere over the job system.
+
+#include <warhol/multithreading/job_system.h>
+#include <warhol/platform/platform.h>
+#include <warhol/utils/log.h>
+
+#include "voxel/voxel_terrain.h"
+#include "voxel/voxel_utils.h"
+
+using namespace warhol;
+
+namespace {
+
+constexpr int kRounds = 10;
+
+}  // namespace
+
+int main() {
+  JobSystem job_system;
+  if (!InitJobSystem(&job_system)) {
+    LOG(ERROR) << "Could not start job system.";
+    return 1;
+  }
+
+  uint64_t total = 0;
+  for (int i = 0; i < kRounds; i++) {
+    VoxelTerrain terrain(nullptr);
+    SetupSphere(&terrain, {}, 50);
+
+    uint64_t start = GetNanoseconds();
+    terrain.UpdateMT(&job_system);
+    total += GetNanoseconds() - start;
+  }
+
+  LOG(INFO) << "Terrain update with " << job_system.worker_count
+            << " workers: " << (double)total / kRounds / 1e6
+            << " ms on average over " << kRounds << " rounds.";
+
+  ShutdownJobSystem(&job_system);
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+// Stress benchmark for MPMCQueue: N producers and N consumers move a fixed
+// amount of items through a single queue. Verifies that every item arrives
+// exactly once and reports the throughput.
+//
+// Usage: mpmc_queue_benchmark [threads_per_side] [millions_of_items]
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <warhol/multithreading/mpmc_queue.h>
+#include <warhol/platform/platform.h>
+#include <warhol/utils/log.h>
+
+using namespace warhol;
+
+namespace {
+
+constexpr uint32_t kQueueCapacity = 4096;
+using Queue = MPMCQueue<uint64_t, kQueueCapacity>;
+
+// Every thread writes its own result all the time. A cache line each, so they
+// don't falsely share and skew the numbers.
+struct alignas(64) Result {
+  uint64_t items = 0;
+  uint64_t sum = 0;
+  uint64_t full_count = 0;    // Times a push found the queue full.
+};
+
+void Producer(Queue* queue, uint64_t begin, uint64_t end, Result* result) {
+  for (uint64_t i = begin; i < end; i++) {
+    while (!TryPush(queue, i)) {
+      result->full_count++;
+      std::this_thread::yield();
+    }
+  }
+}
+
+void Consumer(Queue* queue, std::atomic<uint64_t>* remaining, Result* result) {
+  uint64_t value;
+  while (remaining->load(std::memory_order_relaxed) > 0) {
+    if (!TryPop(queue, &value)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    result->items++;
+    result->sum += value;
+    remaining->fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t threads_per_side = 4;
+  uint64_t item_count = 10 * 1000 * 1000;
+  if (argc > 1)
+    threads_per_side = (uint32_t)atoi(argv[1]);
+  if (argc > 2)
+    item_count = (uint64_t)atoll(argv[2]) * 1000 * 1000;
+  if (threads_per_side == 0 || item_count == 0) {
+    LOG(ERROR) << "Usage: mpmc_queue_benchmark [threads] [millions_of_items]";
+    return 1;
+  }
+
+  auto queue = std::make_unique<Queue>();
+  std::atomic<uint64_t> remaining = item_count;
+
+  std::vector<Result> producer_results(threads_per_side);
+  std::vector<Result> consumer_results(threads_per_side);
+  std::vector<std::thread> threads;
+
+  uint64_t start = GetNanoseconds();
+
+  uint64_t items_per_producer = item_count / threads_per_side;
+  for (uint32_t i = 0; i < threads_per_side; i++) {
+    uint64_t begin = i * items_per_producer;
+    uint64_t end = i + 1 == threads_per_side ? item_count
+                                             : begin + items_per_producer;
+    threads.push_back(std::thread(Producer, queue.get(), begin, end,
+                                  &producer_results[i]));
+    threads.push_back(std::thread(Consumer, queue.get(), &remaining,
+                                  &consumer_results[i]));
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  uint64_t elapsed = GetNanoseconds() - start;
+
+  Result total;
+  for (auto& result : consumer_results) {
+    total.items += result.items;
+    total.sum += result.sum;
+  }
+  for (auto& result : producer_results)
+    total.full_count += result.full_count;
+
+  // Items are [0, item_count).
+  uint64_t expected_sum = item_count * (item_count - 1) / 2;
+  if (total.items != item_count || total.sum != expected_sum) {
+    LOG(ERROR) << "Lost or duplicated items! Got " << total.items
+               << " items (expected " << item_count << ").";
+    return 1;
+  }
+
+  double seconds = (double)elapsed / 1e9;
+  LOG(INFO) << 2 * threads_per_side << " threads moved " << item_count
+            << " items in " << seconds * 1000.0 << " ms: "
+            << (double)item_count / seconds / 1e6 << " M items/s ("
+            << total.full_count << " full pushes).";
+  return 0;
+}
@@ -15,31 +15,38 @@ namespace {
 
 struct DrawerVertex {
   Vec2 pos;
-  uint32_t color;
 };
 
 }  // namespace
 
 bool InitDrawer(Game* game, Drawer* drawer) {
   drawer->shader.name = "Drawer";
-  if (!RendererLoadShader(&game->renderer, &game->paths, "square", "square",
-                          &drawer->shader)) {
+  // Squares are instances of a unit quad (see SquareInstance).
+  if (!RendererLoadShader(&game->renderer, &game->paths, "square_instanced",
+                          "square", &drawer->shader)) {
     LOG(ERROR) << "Could not load shader!";
     return false;
   }
 
   drawer->mesh.name = "DrawerMesh";
 
-  // Create a Mesh for creating a buffer.
-  drawer->mesh.name = "Imgui Mesh";
+  // A unit quad that every square instances. It never changes, so it is
+  // uploaded once here.
   drawer->mesh.uuid = GetNextMeshUUID();
   drawer->mesh.vertex_size = sizeof(DrawerVertex);
   drawer->mesh.attributes = {
-    {2, AttributeType::kFloat, false},  // Pos.
-    {4, AttributeType::kUint8, true},   // Color.
+    {2, AttributeType::kFloat, false},      // Pos.
+    {4, AttributeType::kFloat, false, 1},   // Rect (per instance).
+    {4, AttributeType::kUint8, true, 1},    // Color (per instance).
   };
+  ASSERT(InstanceAttributesSize(&drawer->mesh) == sizeof(SquareInstance));
 
-  InitMeshPools(&drawer->mesh, MEGABYTES(16), MEGABYTES(16));
+  InitMeshPools(&drawer->mesh, KILOBYTES(1), KILOBYTES(1));
+
+  DrawerVertex vertices[4] = {{{0, 0}}, {{1, 0}}, {{1, 1}}, {{0, 1}}};
+  uint32_t indices[6] = {0, 1, 2, 2, 3, 0};
+  PushVertices(&drawer->mesh, vertices, ARRAY_SIZE(vertices));
+  PushIndices(&drawer->mesh, indices, ARRAY_SIZE(indices));
 
   if (!RendererStageMesh(&game->renderer, &drawer->mesh))
     return false;
@@ -64,6 +71,7 @@ void ShutdownDrawer(Drawer* drawer) {
   ASSERT(Valid(drawer));
   RendererUnstageMesh(drawer->renderer, &drawer->mesh);
   drawer->mesh = {};
+  drawer->instances = {};
   RendererUnstageShader(drawer->renderer, &drawer->shader);
   drawer->shader = {};
 }
@@ -74,36 +82,19 @@ bool Valid(Drawer* drawer) {
 
 void DrawerNewFrame(Drawer* drawer) {
   ResetMemoryPool(&drawer->pool);
-  ResetMesh(&drawer->mesh);
+  drawer->instances = CreateFrameArray<SquareInstance>();
 }
 
 void DrawSquare(Drawer* drawer, Int2 tl, Int2 br, uint32_t color) {
   SCOPE_LOCATION();
 
-  DrawerVertex vertices[4];
-  vertices[0].pos = {(float)tl.x, (float)tl.y};
-  vertices[0].color = color;
-
-  vertices[1].pos = {(float)br.x, (float)tl.y};
-  vertices[1].color = color;
-
-  vertices[2].pos = {(float)br.x, (float)br.y};
-  vertices[2].color = color;
-
-  vertices[3].pos = {(float)tl.x, (float)br.y};
-  vertices[3].color = color;
-
-  uint32_t vert_count = drawer->mesh.vertex_count;
-  uint32_t indices[6];
-  indices[0] = vert_count + 0;
-  indices[1] = vert_count + 1;
-  indices[2] = vert_count + 2;
-  indices[3] = vert_count + 2;
-  indices[4] = vert_count + 3;
-  indices[5] = vert_count + 0;
-
-  PushVertices(&drawer->mesh, vertices, ARRAY_SIZE(vertices));
-  PushIndices(&drawer->mesh, indices, 6);
+  SquareInstance instance;
+  instance.rect[0] = (float)tl.x;
+  instance.rect[1] = (float)tl.y;
+  instance.rect[2] = (float)(br.x - tl.x);
+  instance.rect[3] = (float)(br.y - tl.y);
+  instance.color = color;
+  Push(&drawer->instances, instance);
 };
 
 void DrawBorderSquare(Drawer* drawer, Int2 tl, Int2 br, uint32_t color) {
@@ -128,15 +119,16 @@ RenderCommand DrawerEndFrame(Drawer* drawer) {
   float B = drawer->camera.viewport_p2.y;
   drawer->camera.projection = glm::ortho(L, R, B, T);
 
-  // Send the frame over.
-  if (!RendererUploadMeshRange(drawer->renderer, &drawer->mesh))
-    NOT_REACHED() << "Could not upload mesh range";
-
+  // All the squares of the frame go in one instanced draw of the quad.
   MeshRenderAction action;
-  action.mesh = &drawer->mesh;
-  action.index_range = CreateRange(drawer->mesh.index_count, 0);
+  action.mesh = drawer->mesh.handle.value;
+  if (!Empty(&drawer->instances)) {
+    action.index_range = CreateRange(drawer->mesh.index_count, 0);
+    action.instance_count = drawer->instances.size;
+    action.instance_data = (uint8_t*)drawer->instances.data;
+  }
 
-  auto actions = CreateList<MeshRenderAction>(KILOBYTES(1));
+  auto actions = CreateFrameArray<MeshRenderAction>(1);
   Push(&actions, std::move(action));
 
   RenderCommand render_command;
@@ -148,7 +140,7 @@ RenderCommand DrawerEndFrame(Drawer* drawer) {
   render_command.config.scissor_test = false;
   render_command.config.wireframe_mode = true;
   render_command.camera = &drawer->camera;
-  render_command.shader = &drawer->shader;
+  render_command.shader = drawer->shader.handle.value;
   render_command.mesh_actions = std::move(actions);
 
   return render_command;
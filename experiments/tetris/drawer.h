@@ -24,6 +24,14 @@ struct Colors {
   static constexpr uint32_t kGray = 0xff'99'99'99;
 };
 
+// One per square. The mesh is a single unit quad drawn once per instance.
+// Plain data: its layout is the instance stream the shader reads.
+struct SquareInstance {
+  float rect[4];    // x, y, width, height.
+  uint32_t color;
+};
+static_assert(sizeof(SquareInstance) == 20);
+
 struct Drawer {
   RAII_CONSTRUCTORS(Drawer);
 
@@ -31,6 +39,8 @@ struct Drawer {
   Mesh mesh;
   Shader shader;
 
+  Array<SquareInstance> instances;    // Frame memory.
+
   MemoryPool pool;
 
   // Must outlive.
@@ -34,7 +34,7 @@ bool InitGame(Game* game,
     LOG(ERROR) << "Could not start imgui.";
     return false;
   }
-  /* TrackImguiMemory(&game->memory_tracker, &game->imgui); */
+  TrackImguiMemory(&game->imgui);
 
   game->input = InputState::Create();
 
@@ -52,11 +52,11 @@ List<WindowEvent> NewFrame(Game* game) {
   return UpdateWindow(&game->window, &game->input);
 }
 
-void EndFrame(Game* game, List<RenderCommand> command_list) {
+void EndFrame(Game* game, List<RenderCommand>* command_list) {
   SCOPE_LOCATION();
 
   RendererStartFrame(&game->renderer);
-  RendererExecuteCommands(&game->renderer, &command_list);
+  RendererExecuteCommands(&game->renderer, command_list);
   RendererEndFrame(&game->renderer);
   WindowSwapBuffers(&game->window);
 }
@@ -19,7 +19,6 @@ namespace tetris {
 
 struct Game {
   ::warhol::PlatformTime time;
-  ::warhol::MemoryTracker memory_tracker;
   ::warhol::Window window;
   ::warhol::Renderer renderer;
   ::warhol::InputState input;
@@ -32,6 +31,6 @@ struct Game {
 
 bool InitGame(Game*, WindowBackendType, RendererType);
 List<WindowEvent> NewFrame(Game*);
-void EndFrame(Game*, List<RenderCommand>);
+void EndFrame(Game*, List<RenderCommand>*);
 
 }  // namespace tetris
@@ -53,48 +53,24 @@ void SystemUI(Game* game, Tetris* tetris) {
   }
 
   if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen)) {
-    const auto& memory_tracker = GetGlobalTracker();
-
-    for (auto [id, pool] : memory_tracker.tracked_pools) {
-      float used_ratio = (float)Used(pool) / (float)pool->size;
-      auto used_str = BytesToString(Used(pool));
-      auto total_str = BytesToString(pool->size);
+    static bool show_memory_window = false;
+    ImGui::Checkbox("Details", &show_memory_window);
+    if (show_memory_window)
+      imgui::ImguiMemoryTrackerWindow(&show_memory_window);
+
+    for (const TrackedStats& stats : GetTrackedStats()) {
+      if (stats.reserved == 0)
+        continue;
+
+      float used_ratio = (float)stats.used / (float)stats.reserved;
+      auto used_str = BytesToString(stats.used);
+      auto total_str = BytesToString(stats.reserved);
       auto bar = StringPrintf("%s/%s", used_str.c_str(), total_str.c_str());
 
       ImGui::ProgressBar(used_ratio, {0, 0}, bar.c_str());
       ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x);
-      ImGui::Text("%s", pool->name);
+      ImGui::Text("%s", stats.name ? stats.name : ToString(stats.type));
     }
-
-    /* for (Mesh* mesh : game->memory_tracker.tracked_meshes) { */
-    /*   { */
-    /*     MemoryPool* pool = &mesh->vertices; */
-    /*     float used_ratio = (float)Used(pool) / (float)pool->size; */
-    /*     auto used_str = BytesToString(Used(pool)); */
-    /*     auto total_str = BytesToString(pool->size); */
-    /*     auto bar = StringPrintf("%s/%s", used_str.c_str(), total_str.c_str()); */
-
-    /*     ImGui::ProgressBar(used_ratio, {0, 0}, bar.c_str()); */
-
-    /*     auto pool_name = StringPrintf("%s.%s", mesh->name, pool->name); */
-    /*     ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x); */
-    /*     ImGui::Text("%s", pool_name.c_str()); */
-    /*   } */
-
-      /* { */
-      /*   MemoryPool* pool = &mesh->indices; */
-      /*   float used_ratio = (float)Used(pool) / (float)pool->size; */
-      /*   auto used_str = BytesToString(Used(pool)); */
-      /*   auto total_str = BytesToString(pool->size); */
-      /*   auto bar = StringPrintf("%s/%s", used_str.c_str(), total_str.c_str()); */
-
-      /*   ImGui::ProgressBar(used_ratio, {0, 0}, bar.c_str()); */
-
-      /*   auto pool_name = StringPrintf("%s.%s", mesh->name, pool->name); */
-      /*   ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x); */
-      /*   ImGui::Text("%s", pool_name.c_str()); */
-      /* } */
-    /* } */
   }
 
   ImGui::End();
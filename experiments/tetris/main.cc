@@ -1,8 +1,10 @@
 // Copyright 2019, Cristián Donoso.
 // This code has a BSD license. See LICENSE.
 
+#include <warhol/graphics/common/frame_pipeline.h>
 #include <warhol/graphics/graphics.h>
 #include <warhol/memory/memory_pool.h>
+#include <warhol/memory/memory_tracker.h>
 #include <warhol/ui/imgui.h>
 #include <warhol/utils/log.h>
 #include <warhol/window/window.h>
@@ -17,6 +19,28 @@ using namespace warhol;
 using namespace warhol::imgui;
 using namespace tetris;
 
+namespace {
+
+struct FrameContext {
+  Game* game = nullptr;
+  Tetris* tetris = nullptr;
+};
+
+void SimulateFrame(void* user_data, FramePipeline::Frame* frame) {
+  auto* context = (FrameContext*)user_data;
+  Game* game = context->game;
+  Tetris* tetris = context->tetris;
+  SCOPED_ALLOCATION_TAG(kGame);
+
+  TetrisNewFrame(game, tetris);
+  DoImguiUI(game, tetris);
+
+  Push(&frame->commands, TetrisEndFrame(game, tetris));
+  Push(&frame->commands, ImguiEndFrame(&game->imgui));
+}
+
+}  // namespace
+
 int main() {
   SCOPE_LOCATION();
 
@@ -38,6 +62,21 @@ int main() {
 
   Track(&memory_pool);
 
+  // The drawer and imgui upload their meshes while building the commands, so
+  // the simulation needs the GL context and cannot be pipelined (yet).
+  FrameContext frame_context = {&game, &tetris};
+  FramePipelineConfig pipeline_config;
+  pipeline_config.frames_in_flight = 1;
+  pipeline_config.arena_size = KILOBYTES(80);
+  pipeline_config.simulate = SimulateFrame;
+  pipeline_config.user_data = &frame_context;
+
+  FramePipeline frame_pipeline;
+  if (!InitFramePipeline(&frame_pipeline, pipeline_config)) {
+    LOG(ERROR) << "Could not initialize frame pipeline.";
+    return 1;
+  }
+
   LOG(DEBUG) << "Staring game loop.";
 
   bool running = true;
@@ -55,15 +94,9 @@ int main() {
 
     ResetMemoryPool(&memory_pool);
 
-    TetrisNewFrame(&game, &tetris);
-    DoImguiUI(&game, &tetris);
-
-    auto command_list = CreateList<RenderCommand>(KILOBYTES(16));
-
-    Push(&command_list, TetrisEndFrame(&game, &tetris));
-    Push(&command_list, ImguiEndFrame(&game.imgui));
-
-    EndFrame(&game, std::move(command_list));
+    auto* frame = AdvanceFramePipeline(&frame_pipeline);
+    EndFrame(&game, &frame->commands);
+    FinishFrame(&frame_pipeline);
   }
 
   printf("またね\n");
@@ -8,7 +8,7 @@
 namespace tetris {
 
 Shape::Shape(const char* name,
-             std::vector<Int2> offsets,
+             ShapeOffsets offsets,
              std::vector<IntMat2*> rotation_matrices)
     : name(name),
       offsets(std::move(offsets)),
@@ -28,7 +28,7 @@ IntMat2 kRotationMatrices[] = {
 };
 
 Shape CreateShape(const char* name,
-                  std::vector<Int2> offsets,
+                  ShapeOffsets offsets,
                   std::initializer_list<uint32_t> matrix_indices) {
   std::vector<IntMat2*> matrices;
   matrices.reserve(matrix_indices.size());
@@ -102,7 +102,7 @@ CheckShapeCollision(Board* board, Shape* shape, Int2 pivot) {
 }
 
 Collision CheckCollision(Board* board, Int2 pivot,
-                         const std::vector<Int2>& offsets,
+                         const ShapeOffsets& offsets,
                          bool collide_live) {
   for (const Int2& sqr_offset : offsets) {
     Int2 sqr_pos = pivot + sqr_offset;
@@ -130,12 +130,11 @@ Collision CheckCollision(Board* board, Int2 pivot,
 
 // Utils -----------------------------------------------------------------------
 
-std::vector<Int2> GetRotatedOffsets(Shape* shape, int index) {
+ShapeOffsets GetRotatedOffsets(Shape* shape, int index) {
   IntMat2* rotation_matrix = GetRotationMatrix(shape, index);
-  std::vector<Int2> offsets;
-  offsets.reserve(shape->offsets.size());
+  ShapeOffsets offsets;
   for (auto& offset : shape->offsets) {
-    offsets.push_back((*rotation_matrix) * offset);
+    Push(&offsets, (*rotation_matrix) * offset);
   }
 
   return offsets;
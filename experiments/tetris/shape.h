@@ -5,6 +5,7 @@
 
 #include <vector>
 
+#include <warhol/containers/small_vector.h>
 #include <warhol/math/vec.h>
 #include <warhol/utils/log.h>
 
@@ -18,24 +19,27 @@ constexpr uint8_t kLiveBlock = 2;   // A block of a current shape.
 constexpr uint8_t kPivot = 3;       // Represents the pivot point of a shape.
 constexpr uint8_t kShadow = 4;      // Where the shape will be when dropped.
 
+// Every shape is made of 4 squares, so the offsets live inline in the shape.
+using ShapeOffsets = SmallVector<Int2, 4>;
+
 // The offsets define the places where this shape has a square offseted from its
 // position.
 struct Shape {
   Shape() = default;
   Shape(const char* name,
-        std::vector<Int2> offsets,
+        ShapeOffsets offsets,
         std::vector<IntMat2*> rotation_matrices);
 
   const char* name = nullptr;
   int rotation = 0;   // +1 means a clockwise rotation.
-  std::vector<Int2> offsets;
+  ShapeOffsets offsets;
   std::vector<IntMat2*> rotation_matrices;
 
   // Cache of offsets * current rotation_matrix.
-  std::vector<Int2> rotated_offsets;
+  ShapeOffsets rotated_offsets;
 };
 
-inline bool Valid(Shape* shape) { return !shape->offsets.empty(); }
+inline bool Valid(Shape* shape) { return !Empty(&shape->offsets); }
 // INT_MIN means the shape default.
 IntMat2* GetRotationMatrix(Shape* shape, int index = INT_MIN);
 
@@ -71,12 +75,12 @@ Collision CheckShapeCollision(Board*, Shape*, Int2 pivot);
 // If |collide_live| is true, check if the offsets collides with a live shape
 // placed within the board.
 Collision CheckCollision(Board*, Int2 pivot,
-                         const std::vector<Int2>& offsets,
+                         const ShapeOffsets& offsets,
                          bool collide_live = false);
 
 // Utils -----------------------------------------------------------------------
 
-std::vector<Int2> GetRotatedOffsets(Shape*, int offset);
+ShapeOffsets GetRotatedOffsets(Shape*, int offset);
 
 uint8_t GetSquare(Board*, Int2 coord);
 uint8_t GetSquare(Board*, int x, int y);
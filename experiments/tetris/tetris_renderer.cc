@@ -115,7 +115,7 @@ bool InitBackgroundLogic(Game* game, TetrisRenderer* tetris_renderer) {
 
   // Add the fragment uniforms.
   uint8_t* frag_ptr = Reserve(&tetris_renderer->pool,
-                              tetris_renderer->shader.frag_ubo_size);
+                              tetris_renderer->shader.frag_ubo_size, 16);
 
   uint8_t* cur_ptr = frag_ptr;
   cur_ptr = SetAndAdvance(cur_ptr, game->window.width);
@@ -184,7 +184,9 @@ void NewFrame(TetrisRenderer* tetris_renderer) {
 namespace {
 
 void AddUniforms(MeshRenderAction* action, Window* window, MemoryPool* pool) {
-  uint8_t* ptr = pool->current;
+  // Uniform blocks are read as vec4s. Pushes are aligned to their type, so
+  // the values that follow stay contiguous.
+  uint8_t* ptr = Reserve(pool, 0, 16);
   Push(pool, &window->width, 1);
   Push(pool, &window->height, 1);
 
@@ -210,7 +212,7 @@ RenderCommand DrawBackground(TetrisRenderer* renderer) {
   SCOPE_LOCATION();
 
   MeshRenderAction action;
-  action.mesh = &renderer->mesh;
+  action.mesh = renderer->mesh.handle.value;
   action.index_range = CreateRange(renderer->mesh.index_count, 0);
   action.frag_uniforms = renderer->background_frag_uniform;
 
@@ -223,9 +225,10 @@ RenderCommand DrawBackground(TetrisRenderer* renderer) {
   command.config.scissor_test = false;
   command.config.wireframe_mode = false;
   command.camera = &renderer->camera;
-  command.shader = &renderer->shader;
+  command.shader = renderer->shader.handle.value;
+  command.layer = kBackgroundRenderLayer;
 
-  command.mesh_actions = CreateList<MeshRenderAction>(KILOBYTES(1));
+  command.mesh_actions = CreateFrameArray<MeshRenderAction>(1);
   Push(&command.mesh_actions, std::move(action));
 
   return command;
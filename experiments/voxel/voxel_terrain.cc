@@ -4,13 +4,11 @@
 #include "experiments/voxel/voxel_terrain.h"
 
 #include <warhol/debug/volumes.h>
-#include <warhol/multithreading/work_queue.h>
+#include <warhol/multithreading/parallel_for.h>
 #include <warhol/shader.h>
 #include <warhol/texture_atlas.h>
 #include <warhol/utils/log.h>
 
-#include <thread>
-
 namespace warhol {
 
 namespace {
@@ -47,7 +45,7 @@ bool VoxelTerrain::Init() {
 void VoxelTerrain::SetVoxel(Pair3<int> coord, VoxelElement::Type type) {
   TieredCoord tiered_coord = GlobalToTiered(coord);
 
-  auto& chunk = voxel_chunks_[tiered_coord.chunk_coord];
+  VoxelChunk& chunk = *FindOrInsert(&voxel_chunks_, tiered_coord.chunk_coord);
   chunk.GetVoxel(tiered_coord.internal_coord).type = type;
 
   VoxelChunkMetadata metadata = {};
@@ -58,55 +56,30 @@ void VoxelTerrain::SetVoxel(Pair3<int> coord, VoxelElement::Type type) {
 
 void VoxelTerrain::Update() {
   for (auto& [coord, metadata] : temp_metadata_) {
-    auto it = voxel_chunks_.find(coord);
-    assert(it != voxel_chunks_.end());
-    VoxelChunk& chunk = it->second;
-    if (!chunk.initialized())
-      chunk.Init();
-    chunk.CalculateMesh();
+    VoxelChunk* chunk = Find(&voxel_chunks_, coord);
+    assert(chunk);
+    if (!chunk->initialized())
+      chunk->Init();
+    chunk->CalculateMesh();
   }
 
   temp_metadata_.clear();
 }
 
-namespace {
-
-struct WorkData {
-  VoxelChunk* chunk;
-  int id;
-};
-
-void CalculateMeshInWorker(void* data) {
-  WorkData* wd = (WorkData*)data;
-  /* LOG(DEBUG) << "Chunk " << wd->id << " done by thread " << std::this_thread::get_id(); */
-  wd->chunk->CalculateMesh();
-}
-
-}  // namespace
-
-void VoxelTerrain::UpdateMT(WorkQueue* queue) {
-  (void)queue;
-  static WorkData work_data[1024];
-  int i = 0;
+void VoxelTerrain::UpdateMT(JobSystem* job_system) {
+  dirty_chunks_.clear();
   for (auto& [coord, metadata] : temp_metadata_) {
-    auto it = voxel_chunks_.find(metadata.chunk_coord);
-    assert(it != voxel_chunks_.end());
-    VoxelChunk& chunk = it->second;
-    /* if (!chunk.initialized()) */
-    /*   chunk.Init(); */
-
-    /* LOG(DEBUG) << "Pushing chunk: " << metadata.chunk_coord.ToString(); */
-
-
-    work_data[i] = {&chunk, i};
-
-    PushTask(queue, {CalculateMeshInWorker, work_data + i});
-    i++;
-
-    /* chunk.CalculateMesh(); */
+    VoxelChunk* chunk = Find(&voxel_chunks_, metadata.chunk_coord);
+    assert(chunk);
+    dirty_chunks_.push_back(chunk);
   }
 
-  LOG(DEBUG) << "Pushed " << i << " chunks";
+  LOG(DEBUG) << "Meshing " << dirty_chunks_.size() << " chunks";
+
+  // Returns once all the meshes are calculated, so they can be uploaded.
+  ParallelFor(job_system, dirty_chunks_.size(), [this](size_t i) {
+    dirty_chunks_[i]->CalculateMesh();
+  });
 
   temp_metadata_.clear();
 }
@@ -5,7 +5,9 @@
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 
+#include <warhol/containers/flat_hash_map.h>
 #include <warhol/math/vec.h>
 #include <warhol/texture_array.h>
 
@@ -15,13 +17,11 @@ namespace warhol {
 
 class Shader;
 class TextureAtlas;
-struct WorkQueue;
+struct JobSystem;
 
 class VoxelTerrain {
  public:
-  // TODO(Cristian): Use my version of a hash table.
-  using VoxelChunkHash = std::unordered_map<Pair3<int>, VoxelChunk,
-                                            HashPair3<int>>;
+  using VoxelChunkHash = FlatHashMap<Pair3<int>, VoxelChunk, HashPair3<int>>;
 
   VoxelTerrain(TextureArray2D*);
   bool Init();
@@ -29,7 +29,7 @@ class VoxelTerrain {
   void SetVoxel(Pair3<int> coord, VoxelElement::Type);
   // This will update all the chucks that have changed since the last update.
   void Update();
-  void UpdateMT(WorkQueue*);
+  void UpdateMT(JobSystem*);
 
   void DrawChunkVolume(Pair3<int>, Vec3 color = {1, 1, 1});
   void Render(Shader*, bool debug = false);
@@ -46,6 +46,8 @@ class VoxelTerrain {
   };
   VoxelChunkHash voxel_chunks_;
   std::unordered_map<Pair3<int>, VoxelChunkMetadata, HashPair3<int>> temp_metadata_;
+  // Scratch for UpdateMT. Kept around to reuse its allocation.
+  std::vector<VoxelChunk*> dirty_chunks_;
 
   TextureArray2D* tex_array_;   // Not owning. Must outlive.
   bool initialized_ = false;
@@ -0,0 +1,95 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/containers/array.h>
+
+#include <third_party/catch2/catch.hpp>
+#include <warhol/memory/memory_pool.h>
+
+#include <memory>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("Array") {
+  SECTION("Heap array") {
+    Array<uint32_t> array;
+    CHECK(Empty(&array));
+
+    for (uint32_t i = 0; i < 100; i++)
+      Push(&array, i * i);
+
+    REQUIRE(array.size == 100);
+    CHECK(array.capacity >= 100);
+    CHECK(array.arena == nullptr);
+
+    uint32_t i = 0;
+    for (uint32_t value : array) {
+      CHECK(value == i * i);
+      i++;
+    }
+
+    Pop(&array);
+    CHECK(array.size == 99);
+    CHECK(array[98] == 98 * 98);
+
+    ShrinkToFit(&array);
+    CHECK(array.capacity == 99);
+    CHECK(array[50] == 50 * 50);
+
+    Reset(&array);
+    CHECK(Empty(&array));
+    CHECK(array.capacity == 99);
+  }
+
+  SECTION("Arena array grows in place") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(4));
+
+    auto array = CreateArray<uint64_t>(&pool, 4);
+    CHECK(array.capacity == 4);
+    CHECK(Used(&pool) == 4 * sizeof(uint64_t));
+
+    for (uint64_t i = 0; i < 20; i++)
+      Push(&array, i);
+
+    // Nothing else was pushed into the pool, so the data never moved.
+    CHECK((uint8_t*)array.data == Data(&pool));
+    CHECK(Used(&pool) == array.capacity * sizeof(uint64_t));
+    for (uint32_t i = 0; i < array.size; i++)
+      CHECK(array[i] == i);
+  }
+
+  SECTION("Arena array relocates") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(4));
+
+    auto array = CreateArray<uint64_t>(&pool, 2);
+    Push(&array, (uint64_t)1);
+    Push(&array, (uint64_t)2);
+    Push<uint32_t>(&pool, 0xdead);   // Someone else uses the pool.
+
+    Push(&array, (uint64_t)3);
+    CHECK((uint8_t*)array.data != Data(&pool));
+    REQUIRE(array.size == 3);
+    CHECK(array[0] == 1);
+    CHECK(array[1] == 2);
+    CHECK(array[2] == 3);
+  }
+
+  SECTION("Move only values") {
+    Array<std::unique_ptr<int>> array;
+    for (int i = 0; i < 20; i++)
+      Push(&array, std::make_unique<int>(i));
+
+    Array<std::unique_ptr<int>> moved = std::move(array);
+    CHECK(array.data == nullptr);
+    CHECK(array.size == 0);
+    REQUIRE(moved.size == 20);
+    for (int i = 0; i < 20; i++)
+      CHECK(*moved[i] == i);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,129 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/memory/concurrent_arena.h>
+
+#include <third_party/catch2/catch.hpp>
+#include <warhol/containers/list.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+constexpr int kThreads = 4;
+
+struct Range {
+  uint8_t* start;
+  size_t size;
+};
+
+}  // namespace
+
+TEST_CASE("ConcurrentArena") {
+  ConcurrentArena arena;
+  REQUIRE(InitConcurrentArena(&arena, MEGABYTES(16), KILOBYTES(4)));
+
+  SECTION("Threads never get overlapping memory") {
+    std::vector<Range> ranges[kThreads];
+    std::atomic<bool> misaligned = false;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&arena, &ranges, &misaligned, t]() {
+        for (int i = 0; i < 5000; i++) {
+          // Mostly small, with some that skip the sub-blocks.
+          size_t size = i % 100 == 0 ? 2000 : 1 + (i % 64);
+          size_t alignment = (size_t)1 << (i % 5);
+          uint8_t* ptr = Reserve(&arena, size, alignment);
+          if ((uintptr_t)ptr % alignment != 0)
+            misaligned = true;
+          memset(ptr, t, size);
+          ranges[t].push_back({ptr, size});
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    CHECK(!misaligned);
+
+    std::vector<Range> all;
+    bool intact = true;
+    for (int t = 0; t < kThreads; t++) {
+      for (Range& range : ranges[t]) {
+        for (size_t i = 0; i < range.size; i++)
+          intact &= range.start[i] == t;
+        all.push_back(range);
+      }
+    }
+    CHECK(intact);
+
+    std::sort(all.begin(), all.end(), [](const Range& a, const Range& b) {
+      return a.start < b.start;
+    });
+    bool overlaps = false;
+    for (size_t i = 1; i < all.size(); i++)
+      overlaps |= all[i - 1].start + all[i - 1].size > all[i].start;
+    CHECK(!overlaps);
+    CHECK(Used(&arena) <= arena.size);
+  }
+
+  SECTION("Reset") {
+    uint8_t* first = Reserve(&arena, 16, 16);
+    Reserve(&arena, 16, 16);
+    CHECK(Used(&arena) > 0);
+
+    ResetConcurrentArena(&arena);
+    CHECK(Used(&arena) == 0);
+
+    // The thread's old sub-block is not reused after the reset.
+    CHECK(Reserve(&arena, 16, 16) == first);
+  }
+
+  SECTION("Many arenas in one thread") {
+    ConcurrentArena others[6];
+    for (auto& other : others)
+      REQUIRE(InitConcurrentArena(&other, MEGABYTES(1), KILOBYTES(4)));
+
+    for (int round = 0; round < 3; round++) {
+      for (auto& other : others)
+        *Push<int>(&other) = round;
+    }
+
+    for (auto& other : others)
+      CHECK(Used(&other) <= 3 * KILOBYTES(4));
+  }
+
+  SECTION("Lists filled in parallel") {
+    std::vector<List<int>> lists;
+    for (int t = 0; t < kThreads; t++)
+      lists.push_back(CreateList<int>(&arena));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&lists, t]() {
+        for (int i = 0; i < 1000; i++)
+          Push(&lists[t], t * 1000 + i);
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    bool intact = true;
+    for (int t = 0; t < kThreads; t++) {
+      CHECK(lists[t].count == 1000);
+      int i = 0;
+      for (int value : lists[t])
+        intact &= value == t * 1000 + i++;
+    }
+    CHECK(intact);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
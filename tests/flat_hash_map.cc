@@ -0,0 +1,142 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/containers/flat_hash_map.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+// Everything lands in the same place, so probing has to do all the work.
+struct ConstantHasher {
+  size_t operator()(uint32_t) const { return 42; }
+};
+
+}  // namespace
+
+TEST_CASE("FlatHashMap") {
+  SECTION("Insert, find and erase") {
+    FlatHashMap<uint64_t, std::string> map;
+    CHECK(Empty(&map));
+    CHECK(Find(&map, 1ull) == nullptr);
+    CHECK(!Erase(&map, 1ull));
+
+    Insert(&map, 1ull, std::string("one"));
+    Insert(&map, 2ull, std::string("two"));
+    CHECK(map.size == 2);
+    REQUIRE(Find(&map, 1ull));
+    CHECK(*Find(&map, 1ull) == "one");
+    CHECK(Contains(&map, 2ull));
+    CHECK(!Contains(&map, 3ull));
+
+    // Overwrites.
+    Insert(&map, 1ull, std::string("uno"));
+    CHECK(map.size == 2);
+    CHECK(*Find(&map, 1ull) == "uno");
+
+    CHECK(Erase(&map, 1ull));
+    CHECK(!Contains(&map, 1ull));
+    CHECK(map.size == 1);
+
+    *FindOrInsert(&map, 3ull) = "three";
+    CHECK(*FindOrInsert(&map, 3ull) == "three");
+    CHECK(map.size == 2);
+  }
+
+  SECTION("Grows and iterates") {
+    FlatHashMap<uint64_t, uint64_t> map;
+    for (uint64_t i = 1; i <= 1000; i++)
+      Insert(&map, i, i * i);
+
+    CHECK(map.size == 1000);
+    CHECK(map.capacity >= 1000);
+    for (uint64_t i = 1; i <= 1000; i++) {
+      uint64_t* value = Find(&map, i);
+      REQUIRE(value);
+      CHECK(*value == i * i);
+    }
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    for (auto& [key, value] : map) {
+      CHECK(value == key * key);
+      count++;
+      sum += key;
+    }
+    CHECK(count == 1000);
+    CHECK(sum == 1000 * 1001 / 2);
+
+    Clear(&map);
+    CHECK(Empty(&map));
+    CHECK(!Contains(&map, 10ull));
+    CHECK(map.begin() == map.end());
+  }
+
+  SECTION("Colliding hasher") {
+    FlatHashMap<uint32_t, uint32_t, ConstantHasher> map;
+    for (uint32_t i = 0; i < 100; i++)
+      Insert(&map, i, i + 1);
+    for (uint32_t i = 0; i < 100; i += 2)
+      CHECK(Erase(&map, i));
+
+    CHECK(map.size == 50);
+    for (uint32_t i = 0; i < 100; i++) {
+      uint32_t* value = Find(&map, i);
+      if (i % 2 == 0) {
+        CHECK(!value);
+      } else {
+        REQUIRE(value);
+        CHECK(*value == i + 1);
+      }
+    }
+  }
+
+  SECTION("Matches std::map under churn") {
+    FlatHashMap<uint32_t, uint32_t> map;
+    std::map<uint32_t, uint32_t> reference;
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 20000; i++) {
+      uint32_t key = rng() % 512;
+      if (rng() % 3 == 0) {
+        CHECK(Erase(&map, key) == (reference.erase(key) > 0));
+      } else {
+        Insert(&map, key, (uint32_t)i);
+        reference[key] = i;
+      }
+    }
+
+    REQUIRE(map.size == reference.size());
+    for (auto& [key, value] : reference) {
+      uint32_t* found = Find(&map, key);
+      REQUIRE(found);
+      CHECK(*found == value);
+    }
+    // Tombstones are cleaned up instead of piling up.
+    CHECK(map.size + map.tombstones <= map.capacity);
+  }
+
+  SECTION("Move only values and moving the map") {
+    FlatHashMap<uint32_t, std::unique_ptr<int>> map;
+    EnsureCapacity(&map, 100);
+    uint32_t capacity = map.capacity;
+    for (uint32_t i = 0; i < 100; i++)
+      Insert(&map, i, std::make_unique<int>((int)i));
+    CHECK(map.capacity == capacity);
+
+    auto moved = std::move(map);
+    CHECK(Empty(&map));
+    CHECK(moved.size == 100);
+    CHECK(**Find(&moved, 99u) == 99);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,60 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/memory/frame_allocator.h>
+
+#include <third_party/catch2/catch.hpp>
+#include <warhol/containers/list.h>
+
+#include <thread>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("FrameAllocator") {
+  SECTION("Arenas are double buffered") {
+    MemoryPool* first = GetFrameArena();
+    CHECK(GetFrameArena() == first);
+    int* value = Push<int>(first, 42);
+
+    // The next frame uses the other arena, so the previous one is untouched.
+    AdvanceFrameAllocators();
+    MemoryPool* second = GetFrameArena();
+    CHECK(second != first);
+    CHECK(*value == 42);
+    CHECK(Used(first) == sizeof(int));
+
+    // Two frames later the first arena comes back, reset.
+    AdvanceFrameAllocators();
+    CHECK(GetFrameArena() == first);
+    CHECK(Used(first) == 0);
+  }
+
+  SECTION("Every thread gets its own arenas") {
+    MemoryPool* main_arena = GetFrameArena();
+    MemoryPool* thread_arena = nullptr;
+    std::thread thread([&thread_arena]() { thread_arena = GetFrameArena(); });
+    thread.join();
+
+    CHECK(thread_arena != nullptr);
+    CHECK(thread_arena != main_arena);
+  }
+
+  SECTION("Frame lists") {
+    AdvanceFrameAllocators();
+    auto list = CreateFrameList<int>();
+    CHECK(list.arena == GetFrameArena());
+    CHECK(!Valid(&list.pool));
+
+    for (int i = 0; i < 10; i++)
+      Push(&list, i);
+
+    int i = 0;
+    for (int value : list)
+      CHECK(value == i++);
+    CHECK(Used(GetFrameArena()) >= 10 * sizeof(int));
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
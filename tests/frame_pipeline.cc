@@ -0,0 +1,101 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/graphics/common/frame_pipeline.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <thread>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+struct SimulationData {
+  std::thread::id thread_id;
+  std::atomic<uint64_t> simulated_frames = 0;
+};
+
+void Simulate(void* user_data, FramePipeline::Frame* frame) {
+  auto* data = (SimulationData*)user_data;
+  data->thread_id = std::this_thread::get_id();
+
+  // Leave something in the arena and the commands, to check that it's intact
+  // when the frame is rendered.
+  *Push<uint64_t>(&frame->arena) = frame->index;
+  RenderCommand* command = Push(&frame->commands);
+  command->type = RenderCommandType::kNoop;
+
+  data->simulated_frames++;
+}
+
+}  // namespace
+
+TEST_CASE("FramePipeline") {
+  JobSystem job_system;
+  REQUIRE(InitJobSystem(&job_system, 2));
+
+  SimulationData data;
+  FramePipelineConfig config;
+  config.arena_size = KILOBYTES(2);
+  config.job_system = &job_system;
+  config.simulate = Simulate;
+  config.user_data = &data;
+
+  SECTION("Serial") {
+    config.frames_in_flight = 1;
+    FramePipeline pipeline;
+    REQUIRE(InitFramePipeline(&pipeline, config));
+
+    for (uint64_t i = 0; i < 10; i++) {
+      auto* frame = AdvanceFramePipeline(&pipeline);
+      CHECK(frame->index == i);
+      CHECK(data.simulated_frames == i + 1);
+      CHECK(data.thread_id == std::this_thread::get_id());
+      CHECK(*(uint64_t*)Data(&frame->arena) == i);
+      CHECK(frame->commands.count == 1);
+      FinishFrame(&pipeline);
+    }
+  }
+
+  SECTION("Pipelined") {
+    config.frames_in_flight = 2;
+    FramePipeline pipeline;
+    REQUIRE(InitFramePipeline(&pipeline, config));
+
+    for (uint64_t i = 0; i < 10; i++) {
+      auto* frame = AdvanceFramePipeline(&pipeline);
+      CHECK(frame->index == i);
+
+      // The next frame gets simulated while we "render" this one.
+      while (data.simulated_frames < i + 2)
+        std::this_thread::yield();
+      CHECK(data.thread_id != std::this_thread::get_id());
+
+      CHECK(*(uint64_t*)Data(&frame->arena) == i);
+      CHECK(frame->commands.count == 1);
+      FinishFrame(&pipeline);
+    }
+  }
+
+  SECTION("Changing frames in flight") {
+    config.frames_in_flight = 2;
+    FramePipeline pipeline;
+    REQUIRE(InitFramePipeline(&pipeline, config));
+
+    uint64_t expected = 0;
+    for (uint32_t frames_in_flight : {2, 1, 2, 1}) {
+      SetFramesInFlight(&pipeline, frames_in_flight);
+      for (int i = 0; i < 3; i++) {
+        auto* frame = AdvanceFramePipeline(&pipeline);
+        CHECK(frame->index == expected++);
+        CHECK(*(uint64_t*)Data(&frame->arena) == frame->index);
+        FinishFrame(&pipeline);
+      }
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
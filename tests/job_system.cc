@@ -0,0 +1,351 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/job_system.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include <warhol/platform/platform.h>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+void IncrementJob(void* user_data) {
+  auto* counter = (std::atomic<int>*)user_data;
+  (*counter)++;
+}
+
+struct SpawnData {
+  JobSystem* job_system;
+  std::atomic<int>* counter;
+};
+
+// Pushes more jobs from within a worker.
+void SpawnJob(void* user_data) {
+  auto* data = (SpawnData*)user_data;
+  for (int i = 0; i < 10; i++)
+    PushJob(data->job_system, {IncrementJob, data->counter});
+}
+
+struct OrderData {
+  std::atomic<int>* counter;
+  int seen = -1;   // What |counter| was when the job ran.
+};
+
+void RecordOrderJob(void* user_data) {
+  auto* data = (OrderData*)user_data;
+  data->seen = data->counter->load();
+}
+
+void DeleteCounterJob(void* user_data) {
+  delete (JobCounter*)user_data;
+}
+
+struct PriorityData {
+  std::atomic<int>* next_order;
+  int order = -1;
+};
+
+void RecordPriorityJob(void* user_data) {
+  auto* data = (PriorityData*)user_data;
+  data->order = (*data->next_order)++;
+}
+
+void BlockJob(void* user_data) {
+  auto* release = (std::atomic<bool>*)user_data;
+  while (!release->load())
+    std::this_thread::yield();
+}
+
+struct BackgroundData {
+  JobSystem* job_system;
+  std::atomic<int> running = 0;
+  std::atomic<int> max_running = 0;
+  std::atomic<bool> ran_on_worker_zero = false;
+  std::atomic<bool> wrong_priority = false;
+};
+
+void BackgroundJob(void* user_data) {
+  auto* data = (BackgroundData*)user_data;
+  if (GetCurrentWorkerIndex(data->job_system) == 0)
+    data->ran_on_worker_zero = true;
+  if (GetCurrentJobPriority() != JobPriority::kBackground)
+    data->wrong_priority = true;
+
+  int running = ++data->running;
+  int max_running = data->max_running.load();
+  while (running > max_running &&
+         !data->max_running.compare_exchange_weak(max_running, running)) {}
+
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+  data->running--;
+}
+
+void TimestampJob(void* user_data) {
+  *(uint64_t*)user_data = GetNanoseconds();
+}
+
+Job MakeJob(Job::JobFunc func, void* user_data, JobPriority priority) {
+  Job job = {func, user_data};
+  job.priority = priority;
+  return job;
+}
+
+void WaitForJobs(JobSystem* job_system) {
+  while (!AllJobsCompleted(job_system))
+    RunPendingJobs(job_system);
+}
+
+}  // namespace
+
+TEST_CASE("WorkStealingDeque") {
+  auto deque = std::make_unique<WorkStealingDeque<Job, 4>>();
+
+  int values[5] = {};
+  for (int i = 0; i < 4; i++)
+    REQUIRE(Push(deque.get(), {IncrementJob, values + i}));
+
+  // Full deques do not overwrite.
+  CHECK(!Push(deque.get(), {IncrementJob, values + 4}));
+  CHECK(Size(deque.get()) == 4);
+
+  // The owner pops LIFO, thieves steal FIFO.
+  Job job;
+  REQUIRE(Pop(deque.get(), &job));
+  CHECK(job.user_data == values + 3);
+  REQUIRE(Steal(deque.get(), &job));
+  CHECK(job.user_data == values + 0);
+
+  REQUIRE(Pop(deque.get(), &job));
+  REQUIRE(Pop(deque.get(), &job));
+  CHECK(job.user_data == values + 1);
+  CHECK(!Pop(deque.get(), &job));
+  CHECK(!Steal(deque.get(), &job));
+  CHECK(Empty(deque.get()));
+}
+
+TEST_CASE("JobSystem") {
+  SECTION("Jobs from the main thread") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    std::atomic<int> counter = 0;
+    for (int i = 0; i < 1000; i++)
+      PushJob(&job_system, {IncrementJob, &counter});
+
+    WaitForJobs(&job_system);
+    CHECK(counter == 1000);
+  }
+
+  SECTION("Batched jobs") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    std::atomic<int> counter = 0;
+    std::vector<Job> jobs(1000, {IncrementJob, &counter});
+
+    JobCounter job_counter;
+    PushJobs(&job_system, jobs.data(), (uint32_t)jobs.size(), &job_counter);
+    WaitForCounter(&job_system, &job_counter);
+    CHECK(counter == 1000);
+  }
+
+  SECTION("Back-pressure instead of overwrite") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 2));
+
+    std::atomic<int> counter = 0;
+    int count = 3 * JobSystem::kDequeCapacity;
+    for (int i = 0; i < count; i++)
+      PushJob(&job_system, {IncrementJob, &counter});
+
+    WaitForJobs(&job_system);
+    CHECK(counter == count);
+  }
+
+  SECTION("Jobs from outside threads and from workers") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    std::atomic<int> counter = 0;
+    SpawnData spawn_data = {&job_system, &counter};
+
+    // Catch is not thread safe, so we check outside.
+    std::atomic<bool> outside_threads = true;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.push_back(std::thread([&]() {
+        if (GetCurrentWorkerIndex(&job_system) != -1)
+          outside_threads = false;
+        for (int i = 0; i < 100; i++)
+          PushJob(&job_system, {SpawnJob, &spawn_data});
+      }));
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    WaitForJobs(&job_system);
+    CHECK(outside_threads);
+    CHECK(counter == 4 * 100 * 10);
+  }
+
+  SECTION("Wait for a counter") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    std::atomic<int> counter = 0;
+    std::atomic<int> other_counter = 0;
+
+    JobCounter job_counter;
+    for (int i = 0; i < 500; i++) {
+      PushJob(&job_system, {IncrementJob, &counter}, &job_counter);
+      // Jobs not associated with the counter.
+      PushJob(&job_system, {IncrementJob, &other_counter});
+    }
+
+    WaitForCounter(&job_system, &job_counter);
+    CHECK(Done(&job_counter));
+    CHECK(counter == 500);
+
+    // Counters can be reused.
+    for (int i = 0; i < 500; i++)
+      PushJob(&job_system, {IncrementJob, &counter}, &job_counter);
+    WaitForCounter(&job_system, &job_counter);
+    CHECK(counter == 1000);
+
+    WaitForJobs(&job_system);
+    CHECK(other_counter == 500);
+  }
+
+  SECTION("Dependent jobs") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    std::atomic<int> counter = 0;
+    JobCounter first;
+    for (int i = 0; i < 100; i++)
+      PushJob(&job_system, {IncrementJob, &counter}, &first);
+
+    // More dependents than the counter can hold.
+    constexpr int kDependentCount = 2 * JobCounter::kMaxDependents;
+    OrderData order_data[kDependentCount];
+    JobCounter second;
+    for (auto& data : order_data) {
+      data.counter = &counter;
+      PushJobAfter(&job_system, &first, {RecordOrderJob, &data}, &second);
+    }
+
+    WaitForCounter(&job_system, &second);
+    CHECK(Done(&first));
+    for (auto& data : order_data)
+      CHECK(data.seen == 100);
+  }
+
+  SECTION("Dependents run after the counter is released") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    // The dependent destroys the counter it waited on, which is only safe if
+    // the finishing thread is done with it (the counter asserts otherwise).
+    std::atomic<int> counter = 0;
+    for (int i = 0; i < 1000; i++) {
+      auto* dependency = new JobCounter();
+      PushJob(&job_system, {IncrementJob, &counter}, dependency);
+
+      JobCounter done;
+      PushJobAfter(&job_system, dependency, {DeleteCounterJob, dependency},
+                   &done);
+      WaitForCounter(&job_system, &done);
+    }
+    CHECK(counter == 1000);
+  }
+
+  SECTION("Higher priorities go first") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 1));
+
+    // Keep the only worker busy while we fill the lanes.
+    std::atomic<bool> release = false;
+    PushJob(&job_system, {BlockJob, &release});
+
+    std::atomic<int> next_order = 0;
+    constexpr int kJobsPerLane = 10;
+    PriorityData data[kJobPriorityCount][kJobsPerLane];
+    for (int i = 0; i < kJobsPerLane; i++) {
+      // Lowest priority first, so FIFO order alone would get it wrong.
+      for (int lane = kJobPriorityCount - 1; lane >= 0; lane--) {
+        data[lane][i].next_order = &next_order;
+        PushJob(&job_system, MakeJob(RecordPriorityJob, &data[lane][i],
+                                     (JobPriority)lane));
+      }
+    }
+
+    // Only the worker runs jobs, so they're done strictly in lane order.
+    release = true;
+    while (!AllJobsCompleted(&job_system))
+      std::this_thread::yield();
+
+    for (uint32_t lane = 0; lane < kJobPriorityCount; lane++) {
+      for (int i = 0; i < kJobsPerLane; i++) {
+        CHECK(data[lane][i].order >= (int)lane * kJobsPerLane);
+        CHECK(data[lane][i].order < (int)(lane + 1) * kJobsPerLane);
+      }
+    }
+  }
+
+  SECTION("Background jobs only use idle workers") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 4));
+
+    BackgroundData data;
+    data.job_system = &job_system;
+
+    JobCounter counter;
+    for (int i = 0; i < 50; i++) {
+      PushJob(&job_system, MakeJob(BackgroundJob, &data,
+                                   JobPriority::kBackground), &counter);
+    }
+    WaitForCounter(&job_system, &counter);
+
+    CHECK(!data.ran_on_worker_zero);
+    CHECK(!data.wrong_priority);
+    CHECK(data.max_running <= (int)job_system.max_background_workers);
+    CHECK(job_system.background_workers == 0);
+  }
+
+  SECTION("No background jobs near the frame deadline") {
+    JobSystem job_system;
+    REQUIRE(InitJobSystem(&job_system, 2));
+
+    uint64_t deadline = GetNanoseconds() + 1000 * 1000;
+    SetFrameDeadline(&job_system, deadline);
+
+    uint64_t ran_at = 0;
+    JobCounter counter;
+    PushJob(&job_system, MakeJob(TimestampJob, &ran_at,
+                                 JobPriority::kBackground), &counter);
+    WaitForCounter(&job_system, &counter);
+    CHECK(ran_at >= deadline);
+  }
+
+  SECTION("Shutdown runs pending jobs") {
+    std::atomic<int> counter = 0;
+    {
+      JobSystem job_system;
+      REQUIRE(InitJobSystem(&job_system, 1));
+      for (int i = 0; i < 100; i++)
+        PushJob(&job_system, {IncrementJob, &counter});
+    }
+    CHECK(counter == 100);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -9,6 +9,24 @@
 namespace warhol {
 namespace test{
 
+namespace {
+
+std::vector<uint32_t> ToVector(List<uint32_t>* list) {
+  std::vector<uint32_t> result;
+  for (uint32_t value : *list)
+    result.push_back(value);
+  return result;
+}
+
+std::vector<uint32_t> Range(uint32_t from, uint32_t to) {
+  std::vector<uint32_t> result;
+  for (uint32_t i = from; i < to; i++)
+    result.push_back(i);
+  return result;
+}
+
+}  // namespace
+
 TEST_CASE("List") {
   SECTION("PushIntoListFromMemoryPool Without Value") {
     MemoryPool pool;
@@ -50,6 +68,132 @@ TEST_CASE("List") {
 
     CHECK(list.count == 5);
   }
+
+  SECTION("Chunks fit in whole cache lines") {
+    // Header and elements together.
+    CHECK(sizeof(List<uint32_t>::Chunk) == 64);
+    CHECK(List<uint32_t>::kChunkCapacity == 13);
+    CHECK(sizeof(List<uint64_t>::Chunk) == 128);
+    CHECK(List<uint64_t>::kChunkCapacity == 14);
+  }
+
+  SECTION("Spans several chunks") {
+    auto list = CreateList<uint32_t>(KILOBYTES(4));
+    uint32_t count = 3 * List<uint32_t>::kChunkCapacity + 1;
+    for (uint32_t i = 0; i < count; i++)
+      Push(&list, i);
+
+    CHECK(list.count == count);
+    CHECK(list.head != list.tail);
+    CHECK(list.tail->count == 1);
+    CHECK(ToVector(&list) == Range(0, count));
+  }
+
+  SECTION("Join") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(4));
+
+    auto list = CreateList<uint32_t>(&pool);
+    auto other = CreateList<uint32_t>(&pool);
+    for (uint32_t i = 0; i < 20; i++)
+      Push(&list, i);
+    for (uint32_t i = 20; i < 50; i++)
+      Push(&other, i);
+
+    Join(&list, &other);
+    CHECK(Empty(&other));
+    CHECK(list.count == 50);
+    CHECK(ToVector(&list) == Range(0, 50));
+
+    // Still possible to keep pushing.
+    Push(&list, 50u);
+    CHECK(ToVector(&list) == Range(0, 51));
+
+    // Into an empty list.
+    auto empty = CreateList<uint32_t>(&pool);
+    Join(&empty, &list);
+    CHECK(ToVector(&empty) == Range(0, 51));
+  }
+
+  SECTION("Splice") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(4));
+
+    auto MakeList = [&pool](uint32_t from, uint32_t to) {
+      auto list = CreateList<uint32_t>(&pool);
+      for (uint32_t i = from; i < to; i++)
+        Push(&list, i);
+      return list;
+    };
+
+    // At the front.
+    auto list = MakeList(10, 20);
+    auto front = MakeList(0, 10);
+    Splice(&list, list.begin(), &front);
+    CHECK(Empty(&front));
+    CHECK(ToVector(&list) == Range(0, 20));
+
+    // At the start of a chunk that is not the head.
+    list = MakeList(0, 5);
+    auto tail = MakeList(10, 15);
+    Join(&list, &tail);
+    auto middle = MakeList(5, 10);
+    auto it = list.begin();
+    for (int i = 0; i < 5; i++)
+      it++;
+    CHECK(*it == 10);
+    Splice(&list, it, &middle);
+    CHECK(list.count == 15);
+    CHECK(ToVector(&list) == Range(0, 15));
+
+    // Inside a partly filled chunk: the values from the splice point on move
+    // to a new chunk after the spliced ones.
+    {
+      auto split = MakeList(0, 5);
+      for (uint32_t i = 10; i < 16; i++)
+        Push(&split, i);
+      REQUIRE(split.head == split.tail);
+      auto* chunk = split.head;
+
+      auto inserted = MakeList(5, 10);
+      auto pos = split.begin();
+      for (int i = 0; i < 5; i++)
+        pos++;
+      REQUIRE(pos.chunk == chunk);
+      REQUIRE(pos.index == 5);
+      Splice(&split, pos, &inserted);
+
+      CHECK(Empty(&inserted));
+      CHECK(split.count == 16);
+      CHECK(ToVector(&split) == Range(0, 16));
+
+      // The chunk kept its front and its tail went to a new last chunk.
+      CHECK(split.head == chunk);
+      CHECK(chunk->count == 5);
+      CHECK(split.tail != chunk);
+      CHECK(split.tail->count == 6);
+      CHECK(split.tail->values()[0] == 10);
+      CHECK(split.tail->next == nullptr);
+
+      // Pushing keeps going after the moved tail.
+      Push(&split, 16u);
+      CHECK(ToVector(&split) == Range(0, 17));
+    }
+
+    // Before the very first element again, now that the head chunk is split.
+    auto more = MakeList(100, 102);
+    Splice(&list, list.begin(), &more);
+    CHECK(*list.begin() == 100);
+    CHECK(list.count == 17);
+
+    // At the end.
+    auto end = MakeList(15, 18);
+    list = MakeList(0, 15);
+    Splice(&list, list.end(), &end);
+    CHECK(ToVector(&list) == Range(0, 18));
+    Push(&list, 18u);
+    CHECK(ToVector(&list) == Range(0, 19));
+  }
 }
 
 }  // namespace test
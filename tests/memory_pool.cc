@@ -58,6 +58,91 @@ TEST_CASE("MemoryPool") {
 
     }
   }
+
+  SECTION("Alignment") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(1));
+
+    struct alignas(16) Vec4 {
+      float x, y, z, w;
+    };
+
+    Push<uint8_t>(&pool);
+    Vec4* vec = Push<Vec4>(&pool);
+    CHECK((uintptr_t)vec % 16 == 0);
+    CHECK(Used(&pool) >= sizeof(Vec4) + 1);
+
+    uint8_t odd[3] = {1, 2, 3};
+    for (size_t alignment : {1, 2, 4, 8, 16, 32, 64}) {
+      Push(&pool, odd, sizeof(odd));
+      uint8_t* ptr = Reserve(&pool, 8, alignment);
+      CHECK((uintptr_t)ptr % alignment == 0);
+
+      uint8_t* pushed = Push(&pool, odd, sizeof(odd), alignment);
+      CHECK((uintptr_t)pushed % alignment == 0);
+      CHECK(pushed[2] == 3);
+    }
+  }
+
+  SECTION("Markers") {
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(1));
+
+    int* first = Push<int>(&pool, 1);
+    PoolMarker marker = GetMarker(&pool);
+    Push<int>(&pool, 2);
+    Push<int>(&pool, 3);
+    CHECK(Used(&pool) == 3 * sizeof(int));
+
+    RollbackToMarker(&pool, marker);
+    CHECK(Used(&pool) == sizeof(int));
+    CHECK(*first == 1);
+
+    {
+      ScopedPoolMarker scoped_marker(&pool);
+      Reserve(&pool, 100, 64);
+      CHECK(Used(&pool) > 100);
+    }
+    CHECK(Used(&pool) == sizeof(int));
+  }
+
+  SECTION("Virtual pool") {
+    MemoryPool pool;
+    REQUIRE(InitVirtualMemoryPool(&pool, MEGABYTES(64)));
+    CHECK(pool.is_virtual);
+    CHECK(pool.size == MEGABYTES(64));
+    CHECK(pool.committed == 0);
+
+    // Grows over several commit granules without moving.
+    constexpr size_t kCount = 3 * MemoryPool::kCommitGranularity / sizeof(int);
+    int* first = Push<int>(&pool, 0);
+    for (size_t i = 1; i < kCount; i++)
+      Push<int>(&pool, (int)i);
+    CHECK(Used(&pool) == kCount * sizeof(int));
+    CHECK(pool.committed == 3 * MemoryPool::kCommitGranularity);
+    CHECK((int*)pool.data.get() == first);
+
+    bool intact = true;
+    for (size_t i = 0; i < kCount; i++)
+      intact &= first[i] == (int)i;
+    CHECK(intact);
+
+    // The first reset keeps what was used, the second one gives it back.
+    ResetMemoryPool(&pool);
+    CHECK(pool.committed == 3 * MemoryPool::kCommitGranularity);
+    Push<int>(&pool, 1);
+    ResetMemoryPool(&pool);
+    CHECK(pool.committed == MemoryPool::kCommitGranularity);
+    ResetMemoryPool(&pool);
+    CHECK(pool.committed == 0);
+
+    // Recommitted memory reads as zero, like committed pools.
+    uint8_t* bytes = Reserve(&pool, 2 * MemoryPool::kCommitGranularity);
+    bool zeroed = true;
+    for (size_t i = 0; i < 2 * MemoryPool::kCommitGranularity; i++)
+      zeroed &= bytes[i] == 0;
+    CHECK(zeroed);
+  }
 }
 
 }  // namespace test
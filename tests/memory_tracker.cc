@@ -0,0 +1,155 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/memory/memory_tracker.h>
+
+#include <third_party/catch2/catch.hpp>
+#include <warhol/memory/memory_pool.h>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+const TrackedStats* FindStats(const std::vector<TrackedStats>& stats,
+                              uint32_t id) {
+  for (const TrackedStats& entry : stats) {
+    if (entry.id == id)
+      return &entry;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_CASE("MemoryTracker") {
+  SECTION("Tracking and untracking") {
+    size_t tracked = GetTrackedStats().size();
+    {
+      MemoryPool pool;
+      pool.name = "Tracked";
+      InitMemoryPool(&pool, KILOBYTES(1));
+      Track(&pool);
+      REQUIRE(Valid(&pool.track_token));
+
+      auto stats = GetTrackedStats();
+      CHECK(stats.size() == tracked + 1);
+      const TrackedStats* entry = FindStats(stats, pool.track_token.id);
+      REQUIRE(entry);
+      CHECK(entry->type == TrackType::kMemoryPool);
+      CHECK(entry->reserved == KILOBYTES(1));
+    }
+    CHECK(GetTrackedStats().size() == tracked);
+  }
+
+  SECTION("Replacing or shutting down a tracked pool untracks it") {
+    size_t tracked = GetTrackedStats().size();
+
+    MemoryPool pool;
+    InitMemoryPool(&pool, KILOBYTES(1));
+    Track(&pool);
+    CHECK(GetTrackedStats().size() == tracked + 1);
+
+    // What a `mesh = {}` does to the mesh's pools.
+    pool = {};
+    CHECK(!Valid(&pool.track_token));
+    CHECK(GetTrackedStats().size() == tracked);
+
+    InitMemoryPool(&pool, KILOBYTES(1));
+    Track(&pool);
+    CHECK(GetTrackedStats().size() == tracked + 1);
+    ShutdownMemoryPool(&pool);
+    CHECK(!Valid(&pool.track_token));
+    CHECK(GetTrackedStats().size() == tracked);
+  }
+
+  SECTION("Pool stats") {
+    MemoryPool pool;
+    pool.name = "Stats";
+    InitMemoryPool(&pool, KILOBYTES(1));
+    Track(&pool);
+    uint32_t id = pool.track_token.id;
+
+    // Frame 1: three allocations, almost full.
+    MemoryTrackerNewFrame();
+    Reserve(&pool, 100);
+    Reserve(&pool, 100);
+    Reserve(&pool, 800);
+    MemoryTrackerNewFrame();
+    ResetMemoryPool(&pool);
+
+    // Frame 2: one small allocation.
+    Reserve(&pool, 10);
+    MemoryTrackerNewFrame();
+
+    auto stats = GetTrackedStats();
+    const TrackedStats* entry = FindStats(stats, id);
+    REQUIRE(entry);
+    CHECK(entry->used == 10);
+    CHECK(entry->peak_used == 1000);
+    CHECK(entry->total_allocations == 4);
+    CHECK(entry->allocations_last_frame == 1);
+    CHECK(entry->near_misses == 1);
+
+    TrackedStats totals = GetTrackedTotals(stats);
+    CHECK(totals.reserved >= KILOBYTES(1));
+    CHECK(totals.used >= 10);
+  }
+
+  SECTION("CSV") {
+    MemoryPool pool;
+    pool.name = "CSV Pool";
+    InitMemoryPool(&pool, KILOBYTES(2));
+    Track(&pool);
+    Reserve(&pool, 64);
+
+    std::string csv = MemoryTrackerToCSV(GetTrackedStats());
+    CHECK(csv.find("id,type,name,reserved") == 0);
+    CHECK(csv.find("MemoryPool,CSV Pool,2048,2048,64,64,") != std::string::npos);
+  }
+}
+
+TEST_CASE("Heap allocation tags") {
+  SECTION("Scoping") {
+    CHECK(GetCurrentAllocationTag() == AllocationTag::kUntagged);
+    {
+      SCOPED_ALLOCATION_TAG(kRenderer);
+      CHECK(GetCurrentAllocationTag() == AllocationTag::kRenderer);
+      {
+        SCOPED_ALLOCATION_TAG(kMeshes);
+        CHECK(GetCurrentAllocationTag() == AllocationTag::kMeshes);
+      }
+      CHECK(GetCurrentAllocationTag() == AllocationTag::kRenderer);
+    }
+    CHECK(GetCurrentAllocationTag() == AllocationTag::kUntagged);
+  }
+
+  SECTION("Per frame counters") {
+    // The counters are global (and see the real heap with the hooks on), so
+    // only look at what changes.
+    MemoryTrackerNewFrame();
+    HeapStats start = GetHeapTotalStats(AllocationTag::kTextures);
+
+    RecordHeapAllocation(100, AllocationTag::kTextures);
+    RecordHeapAllocation(28, AllocationTag::kTextures);
+    RecordHeapFree(100, AllocationTag::kTextures);
+    MemoryTrackerNewFrame();
+
+    HeapStats frame = GetHeapFrameStats(AllocationTag::kTextures);
+    CHECK(frame.allocations >= 2);
+    CHECK(frame.frees >= 1);
+    CHECK(frame.allocated_bytes >= 128);
+
+    HeapStats total = GetHeapTotalStats(AllocationTag::kTextures);
+    CHECK(total.allocations - start.allocations >= 2);
+    CHECK(total.freed_bytes - start.freed_bytes >= 100);
+
+    // Nothing happens in this frame.
+    MemoryTrackerNewFrame();
+    if (!HeapTrackingEnabled())
+      CHECK(GetHeapFrameStats(AllocationTag::kTextures).allocations == 0);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,84 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/mpmc_queue.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("MPMCQueue") {
+  SECTION("FIFO and full") {
+    auto queue = std::make_unique<MPMCQueue<int, 4>>();
+
+    for (int i = 0; i < 4; i++)
+      REQUIRE(TryPush(queue.get(), i));
+    CHECK(!TryPush(queue.get(), 4));
+    CHECK(Size(queue.get()) == 4);
+
+    int value = -1;
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(TryPop(queue.get(), &value));
+      CHECK(value == i);
+    }
+    CHECK(!TryPop(queue.get(), &value));
+    CHECK(Empty(queue.get()));
+
+    // Wraps around.
+    for (int lap = 0; lap < 10; lap++) {
+      REQUIRE(TryPush(queue.get(), lap));
+      REQUIRE(TryPop(queue.get(), &value));
+      CHECK(value == lap);
+    }
+  }
+
+  SECTION("Multiple producers and consumers") {
+    constexpr int kThreadCount = 4;
+    constexpr uint64_t kItemsPerThread = 20000;
+
+    auto queue = std::make_unique<MPMCQueue<uint64_t, 256>>();
+    std::atomic<uint64_t> popped_count = 0;
+    std::atomic<uint64_t> popped_sum = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; t++) {
+      threads.push_back(std::thread([&, t]() {
+        for (uint64_t i = 0; i < kItemsPerThread; i++) {
+          uint64_t value = t * kItemsPerThread + i + 1;
+          while (!TryPush(queue.get(), value))
+            std::this_thread::yield();
+        }
+      }));
+    }
+
+    for (int t = 0; t < kThreadCount; t++) {
+      threads.push_back(std::thread([&]() {
+        uint64_t value;
+        while (popped_count.load() < kThreadCount * kItemsPerThread) {
+          if (TryPop(queue.get(), &value)) {
+            popped_sum += value;
+            popped_count++;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      }));
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    // Every value was seen exactly once.
+    uint64_t total = kThreadCount * kItemsPerThread;
+    CHECK(popped_count == total);
+    CHECK(popped_sum == total * (total + 1) / 2);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,68 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/parallel_for.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("ParallelFor") {
+  JobSystem job_system;
+  REQUIRE(InitJobSystem(&job_system, 4));
+
+  SECTION("Every item is visited once") {
+    std::vector<std::atomic<int>> visits(100000);
+    for (size_t grain : {0, 1, 7, 1000, 1000000}) {
+      for (auto& visit : visits)
+        visit = 0;
+
+      ParallelFor(&job_system, visits.size(), [&visits](size_t i) {
+        visits[i]++;
+      }, grain);
+
+      bool all_once = true;
+      for (auto& visit : visits)
+        all_once &= visit == 1;
+      CHECK(all_once);
+    }
+  }
+
+  SECTION("Empty range") {
+    int calls = 0;
+    ParallelFor(&job_system, 0, [&calls](size_t) { calls++; });
+    CHECK(calls == 0);
+  }
+
+  SECTION("Reduce") {
+    size_t count = 100000;
+    uint64_t sum = ParallelReduce(&job_system, count, (uint64_t)0,
+        [](size_t i) { return (uint64_t)i; },
+        [](uint64_t a, uint64_t b) { return a + b; });
+    CHECK(sum == (uint64_t)count * (count - 1) / 2);
+  }
+
+  SECTION("Reduce keeps the order") {
+    // String concatenation is associative but not commutative.
+    std::string result = ParallelReduce(&job_system, 26, std::string(),
+        [](size_t i) { return std::string(1, (char)('a' + i)); },
+        [](std::string a, std::string b) { return a + b; }, 2);
+    CHECK(result == "abcdefghijklmnopqrstuvwxyz");
+  }
+
+  SECTION("Grain calculation") {
+    // 1000 items that took 1 ms (1 us each) means a 50 us chunk has 50 items.
+    CHECK(CalculateGrain(1000 * 1000, 1000) == 50);
+    // Very expensive items still get a grain of one.
+    CHECK(CalculateGrain(1000 * 1000 * 1000, 1) == 1);
+    // Items too cheap to measure.
+    CHECK(CalculateGrain(0, 10) == kParallelForTargetChunkNs);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
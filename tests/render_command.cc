@@ -6,6 +6,8 @@
 #include <third_party/catch2/catch.hpp>
 #include <warhol/utils/log.h>
 
+#include <vector>
+
 namespace warhol {
 namespace test {
 
@@ -54,6 +56,103 @@ TEST_CASE("IndexRange") {
   }
 }
 
+namespace {
+
+MeshRenderAction CreateAction(uint32_t mesh_index, float depth = 0.0f) {
+  MeshRenderAction action;
+  action.mesh.index = mesh_index;
+  action.mesh.generation = 1;
+  action.depth = depth;
+  return action;
+}
+
+RenderCommand CreateCommand(uint32_t shader_index) {
+  RenderCommand command;
+  command.type = RenderCommandType::kMesh;
+  command.shader.index = shader_index;
+  command.shader.generation = 1;
+  return command;
+}
+
+}  // namespace
+
+TEST_CASE("Sort keys") {
+  SECTION("Layers go first") {
+    RenderCommand background = CreateCommand(9);
+    background.layer = kBackgroundRenderLayer;
+    RenderCommand ui = CreateCommand(0);
+    ui.layer = kUIRenderLayer;
+    MeshRenderAction action = CreateAction(0);
+
+    CHECK(GetSortKey(&background, &action) < GetSortKey(&ui, &action));
+  }
+
+  SECTION("Opaque draws group by state and go near to far") {
+    RenderCommand command = CreateCommand(1);
+    RenderCommand other_shader = CreateCommand(2);
+    MeshRenderAction near = CreateAction(5, 1.0f);
+    MeshRenderAction far = CreateAction(5, 100.0f);
+    MeshRenderAction other_mesh = CreateAction(6, 0.5f);
+
+    CHECK(GetSortKey(&command, &near) < GetSortKey(&command, &far));
+    CHECK(GetSortKey(&command, &far) < GetSortKey(&command, &other_mesh));
+    CHECK(GetSortKey(&command, &other_mesh) <
+          GetSortKey(&other_shader, &near));
+  }
+
+  SECTION("Translucent draws go after opaque ones and far to near") {
+    RenderCommand opaque = CreateCommand(1);
+    RenderCommand translucent = CreateCommand(0);
+    translucent.config.blend_enabled = true;
+    MeshRenderAction near = CreateAction(0, 1.0f);
+    MeshRenderAction far = CreateAction(0, 100.0f);
+
+    CHECK(GetSortKey(&opaque, &far) < GetSortKey(&translucent, &far));
+    CHECK(GetSortKey(&translucent, &far) < GetSortKey(&translucent, &near));
+  }
+
+  SECTION("SortDraws") {
+    List<RenderCommand> commands = CreateFrameList<RenderCommand>();
+
+    RenderCommand* ui = Push(&commands, CreateCommand(0));
+    ui->layer = kUIRenderLayer;
+    ui->preserve_order = true;
+    ui->mesh_actions = CreateFrameArray<MeshRenderAction>();
+    for (uint32_t i = 0; i < 4; i++)
+      Push(&ui->mesh_actions, CreateAction(4 - i));
+
+    RenderCommand* first = Push(&commands, CreateCommand(2));
+    first->mesh_actions = CreateFrameArray<MeshRenderAction>();
+    Push(&first->mesh_actions, CreateAction(1));
+
+    RenderCommand* second = Push(&commands, CreateCommand(1));
+    second->mesh_actions = CreateFrameArray<MeshRenderAction>();
+    Push(&second->mesh_actions, CreateAction(3));
+    Push(&second->mesh_actions, CreateAction(2));
+
+    RenderCommand* noop = Push(&commands, CreateCommand(0));
+    noop->type = RenderCommandType::kNoop;
+
+    Array<RenderDraw> draws = SortDraws(&commands);
+    REQUIRE(draws.size == 7);
+
+    // Shader 1 before shader 2, and its meshes in order.
+    CHECK(draws[0].command == second);
+    CHECK(draws[0].action->mesh.index == 2);
+    CHECK(draws[1].command == second);
+    CHECK(draws[1].action->mesh.index == 3);
+    CHECK(draws[2].command == first);
+
+    // The UI layer goes last, in submission order.
+    std::vector<uint32_t> ui_meshes;
+    for (uint32_t i = 3; i < draws.size; i++) {
+      CHECK(draws[i].command == ui);
+      ui_meshes.push_back(draws[i].action->mesh.index);
+    }
+    CHECK(ui_meshes == std::vector<uint32_t>{4, 3, 2, 1});
+  }
+}
+
 }  // namespace test
 }  // namespace warhol
 
@@ -0,0 +1,129 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/semaphore.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("Semaphore") {
+  SECTION("Notifications are kept") {
+    Semaphore semaphore;
+    CHECK(!semaphore.TryWait());
+
+    semaphore.Notify(3);
+    CHECK(semaphore.TryWait());
+    semaphore.Wait();
+    CHECK(semaphore.TryWait());
+    CHECK(!semaphore.TryWait());
+  }
+
+  SECTION("Batched notify wakes waiting threads") {
+    constexpr int kThreadCount = 8;
+    constexpr int kRounds = 100;
+
+    Semaphore semaphore;
+    std::atomic<int> woken = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; t++) {
+      threads.push_back(std::thread([&]() {
+        for (int i = 0; i < kRounds; i++) {
+          semaphore.Wait();
+          woken++;
+        }
+      }));
+    }
+
+    for (int i = 0; i < kRounds; i++)
+      semaphore.Notify(kThreadCount);
+
+    for (auto& thread : threads)
+      thread.join();
+    CHECK(woken == kThreadCount * kRounds);
+    CHECK(!semaphore.TryWait());
+  }
+
+  SECTION("Ping pong") {
+    Semaphore ping;
+    Semaphore pong;
+    int value = 0;
+
+    std::thread thread([&]() {
+      for (int i = 0; i < 1000; i++) {
+        ping.Wait();
+        value++;
+        pong.Notify();
+      }
+    });
+
+    for (int i = 0; i < 1000; i++) {
+      ping.Notify();
+      pong.Wait();
+    }
+    thread.join();
+    CHECK(value == 1000);
+  }
+}
+
+TEST_CASE("Event") {
+  SECTION("Auto reset") {
+    Event event(Event::Type::kAutoReset);
+    CHECK(!event.IsSignaled());
+
+    // Signaling with nobody waiting leaves it signaled, only once.
+    event.Signal();
+    event.Signal();
+    CHECK(event.IsSignaled());
+    event.Wait();
+    CHECK(!event.IsSignaled());
+
+    std::atomic<int> woken = 0;
+    std::thread thread([&]() {
+      for (int i = 0; i < 1000; i++) {
+        event.Wait();
+        woken++;
+      }
+    });
+
+    // Every wait consumes exactly one signal.
+    while (woken < 1000) {
+      event.Signal();
+      std::this_thread::yield();
+    }
+    thread.join();
+    CHECK(woken == 1000);
+  }
+
+  SECTION("Manual reset") {
+    Event event(Event::Type::kManualReset);
+
+    std::atomic<int> woken = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.push_back(std::thread([&]() {
+        event.Wait();
+        woken++;
+      }));
+    }
+
+    event.Signal();
+    for (auto& thread : threads)
+      thread.join();
+    CHECK(woken == 4);
+
+    // Stays signaled until reset.
+    CHECK(event.IsSignaled());
+    event.Wait();
+    event.Reset();
+    CHECK(!event.IsSignaled());
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
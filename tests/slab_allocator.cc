@@ -0,0 +1,152 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/memory/slab_allocator.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <set>
+#include <thread>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+struct Object {
+  Object(int v) : value(v) {}
+
+  int value = 0;
+  float padding[5];
+};
+
+struct alignas(32) AlignedObject {
+  char c;
+};
+
+}  // namespace
+
+TEST_CASE("SlabAllocator") {
+  SECTION("Allocating and freeing") {
+    SlabAllocator slab;
+    InitSlabAllocator<Object>(&slab, "Objects");
+    CHECK(slab.object_size == sizeof(Object));
+    CHECK(GetCapacity(&slab) == 0);
+
+    std::vector<Object*> objects;
+    for (int i = 0; i < 1000; i++)
+      objects.push_back(SlabNew<Object>(&slab, i));
+
+    CHECK(GetLiveCount(&slab) == 1000);
+    CHECK(GetCapacity(&slab) >= 1000);
+    CHECK(GetReservedBytes(&slab) % slab.slab_size == 0);
+
+    std::set<Object*> unique(objects.begin(), objects.end());
+    CHECK(unique.size() == objects.size());
+
+    bool intact = true;
+    for (int i = 0; i < 1000; i++)
+      intact &= objects[i]->value == i;
+    CHECK(intact);
+
+    // Freed slots are reused before growing.
+    size_t capacity = GetCapacity(&slab);
+    for (int i = 0; i < 500; i++)
+      SlabDelete(&slab, objects[i]);
+    CHECK(GetLiveCount(&slab) == 500);
+    for (int i = 0; i < 500; i++)
+      objects[i] = SlabNew<Object>(&slab, -i);
+    CHECK(GetCapacity(&slab) == capacity);
+    CHECK(GetLiveCount(&slab) == 1000);
+  }
+
+  SECTION("Alignment") {
+    SlabAllocator slab;
+    InitSlabAllocator<AlignedObject>(&slab, "Aligned");
+    CHECK(slab.object_size == 32);
+    for (int i = 0; i < 100; i++)
+      CHECK((uintptr_t)Allocate(&slab) % 32 == 0);
+  }
+
+  SECTION("Is tracked") {
+    size_t tracked = GetTrackedStats().size();
+    {
+      SlabAllocator slab;
+      InitSlabAllocator<Object>(&slab, "Tracked");
+      SlabNew<Object>(&slab, 1);
+
+      std::vector<TrackedStats> stats = GetTrackedStats();
+      REQUIRE(stats.size() == tracked + 1);
+      CHECK(stats.back().type == TrackType::kSlabAllocator);
+      CHECK(stats.back().used == slab.object_size);
+      CHECK(stats.back().reserved == slab.slab_size);
+    }
+    CHECK(GetTrackedStats().size() == tracked);
+  }
+
+  SECTION("Thread caches") {
+    SlabAllocator slab;
+    InitSlabAllocator<Object>(&slab, "Cached", true);
+
+    constexpr int kThreads = 4;
+    constexpr int kCount = 10000;
+    std::vector<Object*> objects[kThreads];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&slab, &objects, t]() {
+        for (int i = 0; i < kCount; i++)
+          objects[t].push_back(SlabNew<Object>(&slab, t * kCount + i));
+        // Free half of them here.
+        for (int i = 0; i < kCount / 2; i++)
+          SlabDelete(&slab, objects[t][i]);
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    CHECK(GetLiveCount(&slab) == kThreads * kCount / 2);
+
+    // Free the rest from another thread than the one that allocated them.
+    std::set<Object*> unique;
+    bool intact = true;
+    for (int t = 0; t < kThreads; t++) {
+      for (int i = kCount / 2; i < kCount; i++) {
+        intact &= objects[t][i]->value == t * kCount + i;
+        unique.insert(objects[t][i]);
+        SlabDelete(&slab, objects[t][i]);
+      }
+    }
+    CHECK(intact);
+    CHECK(unique.size() == kThreads * kCount / 2);
+    CHECK(GetLiveCount(&slab) == 0);
+  }
+
+  SECTION("Exiting threads give their caches back") {
+    SlabAllocator slab;
+    InitSlabAllocator<Object>(&slab, "Short lived threads", true);
+
+    // More threads than cache slots. Each one takes a batch into its cache
+    // and keeps one object alive. Without flushing on exit, the batches would
+    // be stranded and every thread would need new memory.
+    constexpr int kThreads = 2 * SlabAllocator::kMaxThreadCaches;
+    std::vector<Object*> kept;
+    for (int t = 0; t < kThreads; t++) {
+      std::thread thread([&slab, &kept, t]() {
+        kept.push_back(SlabNew<Object>(&slab, t));
+        SlabDelete(&slab, SlabNew<Object>(&slab, -1));
+      });
+      thread.join();
+    }
+
+    CHECK(GetLiveCount(&slab) == kThreads);
+    CHECK(GetCapacity(&slab) < kThreads + SlabAllocator::kCacheBatch +
+                               slab.objects_per_slab);
+
+    for (Object* object : kept)
+      SlabDelete(&slab, object);
+    CHECK(GetLiveCount(&slab) == 0);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
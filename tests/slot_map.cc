@@ -0,0 +1,117 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/containers/slot_map.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+struct Foo {};
+struct Bar {};
+
+}  // namespace
+
+TEST_CASE("SlotMap") {
+  SECTION("Insert, find and erase") {
+    SlotMap<std::string, Foo> map;
+    CHECK(Empty(&map));
+
+    Handle<Foo> null_handle = {};
+    CHECK(!Valid(null_handle));
+    CHECK(Find(&map, null_handle) == nullptr);
+    CHECK(!Erase(&map, null_handle));
+
+    Handle<Foo> one = Insert(&map, std::string("one"));
+    Handle<Foo> two = Insert(&map, std::string("two"));
+    CHECK(Valid(one));
+    CHECK(Valid(two));
+    CHECK(one != two);
+    CHECK(map.size == 2);
+
+    REQUIRE(Find(&map, one));
+    CHECK(*Find(&map, one) == "one");
+    CHECK(*Find(&map, two) == "two");
+
+    CHECK(Erase(&map, one));
+    CHECK(!Contains(&map, one));
+    CHECK(!Erase(&map, one));
+    CHECK(Contains(&map, two));
+    CHECK(map.size == 1);
+  }
+
+  SECTION("Stale handles") {
+    SlotMap<int, Foo> map;
+    Handle<Foo> first = Insert(&map, 1);
+    Erase(&map, first);
+
+    // The slot is reused, but the old handle does not see the new value.
+    Handle<Foo> second = Insert(&map, 2);
+    CHECK(second.index == first.index);
+    CHECK(second.generation != first.generation);
+    CHECK(Find(&map, first) == nullptr);
+    REQUIRE(Find(&map, second));
+    CHECK(*Find(&map, second) == 2);
+    CHECK(map.slots.size == 1);
+
+    // Out of range indices.
+    Handle<Foo> bogus = second;
+    bogus.index = 100;
+    CHECK(Find(&map, bogus) == nullptr);
+  }
+
+  SECTION("Free slots are reused") {
+    SlotMap<int, Bar> map;
+    std::vector<Handle<Bar>> handles;
+    for (int i = 0; i < 100; i++)
+      handles.push_back(Insert(&map, i));
+
+    for (int i = 0; i < 100; i += 2)
+      Erase(&map, handles[i]);
+    CHECK(map.size == 50);
+
+    for (int i = 0; i < 50; i++)
+      Insert(&map, 1000 + i);
+    CHECK(map.size == 100);
+    CHECK(map.slots.size == 100);
+
+    for (int i = 1; i < 100; i += 2) {
+      REQUIRE(Find(&map, handles[i]));
+      CHECK(*Find(&map, handles[i]) == i);
+    }
+  }
+
+  SECTION("Iteration and clear") {
+    SlotMap<int, Foo> map;
+    Handle<Foo> handles[5];
+    for (int i = 0; i < 5; i++)
+      handles[i] = Insert(&map, i);
+    Erase(&map, handles[0]);
+    Erase(&map, handles[3]);
+
+    std::vector<int> values;
+    for (int value : map)
+      values.push_back(value);
+    CHECK(values == std::vector<int>{1, 2, 4});
+
+    Clear(&map);
+    CHECK(Empty(&map));
+    CHECK(map.begin() == map.end());
+    for (Handle<Foo> handle : handles)
+      CHECK(!Contains(&map, handle));
+
+    // Handles given out after clearing are still distinct from the old ones.
+    Handle<Foo> handle = Insert(&map, 42);
+    for (Handle<Foo> old : handles)
+      CHECK(handle != old);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,70 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/containers/small_vector.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <string>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("SmallVector") {
+  SECTION("Stays inline up to N") {
+    SmallVector<int, 4> vec = {1, 2, 3};
+    CHECK(IsInline(&vec));
+    CHECK(vec.size == 3);
+
+    Push(&vec, 4);
+    CHECK(IsInline(&vec));
+
+    Push(&vec, 5);
+    CHECK(!IsInline(&vec));
+    REQUIRE(vec.size == 5);
+
+    int i = 1;
+    for (int value : vec) {
+      CHECK(value == i);
+      i++;
+    }
+  }
+
+  SECTION("Copy and move") {
+    SmallVector<std::string, 2> inline_vec = {"a", "b"};
+    SmallVector<std::string, 2> heap_vec = {"c", "d", "e"};
+
+    auto copy = heap_vec;
+    CHECK(!IsInline(&copy));
+    REQUIRE(copy.size == 3);
+    CHECK(copy[2] == "e");
+    CHECK(heap_vec[2] == "e");
+
+    // Heap storage is taken over.
+    std::string* data = heap_vec.data;
+    auto moved_heap = std::move(heap_vec);
+    CHECK(moved_heap.data == data);
+    CHECK(Empty(&heap_vec));
+    CHECK(IsInline(&heap_vec));
+
+    // Inline elements are moved one by one.
+    auto moved_inline = std::move(inline_vec);
+    CHECK(IsInline(&moved_inline));
+    REQUIRE(moved_inline.size == 2);
+    CHECK(moved_inline[0] == "a");
+    CHECK(moved_inline[1] == "b");
+    CHECK(Empty(&inline_vec));
+
+    moved_inline = copy;
+    REQUIRE(moved_inline.size == 3);
+    CHECK(moved_inline[0] == "c");
+
+    Pop(&moved_inline);
+    CHECK(moved_inline.size == 2);
+    Reset(&moved_inline);
+    CHECK(Empty(&moved_inline));
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,89 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/containers/sort.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+struct Item {
+  uint64_t key;
+  uint32_t order;   // Original position, to check stability.
+};
+
+uint64_t GetKey(const Item& item) { return item.key; }
+
+bool SortedAndStable(const std::vector<Item>& items) {
+  for (size_t i = 1; i < items.size(); i++) {
+    const Item& prev = items[i - 1];
+    const Item& item = items[i];
+    if (prev.key > item.key)
+      return false;
+    if (prev.key == item.key && prev.order > item.order)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("RadixSort") {
+  SECTION("Trivial sizes") {
+    std::vector<Item> scratch(1);
+    RadixSort((Item*)nullptr, scratch.data(), 0, GetKey);
+
+    std::vector<Item> items = {{5, 0}};
+    RadixSort(items.data(), scratch.data(), 1, GetKey);
+    CHECK(items[0].key == 5);
+  }
+
+  SECTION("Random keys") {
+    std::mt19937_64 rng(1234);
+    std::vector<Item> items;
+    for (uint32_t i = 0; i < 5000; i++)
+      items.push_back({rng(), i});
+
+    std::vector<Item> scratch(items.size());
+    RadixSort(items.data(), scratch.data(), (uint32_t)items.size(), GetKey);
+    CHECK(SortedAndStable(items));
+  }
+
+  SECTION("Few distinct keys are kept stable") {
+    std::mt19937 rng(4321);
+    std::vector<Item> items;
+    for (uint32_t i = 0; i < 1000; i++) {
+      // Spread over the top and bottom bytes so several passes are needed.
+      uint64_t key = ((uint64_t)(rng() % 4) << 56) | (rng() % 3);
+      items.push_back({key, i});
+    }
+
+    std::vector<Item> scratch(items.size());
+    RadixSort(items.data(), scratch.data(), (uint32_t)items.size(), GetKey);
+    CHECK(SortedAndStable(items));
+  }
+
+  SECTION("Result ends up in the values") {
+    // A single pass leaves the data in the scratch buffer, which has to be
+    // copied back.
+    std::vector<Item> items = {{3, 0}, {1, 1}, {2, 2}, {1, 3}};
+    std::vector<Item> scratch(items.size());
+    RadixSort(items.data(), scratch.data(), (uint32_t)items.size(), GetKey);
+    CHECK(items[0].key == 1);
+    CHECK(items[0].order == 1);
+    CHECK(items[1].key == 1);
+    CHECK(items[1].order == 3);
+    CHECK(items[2].key == 2);
+    CHECK(items[3].key == 3);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,144 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/task.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <thread>
+
+#include <warhol/utils/file.h>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+Task<int> Add(JobSystem* js, int a, int b) {
+  co_await SwitchToWorker(js);
+  co_return a + b;
+}
+
+Task<int> AddAll(JobSystem* js) {
+  int first = co_await Add(js, 1, 2);
+  int second = co_await Add(js, first, 3);
+  co_return second;
+}
+
+Task<int> BackgroundWorkerIndex(JobSystem* js) {
+  co_await SwitchToWorker(js, JobPriority::kBackground);
+  co_return GetCurrentWorkerIndex(js);
+}
+
+void IncrementJob(void* user_data) {
+  std::this_thread::yield();
+  (*(std::atomic<int>*)user_data)++;
+}
+
+Task<int> WaitForIncrements(JobSystem* js, std::atomic<int>* value) {
+  JobCounter counter;
+  for (int i = 0; i < 100; i++)
+    PushJob(js, {IncrementJob, value}, &counter);
+  co_await WaitFor(js, &counter);
+  co_return value->load();
+}
+
+Task<std::string> ReadFile(JobSystem* js, std::string path) {
+  std::string data;
+  if (!co_await ReadFileAsync(js, path, &data, false))
+    co_return "<failed>";
+  co_return data;
+}
+
+Task<std::thread::id> ResumeOnNextFrame(JobSystem* js,
+                                        FrameContinuations* continuations) {
+  co_await SwitchToWorker(js);
+  co_await NextFrame(continuations);
+  co_return std::this_thread::get_id();
+}
+
+}  // namespace
+
+TEST_CASE("Task") {
+  JobSystem job_system;
+  REQUIRE(InitJobSystem(&job_system, 4));
+
+  SECTION("Awaiting tasks") {
+    CHECK(RunTaskAndWait(&job_system, AddAll(&job_system)) == 6);
+  }
+
+  SECTION("Tasks are lazy") {
+    Task<int> task = Add(&job_system, 1, 1);
+    CHECK(!task.done());
+
+    JobCounter counter;
+    RunTask(&job_system, &task, &counter);
+    WaitForCounter(&job_system, &counter);
+    CHECK(task.done());
+    CHECK(task.TakeResult() == 2);
+  }
+
+  SECTION("Switching to a worker") {
+    // Worker 0 (us) never runs background jobs.
+    int index = RunTaskAndWait(&job_system, BackgroundWorkerIndex(&job_system));
+    CHECK(index > 0);
+  }
+
+  SECTION("Waiting on jobs") {
+    std::atomic<int> value = 0;
+    int seen = RunTaskAndWait(&job_system,
+                              WaitForIncrements(&job_system, &value));
+    CHECK(seen == 100);
+  }
+
+  SECTION("Waiting on a counter in the coroutine frame") {
+    // The resumed coroutine destroys the counter it waited on, racing with
+    // the thread that finished it. Loop so that race actually gets exercised.
+    for (int i = 0; i < 200; i++) {
+      std::atomic<int> value = 0;
+      int seen = RunTaskAndWait(&job_system,
+                                WaitForIncrements(&job_system, &value));
+      REQUIRE(seen == 100);
+    }
+  }
+
+  SECTION("Reading files") {
+    const char* path = "task_test_file.txt";
+    {
+      FileHandle file = OpenFile(path);
+      REQUIRE(Valid(&file));
+      char content[] = "Some content";
+      WriteToFile(&file, content, sizeof(content) - 1);
+    }
+
+    CHECK(RunTaskAndWait(&job_system, ReadFile(&job_system, path)) ==
+          "Some content");
+    remove(path);
+
+    CHECK(RunTaskAndWait(&job_system, ReadFile(&job_system, path)) ==
+          "<failed>");
+  }
+
+  SECTION("Next frame continuations") {
+    FrameContinuations continuations;
+    Task<std::thread::id> task = ResumeOnNextFrame(&job_system,
+                                                   &continuations);
+    JobCounter counter;
+    RunTask(&job_system, &task, &counter);
+
+    // We're the "main thread", so we cannot simply wait on the counter.
+    int frames = 0;
+    while (!Done(&counter)) {
+      RunFrameContinuations(&continuations);
+      std::this_thread::yield();
+      frames++;
+    }
+
+    CHECK(frames > 0);
+    CHECK(task.TakeResult() == std::this_thread::get_id());
+    CHECK(RunFrameContinuations(&continuations) == 0);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
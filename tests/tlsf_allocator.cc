@@ -0,0 +1,139 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/memory/tlsf_allocator.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <random>
+#include <string.h>
+
+namespace warhol {
+namespace test {
+
+TEST_CASE("TLSFAllocator") {
+  MemoryPool pool;
+  InitMemoryPool(&pool, MEGABYTES(1));
+
+  TLSFAllocator tlsf;
+  REQUIRE(InitTLSFAllocator(&tlsf, &pool, KILOBYTES(512)));
+  CHECK(Used(&pool) == KILOBYTES(512));
+  CHECK(CheckIntegrity(&tlsf));
+
+  SECTION("Allocating and freeing") {
+    void* a = Allocate(&tlsf, 100);
+    void* b = Allocate(&tlsf, 2000);
+    void* c = Allocate(&tlsf, 1);
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    CHECK((uintptr_t)a % TLSFAllocator::kAlignment == 0);
+    CHECK(GetAllocationSize(a) >= 100);
+    CHECK(GetAllocationSize(b) >= 2000);
+    CHECK(tlsf.allocation_count == 3);
+    CHECK(CheckIntegrity(&tlsf));
+
+    memset(a, 0xaa, 100);
+    memset(b, 0xbb, 2000);
+    memset(c, 0xcc, 1);
+
+    Free(&tlsf, b);
+    CHECK(CheckIntegrity(&tlsf));
+    CHECK(((uint8_t*)a)[99] == 0xaa);
+    CHECK(((uint8_t*)c)[0] == 0xcc);
+
+    // The hole left by |b| gets reused.
+    void* d = Allocate(&tlsf, 1500);
+    CHECK(d == b);
+
+    Free(&tlsf, a);
+    Free(&tlsf, c);
+    Free(&tlsf, d);
+    CHECK(tlsf.used == 0);
+    CHECK(tlsf.allocation_count == 0);
+    CHECK(CheckIntegrity(&tlsf));
+  }
+
+  SECTION("Frees merge back into one block") {
+    std::vector<void*> ptrs;
+    while (void* ptr = Allocate(&tlsf, 1000))
+      ptrs.push_back(ptr);
+    CHECK(ptrs.size() > 400);
+    CHECK(CheckIntegrity(&tlsf));
+
+    // Free in an order that exercises merging on both sides.
+    for (size_t i = 0; i < ptrs.size(); i += 2)
+      Free(&tlsf, ptrs[i]);
+    for (size_t i = 1; i < ptrs.size(); i += 2)
+      Free(&tlsf, ptrs[i]);
+    CHECK(CheckIntegrity(&tlsf));
+
+    // Everything is one block again.
+    void* big = Allocate(&tlsf, KILOBYTES(256));
+    CHECK(big != nullptr);
+    Free(&tlsf, big);
+  }
+
+  SECTION("Alignment") {
+    size_t alignments[] = {16, 64, 256, 4096};
+    std::vector<void*> ptrs;
+    for (size_t alignment : alignments) {
+      for (int i = 0; i < 10; i++) {
+        void* ptr = Allocate(&tlsf, 24 + i * 8, alignment);
+        REQUIRE(ptr);
+        CHECK((uintptr_t)ptr % alignment == 0);
+        ptrs.push_back(ptr);
+      }
+    }
+    CHECK(CheckIntegrity(&tlsf));
+
+    for (void* ptr : ptrs)
+      Free(&tlsf, ptr);
+    CHECK(tlsf.used == 0);
+    CHECK(CheckIntegrity(&tlsf));
+  }
+
+  SECTION("Out of memory") {
+    CHECK(Allocate(&tlsf, MEGABYTES(1)) == nullptr);
+    void* all = Allocate(&tlsf, KILOBYTES(400));
+    CHECK(all != nullptr);
+    CHECK(Allocate(&tlsf, KILOBYTES(200)) == nullptr);
+    CHECK(CheckIntegrity(&tlsf));
+  }
+
+  SECTION("Random workload") {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> sizes(1, 4096);
+    std::vector<std::pair<uint8_t*, size_t>> live;
+
+    bool intact = true;
+    for (int i = 0; i < 20000; i++) {
+      if (!live.empty() && (rng() % 2 == 0 || live.size() > 200)) {
+        size_t index = rng() % live.size();
+        auto [ptr, size] = live[index];
+        for (size_t b = 0; b < size; b++)
+          intact &= ptr[b] == (uint8_t)size;
+        Free(&tlsf, ptr);
+        live[index] = live.back();
+        live.pop_back();
+      } else {
+        size_t size = sizes(rng);
+        auto* ptr = (uint8_t*)Allocate(&tlsf, size, (size_t)16 << (rng() % 4));
+        if (ptr) {
+          memset(ptr, (uint8_t)size, size);
+          live.push_back({ptr, size});
+        }
+      }
+    }
+    CHECK(intact);
+    CHECK(CheckIntegrity(&tlsf));
+
+    for (auto [ptr, size] : live)
+      Free(&tlsf, ptr);
+    CHECK(tlsf.used == 0);
+    CHECK(CheckIntegrity(&tlsf));
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
@@ -0,0 +1,102 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <warhol/multithreading/worker_pool.h>
+
+#include <third_party/catch2/catch.hpp>
+
+#include <atomic>
+#include <set>
+
+namespace warhol {
+namespace test {
+
+namespace {
+
+struct PoolData {
+  std::atomic<uint32_t> visited_mask = 0;
+  std::atomic<int> runs = 0;
+};
+
+void RecordWorker(void* user_data, uint32_t worker_index) {
+  auto* data = (PoolData*)user_data;
+  data->visited_mask |= 1u << worker_index;
+  data->runs++;
+}
+
+}  // namespace
+
+TEST_CASE("CpuTopology") {
+  CpuTopology topology = GetCpuTopology();
+  REQUIRE(!topology.cpus.empty());
+  CHECK(topology.core_count >= 1);
+  CHECK(topology.core_count <= topology.cpus.size());
+  CHECK(topology.package_count >= 1);
+
+  std::set<uint32_t> ids;
+  bool seen_sibling = false;
+  bool siblings_last = true;
+  for (const CpuInfo& cpu : topology.cpus) {
+    ids.insert(cpu.id);
+    CHECK(cpu.core < topology.core_count);
+    CHECK(cpu.package < topology.package_count);
+
+    if (cpu.smt_sibling)
+      seen_sibling = true;
+    else if (seen_sibling)
+      siblings_last = false;
+  }
+  CHECK(ids.size() == topology.cpus.size());
+  CHECK(siblings_last);
+}
+
+TEST_CASE("WorkerPool") {
+  SECTION("Every worker runs once") {
+    PoolData data;
+    WorkerPoolConfig config;
+    config.worker_count = 6;
+
+    WorkerPool pool;
+    REQUIRE(StartWorkerPool(&pool, config, RecordWorker, &data));
+    CHECK(pool.worker_count == 6);
+    JoinWorkerPool(&pool);
+
+    CHECK(data.runs == 6);
+    CHECK(data.visited_mask == 0b111111);
+  }
+
+  SECTION("Workers are not pinned to the calling thread's core") {
+    PoolData data;
+    WorkerPool pool;
+    REQUIRE(StartWorkerPool(&pool, {}, RecordWorker, &data));
+    CHECK(pool.worker_count >= 1);
+
+    std::set<int32_t> cpus;
+    for (uint32_t i = 0; i < pool.worker_count; i++) {
+      int32_t cpu = pool.cpus[i];
+      if (cpu == WorkerPool::kNotPinned)
+        continue;
+
+      CHECK(cpus.insert(cpu).second);
+      for (const CpuInfo& info : pool.topology.cpus) {
+        if (info.id == (uint32_t)cpu)
+          CHECK(info.core != pool.topology.cpus.front().core);
+      }
+    }
+  }
+
+  SECTION("Not pinning") {
+    PoolData data;
+    WorkerPoolConfig config;
+    config.worker_count = 2;
+    config.pin_threads = false;
+
+    WorkerPool pool;
+    REQUIRE(StartWorkerPool(&pool, config, RecordWorker, &data));
+    for (uint32_t i = 0; i < pool.worker_count; i++)
+      CHECK(pool.cpus[i] == WorkerPool::kNotPinned);
+  }
+}
+
+}  // namespace test
+}  // namespace warhol
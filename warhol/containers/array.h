@@ -0,0 +1,263 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "warhol/memory/frame_allocator.h"
+#include "warhol/memory/memory_pool.h"
+#include "warhol/utils/log.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// Array -----------------------------------------------------------------------
+//
+// Contiguous growable array, so hot loops walk memory linearly instead of
+// chasing List nodes.
+//
+// The storage comes either from the heap (owned by the array, freed on
+// destruction and with ShrinkToFit) or from an external |arena| (eg. a frame
+// arena, see frame_allocator.h), which has to outlive the array.
+//
+// An arena array that is the last thing pushed into its arena grows in place.
+// Otherwise growing moves the elements to a bigger block and the old one is
+// wasted until the arena is reset, so pass the count up front when known.
+//
+// Like List nodes, elements living in an arena are never destroyed.
+
+template <typename T>
+struct Array {
+  Array() = default;
+  ~Array();
+  DELETE_COPY_AND_ASSIGN(Array);
+  DECLARE_MOVE_AND_ASSIGN(Array);
+
+  T* data = nullptr;
+  uint32_t size = 0;
+  uint32_t capacity = 0;
+
+  MemoryPool* arena = nullptr;    // Not owned. Null means heap.
+
+  T* begin() { return data; }
+  T* end() { return data + size; }
+  const T* begin() const { return data; }
+  const T* end() const { return data + size; }
+
+  T& operator[](uint32_t index) {
+    ASSERT(index < size) << "Index " << index << ", size " << size;
+    return data[index];
+  }
+  const T& operator[](uint32_t index) const {
+    ASSERT(index < size) << "Index " << index << ", size " << size;
+    return data[index];
+  }
+};
+
+template <typename T>
+inline bool Empty(const Array<T>* array) { return array->size == 0; }
+
+// |arena| has to outlive the array.
+template <typename T>
+Array<T> CreateArray(MemoryPool* arena, uint32_t capacity = 0);
+
+// Array valid until the current frame is done (see frame_allocator.h).
+template <typename T>
+Array<T> CreateFrameArray(uint32_t capacity = 0) {
+  return CreateArray<T>(GetFrameArena(), capacity);
+}
+
+template <typename T>
+void EnsureCapacity(Array<T>*, uint32_t capacity);
+
+// Pushes a default constructed value.
+template <typename T>
+T* Push(Array<T>*);
+
+// Same as before but moving in a value.
+template <typename T>
+T* Push(Array<T>*, T t);
+
+template <typename T>
+void Pop(Array<T>*);
+
+// Destroys the elements but keeps the storage around.
+template <typename T>
+void Reset(Array<T>*);
+
+// Gives back the unused capacity. Only does something for heap arrays.
+template <typename T>
+void ShrinkToFit(Array<T>*);
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+namespace array_internal {
+
+// Growth used by Array and SmallVector when running out of capacity.
+inline uint32_t NextCapacity(uint32_t capacity, uint32_t wanted) {
+  uint32_t next = capacity < 8 ? 8 : capacity + capacity / 2;
+  return next > wanted ? next : wanted;
+}
+
+template <typename T>
+T* AllocateHeap(uint32_t count) {
+  return (T*)::operator new(sizeof(T) * count, std::align_val_t(alignof(T)));
+}
+
+template <typename T>
+void FreeHeap(T* data) {
+  ::operator delete(data, std::align_val_t(alignof(T)));
+}
+
+template <typename T>
+void DestroyElements(T* data, uint32_t count) {
+  if constexpr (!std::is_trivially_destructible<T>::value) {
+    for (uint32_t i = 0; i < count; i++)
+      data[i].~T();
+  }
+}
+
+// Move constructs |count| elements from |src| into the uninitialized |dst|,
+// destroying the originals.
+template <typename T>
+void RelocateElements(T* dst, T* src, uint32_t count) {
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    if (count > 0)
+      memcpy(dst, src, sizeof(T) * count);
+  } else {
+    for (uint32_t i = 0; i < count; i++) {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+
+}  // namespace array_internal
+
+template <typename T>
+Array<T>::~Array() {
+  if (arena)
+    return;
+
+  array_internal::DestroyElements(data, size);
+  if (data)
+    array_internal::FreeHeap(data);
+}
+
+template <typename T>
+Array<T>::Array(Array&& rhs)
+    : data(rhs.data), size(rhs.size), capacity(rhs.capacity),
+      arena(rhs.arena) {
+  rhs.data = nullptr;
+  rhs.size = 0;
+  rhs.capacity = 0;
+}
+
+template <typename T>
+Array<T>& Array<T>::operator=(Array&& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  this->~Array();
+  new (this) Array(std::move(rhs));
+  return *this;
+}
+
+template <typename T>
+Array<T> CreateArray(MemoryPool* arena, uint32_t capacity) {
+  ASSERT(Valid(arena));
+  Array<T> array;
+  array.arena = arena;
+  if (capacity > 0)
+    EnsureCapacity(&array, capacity);
+  return array;
+}
+
+template <typename T>
+void EnsureCapacity(Array<T>* array, uint32_t capacity) {
+  if (capacity <= array->capacity)
+    return;
+
+  if (!array->arena) {
+    T* data = array_internal::AllocateHeap<T>(capacity);
+    array_internal::RelocateElements(data, array->data, array->size);
+    if (array->data)
+      array_internal::FreeHeap(array->data);
+    array->data = data;
+    array->capacity = capacity;
+    return;
+  }
+
+  // Extend in place if nothing was pushed into the arena after us.
+  MemoryPool* arena = array->arena;
+  if (array->data &&
+      (uint8_t*)(array->data + array->capacity) == arena->current) {
+    Reserve(arena, sizeof(T) * (capacity - array->capacity), alignof(T));
+    array->capacity = capacity;
+    return;
+  }
+
+  T* data = (T*)Reserve(arena, sizeof(T) * capacity, alignof(T));
+  array_internal::RelocateElements(data, array->data, array->size);
+  array->data = data;
+  array->capacity = capacity;
+}
+
+template <typename T>
+T* Push(Array<T>* array) {
+  if (array->size == array->capacity) {
+    EnsureCapacity(array, array_internal::NextCapacity(array->capacity,
+                                                       array->size + 1));
+  }
+  return new (array->data + array->size++) T();
+}
+
+template <typename T>
+T* Push(Array<T>* array, T t) {
+  if (array->size == array->capacity) {
+    EnsureCapacity(array, array_internal::NextCapacity(array->capacity,
+                                                       array->size + 1));
+  }
+  return new (array->data + array->size++) T(std::move(t));
+}
+
+template <typename T>
+void Pop(Array<T>* array) {
+  ASSERT(!Empty(array));
+  array->size--;
+  if (!array->arena)
+    array_internal::DestroyElements(array->data + array->size, 1);
+}
+
+template <typename T>
+void Reset(Array<T>* array) {
+  if (!array->arena)
+    array_internal::DestroyElements(array->data, array->size);
+  array->size = 0;
+}
+
+template <typename T>
+void ShrinkToFit(Array<T>* array) {
+  if (array->arena || array->size == array->capacity)
+    return;
+
+  T* data = nullptr;
+  if (array->size > 0) {
+    data = array_internal::AllocateHeap<T>(array->size);
+    array_internal::RelocateElements(data, array->data, array->size);
+  }
+
+  array_internal::FreeHeap(array->data);
+  array->data = data;
+  array->capacity = array->size;
+}
+
+}  // namespace warhol
@@ -0,0 +1,487 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define WARHOL_FLAT_HASH_MAP_SSE2 1
+#include <emmintrin.h>
+#else
+#define WARHOL_FLAT_HASH_MAP_SSE2 0
+#endif
+
+#include "warhol/utils/log.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// FlatHashMap -----------------------------------------------------------------
+//
+// Open addressing hash map in the style of a Swiss table. Entries live in a
+// flat array and every slot has a control byte: empty, deleted or the low 7
+// bits of its hash (H2). Slots are probed in groups of 16: a single SSE2
+// compare of the group control bytes against H2 yields the candidates, so most
+// lookups touch one cache line of control bytes and one entry.
+//
+// |Hasher| is pluggable (same interface as std::hash). Its result is mixed
+// again, so weak hashes (eg. the identity for integer uuids) are fine.
+//
+// Pointers to values are invalidated by inserts that grow the table.
+
+template <typename K, typename V, typename Hasher = std::hash<K>>
+struct FlatHashMap {
+  static constexpr uint32_t kGroupSize = 16;
+
+  // Control bytes. Full slots hold H2 (0-127), so the sign bit tells them
+  // apart from the special ones.
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  using Key = K;
+  using Value = V;
+
+  struct Entry {
+    K key;
+    V value;
+  };
+
+  struct Iterator;
+
+  FlatHashMap() = default;
+  ~FlatHashMap();
+  DELETE_COPY_AND_ASSIGN(FlatHashMap);
+  DECLARE_MOVE_AND_ASSIGN(FlatHashMap);
+
+  int8_t* ctrl = nullptr;
+  Entry* slots = nullptr;
+  uint32_t capacity = 0;      // 0 or a power of two, at least kGroupSize.
+  uint32_t size = 0;
+  uint32_t tombstones = 0;    // Deleted slots, which still lengthen probes.
+
+  Hasher hasher;
+
+  Iterator begin() { return Iterator(this, 0); }
+  Iterator end() { return Iterator(this, capacity); }
+};
+
+template <typename K, typename V, typename H>
+inline bool Empty(const FlatHashMap<K, V, H>* map) { return map->size == 0; }
+
+// Null if not there.
+template <typename K, typename V, typename H>
+V* Find(FlatHashMap<K, V, H>*, const typename FlatHashMap<K, V, H>::Key&);
+
+template <typename K, typename V, typename H>
+inline bool Contains(FlatHashMap<K, V, H>* map,
+                     const typename FlatHashMap<K, V, H>::Key& key) {
+  return Find(map, key) != nullptr;
+}
+
+// Overwrites the value if |key| is already there.
+template <typename K, typename V, typename H>
+V* Insert(FlatHashMap<K, V, H>*, typename FlatHashMap<K, V, H>::Key key,
+          typename FlatHashMap<K, V, H>::Value value);
+
+// Inserts a default constructed value if |key| is not there.
+template <typename K, typename V, typename H>
+V* FindOrInsert(FlatHashMap<K, V, H>*,
+                const typename FlatHashMap<K, V, H>::Key&);
+
+// Returns whether |key| was there.
+template <typename K, typename V, typename H>
+bool Erase(FlatHashMap<K, V, H>*, const typename FlatHashMap<K, V, H>::Key&);
+
+// Removes every entry. Keeps the memory.
+template <typename K, typename V, typename H>
+void Clear(FlatHashMap<K, V, H>*);
+
+// Makes room for |count| entries without growing again.
+template <typename K, typename V, typename H>
+void EnsureCapacity(FlatHashMap<K, V, H>*, uint32_t count);
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+namespace flat_hash_map_internal {
+
+// Spreads the entropy of the hash to every bit (H2 is the low 7 bits of the
+// result and H1 the rest).
+inline uint64_t MixHash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+inline uint32_t H1(uint64_t hash) { return (uint32_t)(hash >> 7); }
+inline int8_t H2(uint64_t hash) { return (int8_t)(hash & 0x7f); }
+
+// Bitmask with a bit set per control byte of the group that matches.
+struct Group {
+#if WARHOL_FLAT_HASH_MAP_SSE2
+  explicit Group(const int8_t* ctrl)
+      : ctrl(_mm_load_si128((const __m128i*)ctrl)) {}
+
+  uint32_t Match(int8_t h2) const {
+    __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl);
+    return (uint32_t)_mm_movemask_epi8(match);
+  }
+
+  uint32_t MatchEmpty() const {
+    return Match(-128);
+  }
+
+  // Empty or deleted (the only control bytes with the sign bit set).
+  uint32_t MatchAvailable() const {
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+  }
+
+  __m128i ctrl;
+#else
+  explicit Group(const int8_t* ctrl) : ctrl(ctrl) {}
+
+  uint32_t Match(int8_t h2) const {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+      if (ctrl[i] == h2)
+        mask |= 1u << i;
+    }
+    return mask;
+  }
+
+  uint32_t MatchEmpty() const { return Match(-128); }
+
+  uint32_t MatchAvailable() const {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+      if (ctrl[i] < 0)
+        mask |= 1u << i;
+    }
+    return mask;
+  }
+
+  const int8_t* ctrl;
+#endif
+};
+
+inline uint32_t LowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (uint32_t)index;
+#else
+  return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+// Groups are visited with triangular steps, which covers every group when the
+// group count is a power of two.
+struct ProbeSequence {
+  ProbeSequence(uint32_t h1, uint32_t group_count)
+      : mask(group_count - 1), group(h1 & mask) {}
+
+  uint32_t offset() const { return group * 16; }
+  void Next() {
+    step++;
+    group = (group + step) & mask;
+  }
+
+  uint32_t mask;
+  uint32_t group;
+  uint32_t step = 0;
+};
+
+// At most 7/8 of the slots can be used (counting tombstones).
+inline uint32_t MaxLoad(uint32_t capacity) { return capacity - capacity / 8; }
+
+template <typename Map>
+uint64_t HashKey(Map* map, const typename Map::Key& key) {
+  return MixHash((uint64_t)map->hasher(key));
+}
+
+template <typename Map>
+size_t SlotsOffset(uint32_t capacity) {
+  using Entry = typename Map::Entry;
+  size_t align = alignof(Entry);
+  return (capacity + align - 1) & ~(align - 1);
+}
+
+template <typename Map>
+constexpr size_t StorageAlignment() {
+  using Entry = typename Map::Entry;
+  return alignof(Entry) > 16 ? alignof(Entry) : 16;
+}
+
+template <typename Map>
+void FreeStorage(Map* map) {
+  using Entry = typename Map::Entry;
+  if (!map->ctrl)
+    return;
+
+  for (uint32_t i = 0; i < map->capacity; i++) {
+    if (map->ctrl[i] >= 0)
+      map->slots[i].~Entry();
+  }
+  ::operator delete(map->ctrl, std::align_val_t(StorageAlignment<Map>()));
+  map->ctrl = nullptr;
+  map->slots = nullptr;
+}
+
+// Index of the slot to insert |hash| in. |key| must not be in the map.
+template <typename Map>
+uint32_t FindInsertSlot(Map* map, uint64_t hash) {
+  ProbeSequence probe(H1(hash), map->capacity / Map::kGroupSize);
+  while (true) {
+    Group group(map->ctrl + probe.offset());
+    uint32_t available = group.MatchAvailable();
+    if (available)
+      return probe.offset() + LowestBit(available);
+    probe.Next();
+  }
+}
+
+template <typename Map>
+void Rehash(Map* map, uint32_t new_capacity) {
+  using Entry = typename Map::Entry;
+  ASSERT(new_capacity >= Map::kGroupSize);
+  ASSERT((new_capacity & (new_capacity - 1)) == 0);
+
+  int8_t* old_ctrl = map->ctrl;
+  Entry* old_slots = map->slots;
+  uint32_t old_capacity = map->capacity;
+
+  size_t slots_offset = SlotsOffset<Map>(new_capacity);
+  size_t bytes = slots_offset + sizeof(Entry) * new_capacity;
+  auto* memory = (uint8_t*)::operator new(
+      bytes, std::align_val_t(StorageAlignment<Map>()));
+  map->ctrl = (int8_t*)memory;
+  map->slots = (Entry*)(memory + slots_offset);
+  map->capacity = new_capacity;
+  map->tombstones = 0;
+  memset(map->ctrl, Map::kEmpty, new_capacity);
+
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old_ctrl[i] < 0)
+      continue;
+
+    Entry* entry = old_slots + i;
+    uint64_t hash = HashKey(map, entry->key);
+    uint32_t index = FindInsertSlot(map, hash);
+    map->ctrl[index] = H2(hash);
+    new (map->slots + index) Entry(std::move(*entry));
+    entry->~Entry();
+  }
+
+  if (old_ctrl)
+    ::operator delete(old_ctrl, std::align_val_t(StorageAlignment<Map>()));
+}
+
+// Makes sure one more entry can be inserted.
+template <typename Map>
+void PrepareInsert(Map* map) {
+  if (map->capacity == 0) {
+    Rehash(map, Map::kGroupSize);
+    return;
+  }
+
+  if (map->size + map->tombstones + 1 <= MaxLoad(map->capacity))
+    return;
+
+  // Mostly tombstones: cleaning them up in place is enough.
+  if (map->size + 1 <= MaxLoad(map->capacity) / 2) {
+    Rehash(map, map->capacity);
+  } else {
+    Rehash(map, map->capacity * 2);
+  }
+}
+
+// Inlined into every lookup: as a call it costs about as much as the probe.
+template <typename Map>
+ALWAYS_INLINE int64_t FindIndex(Map* map, const typename Map::Key& key,
+                                uint64_t hash) {
+  if (map->capacity == 0)
+    return -1;
+
+  int8_t h2 = H2(hash);
+  ProbeSequence probe(H1(hash), map->capacity / Map::kGroupSize);
+  while (true) {
+    Group group(map->ctrl + probe.offset());
+    for (uint32_t match = group.Match(h2); match; match &= match - 1) {
+      uint32_t index = probe.offset() + LowestBit(match);
+      if (map->slots[index].key == key)
+        return index;
+    }
+
+    // An empty slot means the key was never pushed further.
+    if (group.MatchEmpty())
+      return -1;
+    probe.Next();
+  }
+}
+
+}  // namespace flat_hash_map_internal
+
+template <typename K, typename V, typename H>
+FlatHashMap<K, V, H>::~FlatHashMap() {
+  flat_hash_map_internal::FreeStorage(this);
+}
+
+template <typename K, typename V, typename H>
+FlatHashMap<K, V, H>::FlatHashMap(FlatHashMap&& rhs)
+    : ctrl(rhs.ctrl), slots(rhs.slots), capacity(rhs.capacity),
+      size(rhs.size), tombstones(rhs.tombstones),
+      hasher(std::move(rhs.hasher)) {
+  rhs.ctrl = nullptr;
+  rhs.slots = nullptr;
+  rhs.capacity = 0;
+  rhs.size = 0;
+  rhs.tombstones = 0;
+}
+
+template <typename K, typename V, typename H>
+FlatHashMap<K, V, H>& FlatHashMap<K, V, H>::operator=(FlatHashMap&& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  this->~FlatHashMap();
+  new (this) FlatHashMap(std::move(rhs));
+  return *this;
+}
+
+template <typename K, typename V, typename H>
+V* Find(FlatHashMap<K, V, H>* map,
+        const typename FlatHashMap<K, V, H>::Key& key) {
+  using namespace flat_hash_map_internal;
+  int64_t index = FindIndex(map, key, HashKey(map, key));
+  return index >= 0 ? &map->slots[index].value : nullptr;
+}
+
+template <typename K, typename V, typename H>
+V* Insert(FlatHashMap<K, V, H>* map,
+          typename FlatHashMap<K, V, H>::Key key,
+          typename FlatHashMap<K, V, H>::Value value) {
+  using namespace flat_hash_map_internal;
+  using Entry = typename FlatHashMap<K, V, H>::Entry;
+
+  uint64_t hash = HashKey(map, key);
+  int64_t found = FindIndex(map, key, hash);
+  if (found >= 0) {
+    V* current = &map->slots[found].value;
+    *current = std::move(value);
+    return current;
+  }
+
+  PrepareInsert(map);
+  uint32_t index = FindInsertSlot(map, hash);
+  if (map->ctrl[index] == FlatHashMap<K, V, H>::kDeleted)
+    map->tombstones--;
+  map->ctrl[index] = H2(hash);
+  map->size++;
+
+  Entry* entry = new (map->slots + index) Entry{std::move(key),
+                                                std::move(value)};
+  return &entry->value;
+}
+
+template <typename K, typename V, typename H>
+V* FindOrInsert(FlatHashMap<K, V, H>* map,
+                const typename FlatHashMap<K, V, H>::Key& key) {
+  if (V* value = Find(map, key))
+    return value;
+  return Insert(map, key, V());
+}
+
+template <typename K, typename V, typename H>
+bool Erase(FlatHashMap<K, V, H>* map,
+           const typename FlatHashMap<K, V, H>::Key& key) {
+  using namespace flat_hash_map_internal;
+  using Map = FlatHashMap<K, V, H>;
+  using Entry = typename Map::Entry;
+
+  int64_t index = FindIndex(map, key, HashKey(map, key));
+  if (index < 0)
+    return false;
+
+  map->slots[index].~Entry();
+  map->size--;
+
+  // If the group still has an empty slot no probe ever continued past it, so
+  // the slot can go back to empty instead of leaving a tombstone.
+  uint32_t group_offset = (uint32_t)index & ~(Map::kGroupSize - 1);
+  if (Group(map->ctrl + group_offset).MatchEmpty()) {
+    map->ctrl[index] = Map::kEmpty;
+  } else {
+    map->ctrl[index] = Map::kDeleted;
+    map->tombstones++;
+  }
+
+  return true;
+}
+
+template <typename K, typename V, typename H>
+void Clear(FlatHashMap<K, V, H>* map) {
+  using Entry = typename FlatHashMap<K, V, H>::Entry;
+  for (uint32_t i = 0; i < map->capacity; i++) {
+    if (map->ctrl[i] >= 0)
+      map->slots[i].~Entry();
+  }
+
+  if (map->ctrl)
+    memset(map->ctrl, FlatHashMap<K, V, H>::kEmpty, map->capacity);
+  map->size = 0;
+  map->tombstones = 0;
+}
+
+template <typename K, typename V, typename H>
+void EnsureCapacity(FlatHashMap<K, V, H>* map, uint32_t count) {
+  using namespace flat_hash_map_internal;
+  uint32_t capacity = FlatHashMap<K, V, H>::kGroupSize;
+  while (MaxLoad(capacity) < count)
+    capacity *= 2;
+
+  if (capacity > map->capacity)
+    Rehash(map, capacity);
+}
+
+// *****************************************************************************
+// Iterator Implementation
+// *****************************************************************************
+
+template <typename K, typename V, typename H>
+struct FlatHashMap<K, V, H>::Iterator {
+  Iterator(FlatHashMap* map, uint32_t index) : map(map), index(index) {
+    SkipAvailable();
+  }
+
+  bool operator==(const Iterator& rhs) const { return index == rhs.index; }
+  bool operator!=(const Iterator& rhs) const { return index != rhs.index; }
+
+  Iterator& operator++() {
+    index++;
+    SkipAvailable();
+    return *this;
+  }
+
+  Entry* operator->() { return map->slots + index; }
+  Entry& operator*() { return map->slots[index]; }
+
+  void SkipAvailable() {
+    while (index < map->capacity && map->ctrl[index] < 0)
+      index++;
+  }
+
+  FlatHashMap* map;
+  uint32_t index;
+};
+
+}  // namespace warhol
@@ -5,27 +5,71 @@
 
 #include <stdint.h>
 
+#include <new>
+#include <utility>
+
+#include "warhol/memory/concurrent_arena.h"
+#include "warhol/memory/frame_allocator.h"
 #include "warhol/memory/memory_pool.h"
 #include "warhol/utils/log.h"
 
 namespace warhol {
 
+// List ------------------------------------------------------------------------
+//
+// Unrolled list: every node (chunk) is a multiple of a cache line (header
+// included), so iterating touches roughly a cache line per element block
+// instead of one per element, and pushing only allocates once every
+// |kChunkCapacity| elements.
+//
+// Chunks come either from the list's own pool or from an external |arena|
+// (eg. a frame arena, see frame_allocator.h), which the list does not own.
+// A |concurrent_arena| can be shared by lists being filled by different threads
+// (each list is still filled by a single thread).
+//
+// Lists over external memory can be joined and spliced in O(1) by relinking
+// chunks, eg. to concatenate per-thread command lists. Elements are never
+// destroyed, as the memory is owned by the arena.
+
 template <typename T>
 struct List {
-  uint32_t count = 0;
+  static constexpr size_t kCacheLineSize = 64;
+  static constexpr size_t kMinChunkElements = 8;
+
+  static constexpr size_t kChunkAlignment =
+      alignof(T) > kCacheLineSize ? alignof(T) : kCacheLineSize;
+  // |next| and |count| go first, so the elements start right after them.
+  static constexpr size_t kChunkHeaderBytes =
+      ((sizeof(void*) + sizeof(uint32_t) + alignof(T) - 1) / alignof(T)) *
+      alignof(T);
+  // The whole chunk, header included, in cache lines.
+  static constexpr size_t kChunkBytes =
+      ((kChunkHeaderBytes + sizeof(T) * kMinChunkElements +
+        kChunkAlignment - 1) / kChunkAlignment) * kChunkAlignment;
+  static constexpr uint32_t kChunkCapacity =
+      (kChunkBytes - kChunkHeaderBytes) / sizeof(T);
 
-  struct Node {
-    T value;
-    Node* next = nullptr;
+  struct alignas(kChunkAlignment) Chunk {
+    Chunk* next = nullptr;
+    uint32_t count = 0;
+    alignas(T) uint8_t storage[kChunkCapacity * sizeof(T)];
+
+    T* values() { return (T*)storage; }
   };
+  static_assert(sizeof(Chunk) == kChunkBytes);
+
+  uint32_t count = 0;
+
+  Chunk* head = nullptr;
+  Chunk* tail = nullptr;
 
-  Node* head = nullptr;
-  Node* tail = nullptr;
   MemoryPool pool = {};
+  MemoryPool* arena = nullptr;
+  ConcurrentArena* concurrent_arena = nullptr;
 
   struct Iterator;
-  Iterator begin() { return Iterator(head); }
-  Iterator end() { return nullptr; }
+  Iterator begin() { return Iterator(head, 0); }
+  Iterator end() { return Iterator(); }
 };
 
 template <typename T>
@@ -42,11 +86,47 @@ List<T> CreateList(size_t bytes) {
   return list;
 }
 
+// |arena| has to outlive the list.
+template <typename T>
+List<T> CreateList(MemoryPool* arena) {
+  ASSERT(Valid(arena));
+  List<T> list = {};
+  list.arena = arena;
+  return list;
+}
+
+// |arena| has to outlive the list.
+template <typename T>
+List<T> CreateList(ConcurrentArena* arena) {
+  ASSERT(Valid(arena));
+  List<T> list = {};
+  list.concurrent_arena = arena;
+  return list;
+}
+
+// List valid until the current frame is done (see frame_allocator.h).
+template <typename T>
+List<T> CreateFrameList() {
+  return CreateList<T>(GetFrameArena());
+}
+
+template <typename T>
+inline MemoryPool* GetPool(List<T>* list) {
+  return list->arena ? list->arena : &list->pool;
+}
+
 template <typename T>
 inline bool Empty(List<T>* list) {
   return list->count == 0;
 }
 
+// Whether the chunks live in memory the list does not own, which is what
+// permits handing them to another list.
+template <typename T>
+inline bool UsesExternalMemory(List<T>* list) {
+  return list->arena || list->concurrent_arena;
+}
+
 // Will allocate into the pool first and then create a node into the list.
 template <typename T>
 T* Push(List<T>* list);
@@ -55,45 +135,118 @@ T* Push(List<T>* list);
 template <typename T>
 T* Push(List<T>* list, T t);
 
+// Moves every element of |other| to the end of |list| in O(1). |other| is left
+// empty. Its memory has to outlive |list|.
+template <typename T>
+void Join(List<T>* list, List<T>* other);
+
+// Moves every element of |other| into |list| before |pos| (begin() puts them
+// first, end() is the same as Join). Splitting the chunk of |pos| moves at
+// most a chunk worth of elements, so this is O(1) as well. Same memory rules as
+// Join.
+template <typename T>
+void Splice(List<T>* list, typename List<T>::Iterator pos, List<T>* other);
+
 // *****************************************************************************
 // Template Implementation
 // *****************************************************************************
 
 template <typename T>
-void PushNode(List<T>* list, typename List<T>::Node* node);
+typename List<T>::Chunk* AllocateChunk(List<T>* list) {
+  using Chunk = typename List<T>::Chunk;
+  void* memory = nullptr;
+  if (list->concurrent_arena) {
+    memory = Reserve(list->concurrent_arena, sizeof(Chunk), alignof(Chunk));
+  } else {
+    MemoryPool* pool = GetPool(list);
+    ASSERT(Valid(pool));
+    memory = Reserve(pool, sizeof(Chunk), alignof(Chunk));
+  }
+
+  return new (memory) Chunk();
+}
 
-// Will allocate into the pool first and then create a node into the list.
+template <typename T>
+T* PushSlot(List<T>* list) {
+  if (!list->tail || list->tail->count == List<T>::kChunkCapacity) {
+    auto* chunk = AllocateChunk(list);
+    if (list->tail) {
+      list->tail->next = chunk;
+    } else {
+      list->head = chunk;
+    }
+    list->tail = chunk;
+  }
+
+  list->count++;
+  return list->tail->values() + list->tail->count++;
+}
+
+// Chunk memory is raw, so values are constructed in place.
 template <typename T>
 T* Push(List<T>* list) {
-  ASSERT(Valid(&list->pool));
-  auto* node = Push<typename List<T>::Node>(&list->pool);
-  PushNode(list, node);
-  return &node->value;
+  return new (PushSlot(list)) T();
 }
 
 template <typename T>
 T* Push(List<T>* list, T t) {
-  ASSERT(Valid(&list->pool));
-  auto* node = Push<typename List<T>::Node>(&list->pool);
-  PushNode(list, node);
-  node->value = std::move(t);
-  return &node->value;
+  return new (PushSlot(list)) T(std::move(t));
 }
 
 template <typename T>
-void PushNode(List<T>* list, typename List<T>::Node* node) {
-  node->next = nullptr;
-  if (Empty(list)) {
-    list->head = node;
-    list->tail = node;
-    list->count++;
+void Join(List<T>* list, List<T>* other) {
+  ASSERT(list != other);
+  ASSERT(UsesExternalMemory(other)) << "List owns its pool.";
+  if (Empty(other))
     return;
+
+  if (list->tail) {
+    list->tail->next = other->head;
+  } else {
+    list->head = other->head;
   }
+  list->tail = other->tail;
+  list->count += other->count;
+  Reset(other);
+}
 
-  ASSERT(list->tail);
-  list->tail->next = node;
-  list->tail = node;
-  list->count++;
+template <typename T>
+void Splice(List<T>* list, typename List<T>::Iterator pos, List<T>* other) {
+  using Chunk = typename List<T>::Chunk;
+  ASSERT(list != other);
+  ASSERT(UsesExternalMemory(other)) << "List owns its pool.";
+  if (Empty(other))
+    return;
+
+  // The end iterator means after the last element.
+  if (!pos.chunk) {
+    Join(list, other);
+    return;
+  }
+
+  if (pos.chunk == list->head && pos.index == 0) {
+    other->tail->next = list->head;
+    list->head = other->head;
+    list->count += other->count;
+    Reset(other);
+    return;
+  }
+
+  // There is no link back to the previous chunk, so the values from |pos| on
+  // move to a new chunk after |other| (possibly leaving |chunk| empty).
+  Chunk* chunk = pos.chunk;
+  Chunk* rest = AllocateChunk(list);
+  for (uint32_t i = pos.index; i < chunk->count; i++)
+    new (rest->values() + rest->count++) T(std::move(chunk->values()[i]));
+  chunk->count = pos.index;
+
+  rest->next = chunk->next;
+  chunk->next = other->head;
+  other->tail->next = rest;
+  if (list->tail == chunk)
+    list->tail = rest;
+  list->count += other->count;
+  Reset(other);
 }
 
 // *****************************************************************************
@@ -103,29 +256,45 @@ void PushNode(List<T>* list, typename List<T>::Node* node) {
 template <typename T>
 struct List<T>::Iterator {
   Iterator() = default;
-  Iterator(typename List<T>::Node* t) : elem(t) {}
+  Iterator(typename List<T>::Chunk* chunk, uint32_t index)
+      : chunk(chunk), index(index) {
+    SkipEmpty();
+  }
 
   DEFAULT_COPY_AND_ASSIGN(Iterator);
   DEFAULT_MOVE_AND_ASSIGN(Iterator);
 
-  bool operator==(const Iterator& rhs) const { return elem == rhs.elem; }
+  bool operator==(const Iterator& rhs) const {
+    return chunk == rhs.chunk && index == rhs.index;
+  }
 
-  bool operator!=(const Iterator& rhs) const { return elem != rhs.elem; }
+  bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
 
   Iterator& operator++() {
-    elem = elem->next;
+    index++;
+    SkipEmpty();
     return *this;
   }
 
   Iterator operator++(int) {
-    elem = elem->next;
-    return Iterator(elem->next);
+    Iterator prev = *this;
+    ++(*this);
+    return prev;
   }
 
-  T* operator->() { return &elem->value; }
-  T& operator*() { return elem->value; }
+  T* operator->() { return chunk->values() + index; }
+  T& operator*() { return chunk->values()[index]; }
+
+  // Moves to the next chunk when done with the current one.
+  void SkipEmpty() {
+    while (chunk && index >= chunk->count) {
+      chunk = chunk->next;
+      index = 0;
+    }
+  }
 
-  typename List<T>::Node* elem = nullptr;
+  typename List<T>::Chunk* chunk = nullptr;
+  uint32_t index = 0;
 };
 
 }  // namespace warhol
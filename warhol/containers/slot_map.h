@@ -0,0 +1,211 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <utility>
+
+#include "warhol/containers/array.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+// Handle ----------------------------------------------------------------------
+//
+// Index into a SlotMap plus the generation of the slot when the value was
+// inserted. |Tag| only makes handles of different resources different types
+// (eg. Handle<Mesh> vs Handle<Texture>).
+//
+// Zero-initialized handles are null: live slots always have an odd generation.
+
+template <typename Tag>
+struct Handle {
+  uint32_t index = 0;
+  uint32_t generation = 0;
+};
+
+template <typename Tag>
+inline bool Valid(Handle<Tag> handle) { return handle.generation != 0; }
+
+template <typename Tag>
+inline bool operator==(Handle<Tag> lhs, Handle<Tag> rhs) {
+  return lhs.index == rhs.index && lhs.generation == rhs.generation;
+}
+
+template <typename Tag>
+inline bool operator!=(Handle<Tag> lhs, Handle<Tag> rhs) {
+  return !(lhs == rhs);
+}
+
+// SlotMap ---------------------------------------------------------------------
+//
+// Dense array of slots, each one holding a value and its generation side by
+// side, so resolving a handle is an index and a compare: one cache miss.
+//
+// Erasing bumps the slot generation, so handles to the old value are detected
+// as stale instead of aliasing whatever reuses the slot. Free slots are chained
+// into a free list and reused before the array grows.
+//
+// Values are default constructed in every slot and moved in and out, so they
+// should be cheap for that (GPU handles, ids).
+
+template <typename T, typename Tag = T>
+struct SlotMap {
+  using Value = T;
+  using HandleType = Handle<Tag>;
+
+  static constexpr uint32_t kNoFreeSlot = UINT32_MAX;
+
+  struct Slot {
+    T value = {};
+    uint32_t generation = 0;  // Odd means live.
+    uint32_t next_free = kNoFreeSlot;
+  };
+
+  Array<Slot> slots;
+  uint32_t free_head = kNoFreeSlot;
+  uint32_t size = 0;
+
+  struct Iterator;
+  Iterator begin() { return Iterator(slots.begin(), slots.end()); }
+  Iterator end() { return Iterator(slots.end(), slots.end()); }
+};
+
+template <typename T, typename Tag>
+inline bool Empty(const SlotMap<T, Tag>* map) { return map->size == 0; }
+
+// Returns null if the handle is null or stale.
+template <typename T, typename Tag>
+T* Find(SlotMap<T, Tag>*, Handle<Tag>);
+
+template <typename T, typename Tag>
+inline bool Contains(SlotMap<T, Tag>* map, Handle<Tag> handle) {
+  return Find(map, handle) != nullptr;
+}
+
+template <typename T, typename Tag>
+Handle<Tag> Insert(SlotMap<T, Tag>*, typename SlotMap<T, Tag>::Value value);
+
+// Returns whether the handle was live. Every copy of it becomes stale.
+template <typename T, typename Tag>
+bool Erase(SlotMap<T, Tag>*, Handle<Tag>);
+
+// Erases every value. Slots (and their generations) are kept, so handles given
+// out before are stale rather than reused.
+template <typename T, typename Tag>
+void Clear(SlotMap<T, Tag>*);
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+namespace slot_map_internal {
+
+template <typename Slot>
+inline bool Live(const Slot& slot) { return (slot.generation & 1) != 0; }
+
+}  // namespace slot_map_internal
+
+template <typename T, typename Tag>
+T* Find(SlotMap<T, Tag>* map, Handle<Tag> handle) {
+  if (handle.index >= map->slots.size)
+    return nullptr;
+
+  auto& slot = map->slots.data[handle.index];
+  if (slot.generation != handle.generation ||
+      !slot_map_internal::Live(slot)) {
+    return nullptr;
+  }
+  return &slot.value;
+}
+
+template <typename T, typename Tag>
+Handle<Tag> Insert(SlotMap<T, Tag>* map,
+                   typename SlotMap<T, Tag>::Value value) {
+  using Map = SlotMap<T, Tag>;
+  uint32_t index = map->free_head;
+  if (index != Map::kNoFreeSlot) {
+    map->free_head = map->slots[index].next_free;
+  } else {
+    index = map->slots.size;
+    Push(&map->slots);
+  }
+
+  auto& slot = map->slots[index];
+  ASSERT(!slot_map_internal::Live(slot));
+  slot.value = std::move(value);
+  slot.generation++;
+  slot.next_free = Map::kNoFreeSlot;
+  map->size++;
+
+  Handle<Tag> handle;
+  handle.index = index;
+  handle.generation = slot.generation;
+  return handle;
+}
+
+template <typename T, typename Tag>
+bool Erase(SlotMap<T, Tag>* map, Handle<Tag> handle) {
+  if (!Find(map, handle))
+    return false;
+
+  auto& slot = map->slots[handle.index];
+  slot.value = {};
+  slot.generation++;
+  slot.next_free = map->free_head;
+  map->free_head = handle.index;
+  map->size--;
+  return true;
+}
+
+template <typename T, typename Tag>
+void Clear(SlotMap<T, Tag>* map) {
+  for (uint32_t i = 0; i < map->slots.size; i++) {
+    auto& slot = map->slots[i];
+    if (!slot_map_internal::Live(slot))
+      continue;
+
+    Handle<Tag> handle;
+    handle.index = i;
+    handle.generation = slot.generation;
+    Erase(map, handle);
+  }
+}
+
+// *****************************************************************************
+// Iterator Implementation
+// *****************************************************************************
+
+// Walks the live values in slot order.
+template <typename T, typename Tag>
+struct SlotMap<T, Tag>::Iterator {
+  Iterator() = default;
+  Iterator(Slot* slot, Slot* end) : slot(slot), slot_end(end) { SkipFree(); }
+
+  DEFAULT_COPY_AND_ASSIGN(Iterator);
+  DEFAULT_MOVE_AND_ASSIGN(Iterator);
+
+  bool operator==(const Iterator& rhs) const { return slot == rhs.slot; }
+  bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+
+  Iterator& operator++() {
+    slot++;
+    SkipFree();
+    return *this;
+  }
+
+  T* operator->() { return &slot->value; }
+  T& operator*() { return slot->value; }
+
+  void SkipFree() {
+    while (slot != slot_end && !slot_map_internal::Live(*slot))
+      slot++;
+  }
+
+  Slot* slot = nullptr;
+  Slot* slot_end = nullptr;
+};
+
+}  // namespace warhol
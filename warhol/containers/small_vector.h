@@ -0,0 +1,187 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <initializer_list>
+
+#include "warhol/containers/array.h"
+
+namespace warhol {
+
+// SmallVector -----------------------------------------------------------------
+//
+// Contiguous array that keeps its first |N| elements inline, so small and
+// bounded collections (mesh attributes, shape offsets) cost no allocation and
+// sit right next to their owner. Spills to the heap past |N|.
+//
+// Unlike Array, it is a value type: it can be copied.
+
+template <typename T, uint32_t N>
+struct SmallVector {
+  static_assert(N > 0, "Use Array if no inline storage is wanted.");
+
+  SmallVector() = default;
+  SmallVector(std::initializer_list<T>);
+  ~SmallVector();
+  DECLARE_COPY_AND_ASSIGN(SmallVector);
+  DECLARE_MOVE_AND_ASSIGN(SmallVector);
+
+  T* data = (T*)inline_storage;
+  uint32_t size = 0;
+  uint32_t capacity = N;
+
+  alignas(T) uint8_t inline_storage[sizeof(T) * N];
+
+  T* begin() { return data; }
+  T* end() { return data + size; }
+  const T* begin() const { return data; }
+  const T* end() const { return data + size; }
+
+  T& operator[](uint32_t index) {
+    ASSERT(index < size) << "Index " << index << ", size " << size;
+    return data[index];
+  }
+  const T& operator[](uint32_t index) const {
+    ASSERT(index < size) << "Index " << index << ", size " << size;
+    return data[index];
+  }
+};
+
+template <typename T, uint32_t N>
+inline bool Empty(const SmallVector<T, N>* vec) { return vec->size == 0; }
+
+template <typename T, uint32_t N>
+inline bool IsInline(const SmallVector<T, N>* vec) {
+  return vec->data == (T*)vec->inline_storage;
+}
+
+template <typename T, uint32_t N>
+void EnsureCapacity(SmallVector<T, N>*, uint32_t capacity);
+
+// Pushes a default constructed value.
+template <typename T, uint32_t N>
+T* Push(SmallVector<T, N>*);
+
+// Same as before but moving in a value.
+template <typename T, uint32_t N>
+T* Push(SmallVector<T, N>*, T t);
+
+template <typename T, uint32_t N>
+void Pop(SmallVector<T, N>*);
+
+// Destroys the elements but keeps the storage around.
+template <typename T, uint32_t N>
+void Reset(SmallVector<T, N>*);
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+template <typename T, uint32_t N>
+SmallVector<T, N>::SmallVector(std::initializer_list<T> list) {
+  EnsureCapacity(this, (uint32_t)list.size());
+  for (const T& t : list)
+    new (data + size++) T(t);
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N>::~SmallVector() {
+  array_internal::DestroyElements(data, size);
+  if (!IsInline(this))
+    array_internal::FreeHeap(data);
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N>::SmallVector(const SmallVector& rhs) {
+  EnsureCapacity(this, rhs.size);
+  for (const T& t : rhs)
+    new (data + size++) T(t);
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(const SmallVector& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  Reset(this);
+  EnsureCapacity(this, rhs.size);
+  for (const T& t : rhs)
+    new (data + size++) T(t);
+  return *this;
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N>::SmallVector(SmallVector&& rhs) {
+  // Heap storage can be stolen. Inline elements have to be moved over.
+  if (!IsInline(&rhs)) {
+    data = rhs.data;
+    size = rhs.size;
+    capacity = rhs.capacity;
+  } else {
+    array_internal::RelocateElements(data, rhs.data, rhs.size);
+    size = rhs.size;
+  }
+
+  rhs.data = (T*)rhs.inline_storage;
+  rhs.size = 0;
+  rhs.capacity = N;
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(SmallVector&& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  this->~SmallVector();
+  new (this) SmallVector(std::move(rhs));
+  return *this;
+}
+
+template <typename T, uint32_t N>
+void EnsureCapacity(SmallVector<T, N>* vec, uint32_t capacity) {
+  if (capacity <= vec->capacity)
+    return;
+
+  T* data = array_internal::AllocateHeap<T>(capacity);
+  array_internal::RelocateElements(data, vec->data, vec->size);
+  if (!IsInline(vec))
+    array_internal::FreeHeap(vec->data);
+  vec->data = data;
+  vec->capacity = capacity;
+}
+
+template <typename T, uint32_t N>
+T* Push(SmallVector<T, N>* vec) {
+  if (vec->size == vec->capacity) {
+    EnsureCapacity(vec, array_internal::NextCapacity(vec->capacity,
+                                                     vec->size + 1));
+  }
+  return new (vec->data + vec->size++) T();
+}
+
+template <typename T, uint32_t N>
+T* Push(SmallVector<T, N>* vec, T t) {
+  if (vec->size == vec->capacity) {
+    EnsureCapacity(vec, array_internal::NextCapacity(vec->capacity,
+                                                     vec->size + 1));
+  }
+  return new (vec->data + vec->size++) T(std::move(t));
+}
+
+template <typename T, uint32_t N>
+void Pop(SmallVector<T, N>* vec) {
+  ASSERT(!Empty(vec));
+  vec->size--;
+  array_internal::DestroyElements(vec->data + vec->size, 1);
+}
+
+template <typename T, uint32_t N>
+void Reset(SmallVector<T, N>* vec) {
+  array_internal::DestroyElements(vec->data, vec->size);
+  vec->size = 0;
+}
+
+}  // namespace warhol
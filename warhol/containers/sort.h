@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <string>
+#include <type_traits>
 
 namespace warhol {
 
@@ -21,4 +24,58 @@ inline void SwapValues(std::string& a, std::string& b) {
   a.swap(b);
 }
 
+// Radix Sort ------------------------------------------------------------------
+//
+// Stable LSD radix sort over the 64 bit key |get_key| gives for each value, one
+// byte per pass. It does at most 8 passes over the data whatever the key
+// distribution is, and the passes where every key has the same byte (eg. unused
+// top bits) are skipped.
+//
+// |scratch| has to hold |count| values. The sorted values end up in |values|.
+
+template <typename T, typename GetKey>
+void RadixSort(T* values, T* scratch, uint32_t count, GetKey get_key) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Values are shuffled around as raw memory.");
+  if (count < 2)
+    return;
+
+  // All the histograms are built in one go.
+  uint32_t histograms[8][256] = {};
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t key = get_key(values[i]);
+    for (uint32_t pass = 0; pass < 8; pass++)
+      histograms[pass][(key >> (pass * 8)) & 0xff]++;
+  }
+
+  T* src = values;
+  T* dst = scratch;
+  for (uint32_t pass = 0; pass < 8; pass++) {
+    uint32_t shift = pass * 8;
+    uint32_t* histogram = histograms[pass];
+    if (histogram[(get_key(src[0]) >> shift) & 0xff] == count)
+      continue;
+
+    // Turn the counts into the starting offset of each bucket.
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t bucket_count = histogram[i];
+      histogram[i] = offset;
+      offset += bucket_count;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+      dst[histogram[(get_key(src[i]) >> shift) & 0xff]++] = src[i];
+
+    T* tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != values) {
+    for (uint32_t i = 0; i < count; i++)
+      values[i] = src[i];
+  }
+}
+
 }  // namespace warhol
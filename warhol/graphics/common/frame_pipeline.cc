@@ -0,0 +1,132 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/graphics/common/frame_pipeline.h"
+
+#include "warhol/memory/frame_allocator.h"
+#include "warhol/memory/memory_tracker.h"
+#include "warhol/platform/platform.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+FramePipeline::Frame* NextFrame(FramePipeline* pipeline) {
+  uint64_t index = pipeline->frame_index++;
+  auto* frame = pipeline->frames + (index % FramePipeline::kMaxFramesInFlight);
+  frame->index = index;
+  return frame;
+}
+
+void Simulate(FramePipeline* pipeline, FramePipeline::Frame* frame) {
+  uint64_t start = GetNanoseconds();
+
+  ResetMemoryPool(&frame->arena);
+  frame->commands = CreateList<RenderCommand>(&frame->arena);
+  pipeline->simulate(pipeline->user_data, frame);
+
+  pipeline->last_simulate_ns = GetNanoseconds() - start;
+}
+
+void SimulateJob(void* user_data) {
+  auto* pipeline = (FramePipeline*)user_data;
+  Simulate(pipeline, pipeline->simulating_frame);
+}
+
+void WaitForSimulation(FramePipeline* pipeline) {
+  if (!pipeline->simulating_frame)
+    return;
+
+  uint64_t start = GetNanoseconds();
+  WaitForCounter(pipeline->job_system, &pipeline->counter);
+  pipeline->last_wait_ns = GetNanoseconds() - start;
+
+  pipeline->ready_frame = pipeline->simulating_frame;
+  pipeline->simulating_frame = nullptr;
+}
+
+}  // namespace
+
+FramePipeline::~FramePipeline() {
+  if (Valid(this))
+    ShutdownFramePipeline(this);
+}
+
+bool InitFramePipeline(FramePipeline* pipeline,
+                       const FramePipelineConfig& config) {
+  ASSERT(!Valid(pipeline));
+  if (!config.simulate) {
+    LOG(ERROR) << "No simulate function given.";
+    return false;
+  }
+
+  if (config.frames_in_flight > 1 && !config.job_system) {
+    LOG(ERROR) << "Pipelining frames requires a job system.";
+    return false;
+  }
+
+  pipeline->job_system = config.job_system;
+  pipeline->simulate = config.simulate;
+  pipeline->user_data = config.user_data;
+  SetFramesInFlight(pipeline, config.frames_in_flight);
+
+  for (auto& frame : pipeline->frames)
+    InitMemoryPool(&frame.arena, config.arena_size);
+
+  return true;
+}
+
+void ShutdownFramePipeline(FramePipeline* pipeline) {
+  ASSERT(Valid(pipeline));
+  WaitForSimulation(pipeline);
+
+  for (auto& frame : pipeline->frames) {
+    frame.commands = {};
+    ShutdownMemoryPool(&frame.arena);
+  }
+
+  pipeline->ready_frame = nullptr;
+  pipeline->simulate = nullptr;
+}
+
+void SetFramesInFlight(FramePipeline* pipeline, uint32_t frames_in_flight) {
+  ASSERT(frames_in_flight >= 1 &&
+         frames_in_flight <= FramePipeline::kMaxFramesInFlight);
+  ASSERT(frames_in_flight == 1 || pipeline->job_system);
+  ASSERT(!pipeline->simulating_frame) << "Called in the middle of a frame.";
+  pipeline->frames_in_flight = frames_in_flight;
+}
+
+FramePipeline::Frame* AdvanceFramePipeline(FramePipeline* pipeline) {
+  ASSERT(Valid(pipeline));
+  ASSERT(!pipeline->simulating_frame) << "Previous frame was not finished.";
+  AdvanceFrameAllocators();
+  MemoryTrackerNewFrame();
+
+  // The first frame (or the ones after going back to serial) have to be
+  // simulated right here.
+  FramePipeline::Frame* frame = pipeline->ready_frame;
+  if (!frame) {
+    frame = NextFrame(pipeline);
+    Simulate(pipeline, frame);
+  }
+  pipeline->ready_frame = nullptr;
+
+  if (pipeline->frames_in_flight > 1) {
+    pipeline->simulating_frame = NextFrame(pipeline);
+
+    Job job = {SimulateJob, pipeline};
+    job.priority = JobPriority::kFrameCritical;
+    PushJob(pipeline->job_system, job, &pipeline->counter);
+  }
+
+  return frame;
+}
+
+void FinishFrame(FramePipeline* pipeline) {
+  ASSERT(Valid(pipeline));
+  WaitForSimulation(pipeline);
+}
+
+}  // namespace warhol
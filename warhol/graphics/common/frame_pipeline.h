@@ -0,0 +1,115 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "warhol/containers/list.h"
+#include "warhol/graphics/common/render_command.h"
+#include "warhol/memory/memory_pool.h"
+#include "warhol/multithreading/job_system.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// FramePipeline ---------------------------------------------------------------
+//
+// Overlaps the simulation of frame N+1 with the rendering of frame N:
+//
+//   while (running) {
+//     PollEvents();                                     // Nothing simulating.
+//     auto* frame = AdvanceFramePipeline(&pipeline);    // Kicks N+1.
+//     RendererExecuteCommands(&renderer, &frame->commands);
+//     FinishFrame(&pipeline);                           // Waits for N+1.
+//   }
+//
+// The simulation runs as a frame-critical job and fills a Frame: its command
+// list plus an arena for anything the commands point to (uniforms, etc.).
+// There is one Frame per frame in flight, so the frame being rendered is never
+// touched by the simulation of the next one.
+//
+// Between FinishFrame and the next AdvanceFramePipeline no simulation is
+// running, so that is where state shared with the main thread (input, window
+// events) can be safely updated.
+//
+// |frames_in_flight| is the latency/throughput knob:
+//
+// - 1: Serial. Each frame is simulated on the calling thread right before being
+//      rendered. Lowest latency, and the simulation can use the renderer.
+// - 2: Pipelined. Frame time becomes max(simulate, render) instead of their
+//      sum, at the cost of one frame of latency. The simulation must not touch
+//      the renderer (GL context) nor the frame being rendered.
+//
+// It can be changed between frames with SetFramesInFlight.
+
+struct FramePipeline {
+  static constexpr uint32_t kMaxFramesInFlight = 2;
+
+  struct Frame {
+    uint64_t index = 0;
+
+    // Reset right before the frame is simulated, so anything allocated from it
+    // is valid until the frame is done rendering. |commands| live in it too.
+    MemoryPool arena;
+    List<RenderCommand> commands;
+  };
+
+  // Fills |frame|. Runs within a job when pipelined.
+  using SimulateFunc = void (*)(void* user_data, Frame* frame);
+
+  FramePipeline() = default;
+  ~FramePipeline();
+  DELETE_COPY_AND_ASSIGN(FramePipeline);
+  DELETE_MOVE_AND_ASSIGN(FramePipeline);
+
+  JobSystem* job_system = nullptr;
+  SimulateFunc simulate = nullptr;
+  void* user_data = nullptr;
+
+  uint32_t frames_in_flight = 0;
+
+  Frame frames[kMaxFramesInFlight];
+  uint64_t frame_index = 0;         // Of the next frame to be simulated.
+
+  Frame* ready_frame = nullptr;     // Simulated, waiting to be rendered.
+  Frame* simulating_frame = nullptr;
+  JobCounter counter;
+
+  // Read them after FinishFrame.
+  uint64_t last_simulate_ns = 0;
+  uint64_t last_wait_ns = 0;        // How long FinishFrame waited for the sim.
+};
+
+struct FramePipelineConfig {
+  uint32_t frames_in_flight = 1;
+  size_t arena_size = 0;            // In bytes. Holds the commands too.
+
+  // Only required when pipelining.
+  JobSystem* job_system = nullptr;
+
+  FramePipeline::SimulateFunc simulate = nullptr;
+  void* user_data = nullptr;
+};
+
+inline bool Valid(FramePipeline* pipeline) { return !!pipeline->simulate; }
+
+bool InitFramePipeline(FramePipeline*, const FramePipelineConfig&);
+
+// Waits for any frame being simulated. RAII semantics will take care of this.
+void ShutdownFramePipeline(FramePipeline*);
+
+// Between frames only. |frames_in_flight| goes from 1 to kMaxFramesInFlight.
+void SetFramesInFlight(FramePipeline*, uint32_t frames_in_flight);
+
+// Returns the frame to be rendered now. If pipelining, starts simulating the
+// next one. Also advances the frame allocators (see frame_allocator.h) and
+// the memory tracker frame.
+FramePipeline::Frame* AdvanceFramePipeline(FramePipeline*);
+
+// Called once the frame is done rendering. Waits for the next frame's
+// simulation to be done.
+void FinishFrame(FramePipeline*);
+
+}  // namespace warhol
@@ -5,6 +5,7 @@
 
 #include <atomic>
 #include <unordered_map>
+#include <vector>
 
 #include <third_party/tiny_obj_loader/tiny_obj_loader.h>
 
@@ -21,6 +22,19 @@ size_t Hash(const Vertex& vertex) {
          (Hash(vertex.uv) << 1);
 }
 
+void InitMeshPool(MemoryPool* pool, const char* name, size_t size,
+                  MeshPoolType type) {
+  ASSERT(!Valid(pool));
+  pool->name = name;
+  if (type == MeshPoolType::kFixed || size < MemoryPool::kCommitGranularity) {
+    InitMemoryPool(pool, size);
+    return;
+  }
+
+  if (!InitVirtualMemoryPool(pool, size))
+    NOT_REACHED() << "Could not reserve the " << name << " pool.";
+}
+
 }  // namespace
 
 Mesh::~Mesh() {
@@ -49,13 +63,16 @@ bool LoadMesh(const std::string_view& model_path, Mesh* mesh) {
   // TODO: Precalculate the size needed instead of copying everything over...
   //       twice!
 
-  // We reserve a huuuuge memory pool for the vertices and indices.
+  // We reserve a huuuuge memory pool for the vertices and indices. Only what
+  // the model actually uses gets committed.
   MemoryPool vert_pool;
-  InitMemoryPool(&vert_pool, MEGABYTES(64));
+  if (!InitVirtualMemoryPool(&vert_pool, MEGABYTES(64)))
+    return false;
   size_t vert_count = 0;
 
   MemoryPool index_pool;
-  InitMemoryPool(&index_pool, MEGABYTES(16));
+  if (!InitVirtualMemoryPool(&index_pool, MEGABYTES(16)))
+    return false;
   size_t index_count = 0;
 
   for (const auto& shape : shapes) {
@@ -88,11 +105,11 @@ bool LoadMesh(const std::string_view& model_path, Mesh* mesh) {
   //       exact amount.
   InitMeshPools(mesh, Used(&vert_pool), Used(&index_pool));
 
-  memcpy(mesh->vertices.data.get(), vert_pool.data.get(), Used(&vert_pool));
+  Push(&mesh->vertices, vert_pool.data.get(), Used(&vert_pool));
   mesh->vertex_size = sizeof(Vertex);
   mesh->vertex_count = vert_count;
 
-  memcpy(mesh->indices.data.get(), index_pool.data.get(), Used(&index_pool));
+  Push(&mesh->indices, index_pool.data.get(), Used(&index_pool));
   mesh->index_count = index_count;
 
   mesh->uuid = GetNextMeshUUID();
@@ -104,24 +121,33 @@ bool LoadMesh(const std::string_view& model_path, Mesh* mesh) {
   return mesh;
 }
 
-void InitMeshPools(Mesh* mesh, size_t vert_size, size_t index_size) {
+void InitMeshPools(Mesh* mesh, size_t vert_size, size_t index_size,
+                   MeshPoolType type) {
   LOG(DEBUG) << "Initializing mesh pools. Vertex: " << vert_size << " ("
              << BytesToString(vert_size) << ")"
              << ", indices: " << index_size << " (" << BytesToString(index_size)
              << ").";
-  ASSERT(!Valid(&mesh->vertices));
-  mesh->vertices.name = "Vertex";
-  InitMemoryPool(&mesh->vertices, vert_size);
-  ASSERT(!Valid(&mesh->indices));
-  mesh->indices.name = "Indices";
-  InitMemoryPool(&mesh->indices, index_size);
+  InitMeshPool(&mesh->vertices, "Vertex", vert_size, type);
+  InitMeshPool(&mesh->indices, "Indices", index_size, type);
 }
 
 uint32_t AttributesSize(Mesh* mesh) {
   uint32_t total = 0;
   for (auto & attribute : mesh->attributes) {
     ASSERT(attribute.type != AttributeType::kLast);
-    total += (uint32_t)attribute.type * attribute.count;
+    if (attribute.divisor == 0)
+      total += (uint32_t)attribute.type * attribute.count;
+  }
+
+  return total;
+}
+
+uint32_t InstanceAttributesSize(Mesh* mesh) {
+  uint32_t total = 0;
+  for (auto & attribute : mesh->attributes) {
+    ASSERT(attribute.type != AttributeType::kLast);
+    if (attribute.divisor > 0)
+      total += (uint32_t)attribute.type * attribute.count;
   }
 
   return total;
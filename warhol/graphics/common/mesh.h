@@ -7,8 +7,9 @@
 
 #include <string>
 #include <optional>
-#include <vector>
 
+#include "warhol/containers/small_vector.h"
+#include "warhol/graphics/common/resource_handles.h"
 #include "warhol/math/vec.h"
 #include "warhol/memory/memory_pool.h"
 #include "warhol/memory/memory_tracker.h"
@@ -41,6 +42,11 @@ struct Attribute {
 
   // Whether the attribute data should be normalized when sent to the GPU.
   bool normalized = false;
+
+  // Zero means per vertex. Otherwise the attribute is read from the per
+  // instance stream of the draw (see MeshRenderAction::instance_count) and
+  // advances once every |divisor| instances.
+  uint32_t divisor = 0;
 };
 inline uint32_t GetSize(Attribute* attribute) {
   return (uint32_t)attribute->type * attribute->count;
@@ -50,7 +56,7 @@ struct Mesh {
   RAII_CONSTRUCTORS(Mesh);
 
   ClearOnMove<uint64_t> uuid = 0;     //  Zero is reserved.
-  ClearOnMove<bool> staged = false;
+  ClearOnMove<MeshHandle> handle;     // Set by the renderer when staged.
 
   const char* name;
 
@@ -62,15 +68,28 @@ struct Mesh {
   uint32_t index_count = 0;
 
   // Attributes are in order of how they appear in the shader layout.
-  std::vector<Attribute> attributes;
+  // Attributes with more than 4 components (eg. a mat4 as 16 floats) take one
+  // location per 4 of them.
+  SmallVector<Attribute, 4> attributes;
 
   bool loaded = false;
 };
 
-inline bool Staged(Mesh* mesh) { return mesh->staged.value; }
+inline bool Staged(Mesh* mesh) { return mesh->handle.has_value(); }
 
 bool LoadMesh(const std::string_view&, Mesh*);
-void InitMeshPools(Mesh*, size_t vert_size, size_t index_size);
+
+// kFixed pools are committed up front, which suits small meshes and meshes of
+// a known size (eg. LoadMesh). kScratch pools are refilled every frame and
+// sized for the worst case, so they only reserve address space and commit what
+// gets used (see InitVirtualMemoryPool). Scratch pools smaller than a commit
+// granule gain nothing from that and are committed anyway.
+enum class MeshPoolType {
+  kFixed,
+  kScratch,
+};
+void InitMeshPools(Mesh*, size_t vert_size, size_t index_size,
+                   MeshPoolType = MeshPoolType::kFixed);
 
 inline bool Valid(Mesh* mesh) { return mesh->uuid.value != 0; }
 
@@ -98,20 +117,21 @@ inline void PushIndices(Mesh* mesh, uint32_t* data, size_t count) {
 
 inline void PushIndicesWithOffset(Mesh* mesh, uint32_t* data, size_t count,
                                   size_t offset) {
-  MemoryPool* pool = &mesh->indices;
   uint32_t* src = data;
-  uint32_t* dst = (uint32_t*)pool->current;
-  ASSERT((uint8_t*)(dst + count) < pool->data.get() + pool->size);
+  uint32_t* dst = (uint32_t*)Reserve(&mesh->indices, count * sizeof(uint32_t),
+                                     alignof(uint32_t));
   for (size_t i = 0; i < count; i++) {
     uint32_t val = *src++ + offset;
     *dst++ = val;
   }
-  pool->current = (uint8_t*)dst;
 
   mesh->index_count += count;
 }
 
+// Size of a vertex (attributes without divisor).
 uint32_t AttributesSize(Mesh* mesh);
+// Size of an instance (attributes with a divisor). Zero if not instanced.
+uint32_t InstanceAttributesSize(Mesh* mesh);
 
 // Thread safe. Will advance the UUID.
 uint64_t GetNextMeshUUID();
@@ -3,6 +3,10 @@
 
 #include "warhol/graphics/common/render_command.h"
 
+#include <string.h>
+
+#include "warhol/containers/sort.h"
+#include "warhol/utils/log.h"
 #include "warhol/utils/string.h"
 
 namespace warhol {
@@ -16,4 +20,97 @@ std::string ToString(IndexRange range) {
 
 RenderCommand::~RenderCommand() = default;
 
+// Sort Keys -------------------------------------------------------------------
+
+namespace {
+
+constexpr uint32_t kResourceBits = 12;
+constexpr uint32_t kDepthBits = 23;
+constexpr uint64_t kResourceMask = (1ull << kResourceBits) - 1;
+constexpr uint64_t kDepthMask = (1ull << kDepthBits) - 1;
+
+constexpr uint32_t kLayerShift = 64 - kRenderLayerBits;
+constexpr uint32_t kTranslucentShift = kLayerShift - 1;
+
+// Positive floats keep their order when their bits are compared as integers,
+// so the top bits after the (zero) sign are an ordered depth.
+uint64_t QuantizeDepth(float depth) {
+  if (!(depth > 0.0f))
+    return 0;
+
+  uint32_t bits;
+  memcpy(&bits, &depth, sizeof(bits));
+  return (bits >> (31 - kDepthBits)) & kDepthMask;
+}
+
+// Packs shader | texture | mesh.
+uint64_t StateBits(RenderCommand* command, MeshRenderAction* action) {
+  uint64_t shader = command->shader.index & kResourceMask;
+  uint64_t texture = action->textures ? action->textures[0].index : 0;
+  uint64_t mesh = action->mesh.index & kResourceMask;
+  return (shader << (2 * kResourceBits)) |
+         ((texture & kResourceMask) << kResourceBits) |
+         mesh;
+}
+
+}  // namespace
+
+uint64_t GetSortKey(RenderCommand* command, MeshRenderAction* action) {
+  ASSERT(command->layer < (1 << kRenderLayerBits));
+  uint64_t key = (uint64_t)command->layer << kLayerShift;
+  if (command->preserve_order)
+    return key;
+
+  uint64_t depth = QuantizeDepth(action->depth);
+  if (!command->config.blend_enabled)
+    return key | (StateBits(command, action) << kDepthBits) | depth;
+
+  key |= 1ull << kTranslucentShift;
+  key |= (kDepthMask - depth) << (3 * kResourceBits);
+  return key | StateBits(command, action);
+}
+
+namespace {
+
+uint32_t CountDraws(RenderCommand* command) {
+  switch (command->type) {
+    case RenderCommandType::kMesh:
+      return command->mesh_actions.size;
+    case RenderCommandType::kNoop:
+      return 0;
+    case RenderCommandType::kLast:
+      break;
+  }
+
+  NOT_REACHED() << "Invalid render command type: " << (uint32_t)command->type;
+  return 0;
+}
+
+}  // namespace
+
+Array<RenderDraw> SortDraws(List<RenderCommand>* commands) {
+  uint32_t draw_count = 0;
+  for (RenderCommand& command : *commands)
+    draw_count += CountDraws(&command);
+
+  auto draws = CreateFrameArray<RenderDraw>(draw_count);
+  for (RenderCommand& command : *commands) {
+    // Every other type was validated by CountDraws.
+    if (command.type != RenderCommandType::kMesh)
+      continue;
+
+    for (MeshRenderAction& action : command.mesh_actions) {
+      RenderDraw* draw = Push(&draws);
+      draw->key = GetSortKey(&command, &action);
+      draw->command = &command;
+      draw->action = &action;
+    }
+  }
+
+  auto scratch = CreateFrameArray<RenderDraw>(draw_count);
+  RadixSort(draws.data, scratch.data, draws.size,
+            [](const RenderDraw& draw) { return draw.key; });
+  return draws;
+}
+
 }  // namespace warhol
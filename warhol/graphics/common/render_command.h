@@ -7,16 +7,15 @@
 
 #include <memory>
 
+#include "warhol/containers/array.h"
 #include "warhol/containers/list.h"
+#include "warhol/graphics/common/resource_handles.h"
 #include "warhol/math/vec.h"
 #include "warhol/utils/log.h"
 
 namespace warhol {
 
 struct Camera;
-struct Mesh;
-struct Shader;
-struct Texture;
 
 // Index Range -----------------------------------------------------------------
 //
@@ -60,7 +59,7 @@ std::string ToString(IndexRange);
 // RenderCommand ---------------------------------------------------------------
 
 struct MeshRenderAction {
-  Mesh* mesh = nullptr;
+  MeshHandle mesh;
 
   Int4 scissor;
   IndexRange index_range;
@@ -68,7 +67,17 @@ struct MeshRenderAction {
   // The counts of this are defined in the corresponding shader.
   uint8_t* vert_uniforms = nullptr;
   uint8_t* frag_uniforms = nullptr;
-  Texture* textures = nullptr;
+  TextureHandle* textures = nullptr;
+
+  // Distance to the camera. Only used to order draws (see GetSortKey).
+  float depth = 0.0f;
+
+  // Instancing: when non-zero, |index_range| is drawn |instance_count| times in
+  // a single call. |instance_data| holds that many instances laid out as the
+  // mesh's attributes with a divisor (see InstanceAttributesSize), and has to
+  // live until the commands are executed (eg. frame memory).
+  uint32_t instance_count = 0;
+  uint8_t* instance_data = nullptr;
 };
 
 enum class RenderCommandType {
@@ -86,6 +95,26 @@ struct RenderCommandConfig {
   bool wireframe_mode = false;
 };
 
+inline bool operator==(const RenderCommandConfig& lhs,
+                       const RenderCommandConfig& rhs) {
+  return lhs.blend_enabled == rhs.blend_enabled &&
+         lhs.cull_faces == rhs.cull_faces &&
+         lhs.depth_test == rhs.depth_test &&
+         lhs.scissor_test == rhs.scissor_test &&
+         lhs.wireframe_mode == rhs.wireframe_mode;
+}
+
+inline bool operator!=(const RenderCommandConfig& lhs,
+                       const RenderCommandConfig& rhs) {
+  return !(lhs == rhs);
+}
+
+// Layers are drawn in order. Within a layer, draws are sorted to share state.
+constexpr uint32_t kRenderLayerBits = 4;
+constexpr uint8_t kBackgroundRenderLayer = 0;
+constexpr uint8_t kDefaultRenderLayer = 1;
+constexpr uint8_t kUIRenderLayer = (1 << kRenderLayerBits) - 1;
+
 struct RenderCommand {
   RAII_CONSTRUCTORS(RenderCommand);
 
@@ -95,9 +124,44 @@ struct RenderCommand {
   RenderCommandConfig config;
 
   Camera* camera;
-  Shader* shader;
+  ShaderHandle shader;
+
+  uint8_t layer = kDefaultRenderLayer;
+  // Draw the actions in submission order instead of sorting them by state.
+  // Needed when the actions paint over each other without depth testing, like
+  // UI does.
+  bool preserve_order = false;
 
-  List<MeshRenderAction> mesh_actions;
+  Array<MeshRenderAction> mesh_actions;
 };
 
+// Sort Keys -------------------------------------------------------------------
+//
+// Every draw (a mesh action within a command) gets a 64 bit key and the backend
+// executes them in key order, so that neighbouring draws share as much GPU
+// state (program, textures, VAO) as possible.
+//
+// Opaque:      | layer (4) | 0 | shader (12) | texture (12) | mesh (12) |
+//              | depth (23), near to far |
+// Translucent: | layer (4) | 1 | depth (23), far to near |
+//              | shader (12) | texture (12) | mesh (12) |
+//
+// Resources are identified by the low bits of their handle index. Translucent
+// draws have to be blended back to front, so depth goes before state.
+// Commands that preserve order only get their layer bits: as the sort is
+// stable, their draws stay in submission order.
+
+uint64_t GetSortKey(RenderCommand*, MeshRenderAction*);
+
+struct RenderDraw {
+  uint64_t key = 0;
+  RenderCommand* command = nullptr;
+  MeshRenderAction* action = nullptr;
+};
+
+// Gathers the draws of every mesh command in |commands| into a frame array
+// (see frame_allocator.h), sorted by key. Noop commands have no draws; any
+// other type is a bug and fails loudly.
+Array<RenderDraw> SortDraws(List<RenderCommand>* commands);
+
 }  // namespace warhol
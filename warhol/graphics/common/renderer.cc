@@ -7,6 +7,7 @@
 
 #include "warhol/utils/log.h"
 #include "warhol/graphics/common/renderer_backend.h"
+#include "warhol/memory/memory_tracker.h"
 #include "warhol/graphics/common/mesh.h"
 #include "warhol/graphics/common/shader.h"
 #include "warhol/graphics/common/texture.h"
@@ -78,26 +79,33 @@ void ShutdownRenderer(Renderer* renderer) {
 
 bool RendererStageMesh(Renderer* renderer, Mesh* mesh) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kMeshes);
   ASSERT(mesh->uuid.has_value());
+  ASSERT(!Staged(mesh));
 
-  return renderer->backend->StageMesh(mesh);
+  mesh->handle = renderer->backend->StageMesh(mesh);
+  return Staged(mesh);
 }
 
 void RendererUnstageMesh(Renderer* renderer, Mesh* mesh) {
   ASSERT(Valid(renderer));
-  renderer->backend->UnstageMesh(mesh);
+  SCOPED_ALLOCATION_TAG(kMeshes);
+  renderer->backend->UnstageMesh(mesh->handle.value);
+  mesh->handle.clear();
 }
 
 bool RendererIsMeshStaged(Renderer* renderer, Mesh* mesh) {
   ASSERT(Valid(renderer));
-  return renderer->backend->IsMeshStaged(mesh);
+  return renderer->backend->IsMeshStaged(mesh->handle.value);
 }
 
 bool RendererUploadMeshRange(Renderer* renderer, Mesh* mesh,
                              IndexRange vertex_range,
                              IndexRange index_range) {
   ASSERT(Valid(renderer));
-  return renderer->backend->UploadMeshRange(mesh, vertex_range, index_range);
+  SCOPED_ALLOCATION_TAG(kMeshes);
+  return renderer->backend->UploadMeshRange(mesh->handle.value, mesh,
+                                            vertex_range, index_range);
 }
 
 // Shader ----------------------------------------------------------------------
@@ -108,26 +116,32 @@ bool RendererParseShader(Renderer* renderer,
                          const std::string& frag_name,
                          Shader* out) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kShaders);
   return renderer->backend->ParseShader(renderer, paths, vert_name,
                                         frag_name, out);
 }
 
 bool RendererStageShader(Renderer* renderer, Shader* shader) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kShaders);
   ASSERT(Valid(shader));
   ASSERT(Loaded(shader));
+  ASSERT(!Staged(shader));
 
-  return renderer->backend->StageShader(shader);
+  shader->handle = renderer->backend->StageShader(shader);
+  return Staged(shader);
 };
 
 void RendererUnstageShader(Renderer* renderer, Shader* shader) {
   ASSERT(Valid(renderer));
-  renderer->backend->UnstageShader(shader);
+  SCOPED_ALLOCATION_TAG(kShaders);
+  renderer->backend->UnstageShader(shader->handle.value);
+  shader->handle.clear();
 };
 
 bool RendererIsShaderStaged(Renderer* renderer, Shader* shader) {
   ASSERT(Valid(renderer));
-  return renderer->backend->IsShaderStaged(shader);
+  return renderer->backend->IsShaderStaged(shader->handle.value);
 }
 
 bool RendererLoadShader(Renderer* renderer, BasePaths* paths,
@@ -146,37 +160,45 @@ bool RendererLoadShader(Renderer* renderer, BasePaths* paths,
 bool RendererStageTexture(Renderer* renderer, Texture* texture,
                           StageTextureConfig* config) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kTextures);
   ASSERT(Valid(texture));
   ASSERT(Loaded(texture));
+  ASSERT(!Staged(texture));
 
-  return renderer->backend->StageTexture(texture, config);
+  texture->handle = renderer->backend->StageTexture(texture, config);
+  return Staged(texture);
 }
 
 void RendererUnstageTexture(Renderer* renderer, Texture* texture) {
   ASSERT(Valid(renderer));
-  renderer->backend->UnstageTexture(texture);
+  SCOPED_ALLOCATION_TAG(kTextures);
+  renderer->backend->UnstageTexture(texture->handle.value);
+  texture->handle.clear();
 }
 
 bool RendererIsTextureStaged(Renderer* renderer, Texture* texture) {
   ASSERT(Valid(renderer));
-  return renderer->backend->IsTextureStaged(texture);
+  return renderer->backend->IsTextureStaged(texture->handle.value);
 }
 
 // Frame Lifetime --------------------------------------------------------------
 
 void RendererStartFrame(Renderer* renderer) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kRenderer);
   renderer->backend->StartFrame(renderer);
 }
 
 void RendererExecuteCommands(Renderer* renderer,
                              List<RenderCommand>* commands) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kRenderer);
   renderer->backend->ExecuteCommands(renderer, commands);
 }
 
 void RendererEndFrame(Renderer* renderer) {
   ASSERT(Valid(renderer));
+  SCOPED_ALLOCATION_TAG(kRenderer);
   renderer->backend->EndFrame(renderer);
 }
 
@@ -18,6 +18,9 @@ struct Texture;
 struct Window;
 
 // Abstract interface all graphics backends must implement.
+//
+// Staging returns the handle the resource is referred by from then on (a null
+// handle on failure). The front-end stores it in the resource.
 
 struct RendererBackend {
   virtual ~RendererBackend() = default;
@@ -27,11 +30,12 @@ struct RendererBackend {
   virtual bool Init(Renderer*, Window*) = 0;
   virtual void Shutdown() = 0;
 
-  virtual bool StageMesh(Mesh*) = 0;
-  virtual void UnstageMesh(Mesh*) = 0;
-  virtual bool IsMeshStaged(Mesh*) = 0;
+  virtual MeshHandle StageMesh(Mesh*) = 0;
+  virtual void UnstageMesh(MeshHandle) = 0;
+  virtual bool IsMeshStaged(MeshHandle) = 0;
 
-  virtual bool UploadMeshRange(Mesh*,
+  // Uploads the data of |mesh| into the buffers of |handle|.
+  virtual bool UploadMeshRange(MeshHandle, Mesh*,
                                IndexRange vertex_range = {},
                                IndexRange index_range = {}) = 0;
 
@@ -41,13 +45,13 @@ struct RendererBackend {
                            const std::string& vert_name,
                            const std::string& frag_name,
                            Shader* out) = 0;
-  virtual bool StageShader(Shader*) = 0;
-  virtual void UnstageShader(Shader*) = 0;
-  virtual bool IsShaderStaged(Shader*) = 0;
+  virtual ShaderHandle StageShader(Shader*) = 0;
+  virtual void UnstageShader(ShaderHandle) = 0;
+  virtual bool IsShaderStaged(ShaderHandle) = 0;
 
-  virtual bool StageTexture(Texture*, StageTextureConfig*) = 0;
-  virtual void UnstageTexture(Texture*) = 0;
-  virtual bool IsTextureStaged(Texture*) = 0;
+  virtual TextureHandle StageTexture(Texture*, StageTextureConfig*) = 0;
+  virtual void UnstageTexture(TextureHandle) = 0;
+  virtual bool IsTextureStaged(TextureHandle) = 0;
 
   virtual void StartFrame(Renderer*) = 0;
   virtual void ExecuteCommands(Renderer*, List<RenderCommand>*) = 0;
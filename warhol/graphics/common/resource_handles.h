@@ -0,0 +1,25 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include "warhol/containers/slot_map.h"
+
+namespace warhol {
+
+struct Mesh;
+struct Shader;
+struct Texture;
+
+// Handles given by the renderer backend when a resource is staged. They index
+// the backend's slot maps directly, so render commands refer to GPU resources
+// through these instead of the resource UUIDs.
+//
+// A handle that outlives the unstaging of its resource is stale and resolves
+// to nothing, rather than to whatever was staged afterwards.
+
+using MeshHandle = Handle<Mesh>;
+using ShaderHandle = Handle<Shader>;
+using TextureHandle = Handle<Texture>;
+
+}  // namespace warhol
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "warhol/assets/asset_paths.h"
+#include "warhol/graphics/common/resource_handles.h"
 #include "warhol/utils/clear_on_move.h"
 #include "warhol/utils/macros.h"
 
@@ -52,6 +53,7 @@ bool CalculateUniformLayout(std::vector<Uniform>* uniforms);
 
 struct Shader {
   ClearOnMove<uint64_t> uuid = 0;  // Set up by the renderer.
+  ClearOnMove<ShaderHandle> handle;  // Set by the renderer when staged.
 
   std::string name;
   std::string path;
@@ -74,6 +76,7 @@ inline bool Valid(Shader* shader) { return shader->uuid.value != 0; }
 inline bool Loaded(Shader* shader) {
   return !shader->vert_source.empty() && !shader->frag_source.empty();
 }
+inline bool Staged(Shader* shader) { return shader->handle.has_value(); }
 
 void RemoveSources(Shader*);
 
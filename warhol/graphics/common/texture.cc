@@ -3,7 +3,10 @@
 
 #include "warhol/graphics/common/texture.h"
 
+#include <string.h>
+
 #include <atomic>
+#include <vector>
 
 #include <third_party/stb/stb_image.h>
 
@@ -15,7 +18,34 @@ namespace {
 
 std::atomic<uint64_t> kNextTextureUUID = 1;
 
-};
+// stb can flip on load, but that is a global setting, which makes it unusable
+// from several threads.
+void FlipVertically(Texture* texture) {
+  // Always loaded as RGBA.
+  size_t row_size = (size_t)texture->x * 4;
+  std::vector<uint8_t> tmp(row_size);
+  uint8_t* data = texture->data.value;
+  for (int y = 0; y < texture->y / 2; y++) {
+    uint8_t* top = data + y * row_size;
+    uint8_t* bottom = data + (texture->y - 1 - y) * row_size;
+    memcpy(tmp.data(), top, row_size);
+    memcpy(top, bottom, row_size);
+    memcpy(bottom, tmp.data(), row_size);
+  }
+}
+
+bool FinishLoad(Texture* tmp, TextureType texture_type, Texture* out_texture) {
+  // OpenGL expects the Y axis to be inverted.
+  if (texture_type == TextureType::kOpenGL)
+    FlipVertically(tmp);
+
+  *out_texture = std::move(*tmp);
+  out_texture->free_function = stbi_image_free;
+  out_texture->uuid = GetNextTextureUUID();
+  return true;
+}
+
+}  // namespace
 
 uint64_t GetNextTextureUUID() { return kNextTextureUUID++; }
 
@@ -26,13 +56,6 @@ Texture::~Texture() {
 
 bool LoadTexture(const std::string& path, TextureType texture_type,
                  Texture* out_texture) {
-  // OpenGL expects the Y axis to be inverted.
-  if (texture_type == TextureType::kOpenGL) {
-    stbi_set_flip_vertically_on_load(true);
-  } else {
-    stbi_set_flip_vertically_on_load(false);
-  }
-
   Texture tmp;
   tmp.data = stbi_load(path.c_str(), &tmp.x, &tmp.y, &tmp.channels,
                        STBI_rgb_alpha);
@@ -42,10 +65,31 @@ bool LoadTexture(const std::string& path, TextureType texture_type,
     return false;
   }
 
-  *out_texture = std::move(tmp);
-  out_texture->free_function = stbi_image_free;
-  out_texture->uuid = GetNextTextureUUID();
-  return true;
+  return FinishLoad(&tmp, texture_type, out_texture);
+}
+
+bool DecodeTexture(const std::string_view& file_data, TextureType texture_type,
+                   Texture* out_texture) {
+  Texture tmp;
+  tmp.data = stbi_load_from_memory((const stbi_uc*)file_data.data(),
+                                   (int)file_data.size(), &tmp.x, &tmp.y,
+                                   &tmp.channels, STBI_rgb_alpha);
+  if (!tmp.data.value) {
+    LOG(ERROR) << "Could not decode texture: " << stbi_failure_reason();
+    return false;
+  }
+
+  return FinishLoad(&tmp, texture_type, out_texture);
+}
+
+Task<bool> LoadTextureAsync(JobSystem* js, std::string path,
+                            TextureType texture_type, Texture* out_texture) {
+  std::string file_data;
+  if (!co_await ReadFileAsync(js, path, &file_data, false))
+    co_return false;
+
+  // Still on the background worker that read the file.
+  co_return DecodeTexture(file_data, texture_type, out_texture);
 }
 
 void UnloadTexture(Texture* texture) {
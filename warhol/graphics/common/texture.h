@@ -7,6 +7,8 @@
 
 #include <string>
 
+#include "warhol/graphics/common/resource_handles.h"
+#include "warhol/multithreading/task.h"
 #include "warhol/utils/clear_on_move.h"
 #include "warhol/utils/macros.h"
 
@@ -25,6 +27,7 @@ struct Texture {
   RAII_CONSTRUCTORS(Texture);
 
   ClearOnMove<uint64_t> uuid;
+  ClearOnMove<TextureHandle> handle;  // Set by the renderer when staged.
 
   std::string name;
 
@@ -47,13 +50,22 @@ struct Texture {
 
 inline bool Valid(Texture* texture) { return texture->uuid.value != 0; }
 inline bool Loaded(Texture* texture) { return texture->data.has_value(); }
+inline bool Staged(Texture* texture) { return texture->handle.has_value(); }
 
 // Thread safe. Will advance the UUID;
 uint64_t GetNextTextureUUID();
 
-// Creates a new texture.
+// Creates a new texture. Thread safe.
 bool LoadTexture(const std::string& path, TextureType, Texture* texture);
 
+// Same as LoadTexture, but from the contents of an image file (png, jpg, etc.).
+bool DecodeTexture(const std::string_view& file_data, TextureType, Texture*);
+
+// Reads and decodes the texture on a background worker. Staging it still has to
+// be done on the renderer's thread (see NextFrame in task.h).
+Task<bool> LoadTextureAsync(JobSystem*, std::string path, TextureType,
+                            Texture*);
+
 // Will only remove the data.
 void UnloadTexture(Texture*);
 
@@ -12,6 +12,8 @@ namespace opengl {
 void DeleteMeshHandles(MeshHandles* handles) {
   glDeleteBuffers(2, (GLuint*)handles);
   glDeleteVertexArrays(1, &handles->vao);
+  if (handles->instance_vbo)
+    glDeleteBuffers(1, &handles->instance_vbo);
 }
 
 // Stage Mesh ------------------------------------------------------------------
@@ -53,55 +55,78 @@ GLenum AttributeTypeToGL(AttributeType type) {
   return GL_NONE;
 }
 
-void BindAttributes(Mesh* mesh) {
-  ASSERT(!mesh->attributes.empty());
-  GLsizei stride = 0;
-  for (auto& attribute : mesh->attributes) {
-    ASSERT(attribute.type != AttributeType::kLast);
-    stride += (GLsizei)GetSize(&attribute);
-  }
+// Points the attributes of one stream (per vertex or per instance) to the
+// buffer currently bound to GL_ARRAY_BUFFER.
+void BindAttributes(Mesh* mesh, bool instanced) {
+  ASSERT(!Empty(&mesh->attributes));
+  GLsizei stride = instanced ? InstanceAttributesSize(mesh) :
+                               AttributesSize(mesh);
 
-  // The shader layout must coincide with these attribute orders.
+  // The shader layout must coincide with these attribute orders. Attributes
+  // over 4 components are split into consecutive locations (eg. a mat4 is 4
+  // vec4 columns).
   int location = 0;
   GLsizei offset = 0;
   for (auto& attribute : mesh->attributes) {
-    glVertexAttribPointer(location,
-                          attribute.count,
-                          AttributeTypeToGL(attribute.type),
-                          attribute.normalized ? GL_TRUE : GL_FALSE,
-                          stride,
-                          (GLvoid*)(intptr_t)offset);
-    glEnableVertexAttribArray(location);
-    offset += (GLsizei)GetSize(&attribute);
-    location++;
+    ASSERT(attribute.type != AttributeType::kLast);
+    uint32_t location_count = (attribute.count + 3) / 4;
+    if ((attribute.divisor > 0) != instanced) {
+      location += location_count;
+      continue;
+    }
+
+    uint32_t remaining = attribute.count;
+    for (uint32_t i = 0; i < location_count; i++) {
+      uint32_t count = remaining > 4 ? 4 : remaining;
+      glVertexAttribPointer(location,
+                            count,
+                            AttributeTypeToGL(attribute.type),
+                            attribute.normalized ? GL_TRUE : GL_FALSE,
+                            stride,
+                            (GLvoid*)(intptr_t)offset);
+      glEnableVertexAttribArray(location);
+      glVertexAttribDivisor(location, attribute.divisor);
+      offset += (GLsizei)(count * (uint32_t)attribute.type);
+      remaining -= count;
+      location++;
+    }
   }
 }
 
 void BufferVertices(Mesh* mesh, MeshHandles* handles) {
   glBindBuffer(GL_ARRAY_BUFFER, handles->vbo);
-  glBufferData(GL_ARRAY_BUFFER, mesh->vertices.size, Data(&mesh->vertices),
-               GL_STATIC_DRAW);
-
-  BindAttributes(mesh);
+  // Mesh pools are virtual: only the used part is backed by memory.
+  glBufferData(GL_ARRAY_BUFFER, mesh->vertices.size, nullptr, GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, Used(&mesh->vertices),
+                  Data(&mesh->vertices));
+
+  BindAttributes(mesh, false);
+
+  // The instance data comes with each draw, so the buffer starts empty.
+  handles->instance_size = InstanceAttributesSize(mesh);
+  if (handles->instance_size > 0) {
+    glGenBuffers(1, &handles->instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, handles->instance_vbo);
+    BindAttributes(mesh, true);
+  }
 }
 
 void BufferIndices(Mesh* mesh, MeshHandles* handles) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handles->ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               mesh->indices.size,
-               Data(&mesh->indices),
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indices.size, nullptr,
                GL_STATIC_DRAW);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, Used(&mesh->indices),
+                  Data(&mesh->indices));
 }
 
 }  // namespace
 
-bool OpenGLStageMesh(OpenGLRendererBackend* opengl, Mesh* mesh) {
+MeshHandle OpenGLStageMesh(OpenGLRendererBackend* opengl, Mesh* mesh) {
   uint64_t uuid = mesh->uuid.value;
   LOG(DEBUG) << "Staging mesh " << mesh->name << " (uuid: " << uuid<< ").";
-  auto it = opengl->loaded_meshes.find(uuid);
-  if (it != opengl->loaded_meshes.end()) {
+  if (Contains(&opengl->loaded_meshes, mesh->handle.value)) {
     LOG(ERROR) << "Reloading mesh " << mesh->name;
-    return false;
+    return {};
   }
 
   // Always bind the VAO first, so that it doesn't overwrite.
@@ -114,29 +139,24 @@ bool OpenGLStageMesh(OpenGLRendererBackend* opengl, Mesh* mesh) {
 
   UnbindMeshHandles();
 
-  opengl->loaded_meshes[uuid] = std::move(handles);
-  mesh->staged = true;
-
-  return true;
+  return Insert(&opengl->loaded_meshes, std::move(handles));
 }
 
 // RendererUploadMeshRange -----------------------------------------------------
 
 bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend* opengl,
+                                   MeshHandle mesh_handle,
                                    Mesh* mesh,
                                    IndexRange vertex_range,
                                    IndexRange index_range) {
-  uint64_t uuid = mesh->uuid.value;
-  auto it = opengl->loaded_meshes.find(uuid);
-  if (it == opengl->loaded_meshes.end()) {
+  MeshHandles* handles = Find(&opengl->loaded_meshes, mesh_handle);
+  if (!handles) {
     LOG(ERROR) << "Uploading range on non-staged mesh " << mesh->name;
     return false;
   }
 
   SCOPE_LOCATION() << "Mesh UUID: " << mesh->uuid.value;
 
-  MeshHandles& handles = it->second;
-
   // Vertices.
   {
     uint32_t size = GetSize(vertex_range);
@@ -144,7 +164,7 @@ bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend* opengl,
       size = Used(&mesh->vertices);
     uint32_t offset = GetOffset(vertex_range);
 
-    glBindBuffer(GL_ARRAY_BUFFER, handles.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, handles->vbo);
     glBufferSubData(GL_ARRAY_BUFFER, offset, size, Data(&mesh->vertices));
     glBindBuffer(GL_ARRAY_BUFFER, NULL);
   }
@@ -156,7 +176,7 @@ bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend* opengl,
       size = Used(&mesh->indices);
     uint32_t offset = GetOffset(index_range);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handles.ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handles->ebo);
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size,
                     Data(&mesh->indices));
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, NULL);
@@ -167,15 +187,13 @@ bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend* opengl,
 
 // Unstage Mesh ----------------------------------------------------------------
 
-void OpenGLUnstageMesh(OpenGLRendererBackend* opengl, Mesh* mesh) {
-  uint64_t uuid = mesh->uuid.value;
-  LOG(DEBUG) << "Unstaging mesh " << mesh->name << " (uuid: " << uuid<< ").";
-  auto it = opengl->loaded_meshes.find(uuid);
-  ASSERT(it != opengl->loaded_meshes.end());
+void OpenGLUnstageMesh(OpenGLRendererBackend* opengl, MeshHandle handle) {
+  LOG(DEBUG) << "Unstaging mesh (index: " << handle.index << ").";
+  MeshHandles* handles = Find(&opengl->loaded_meshes, handle);
+  ASSERT(handles);
 
-  DeleteMeshHandles(&it->second);
-  opengl->loaded_meshes.erase(it);
-  mesh->staged = false;
+  DeleteMeshHandles(handles);
+  Erase(&opengl->loaded_meshes, handle);
 }
 
 }  // namespace opengl
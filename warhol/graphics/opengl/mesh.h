@@ -14,13 +14,13 @@ namespace opengl {
 struct MeshHandles;
 struct OpenGLRendererBackend;
 
-bool OpenGLStageMesh(OpenGLRendererBackend*, Mesh*);
+MeshHandle OpenGLStageMesh(OpenGLRendererBackend*, Mesh*);
 
-bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend*, Mesh*,
+bool OpenGLRendererUploadMeshRange(OpenGLRendererBackend*, MeshHandle, Mesh*,
                                    IndexRange vertex_range,
                                    IndexRange index_range);
 
-void OpenGLUnstageMesh(OpenGLRendererBackend*, Mesh*);
+void OpenGLUnstageMesh(OpenGLRendererBackend*, MeshHandle);
 
 // Actually deallocate the handles of a mesh from OpenGL.
 void DeleteMeshHandles(MeshHandles* handles);
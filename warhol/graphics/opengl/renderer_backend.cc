@@ -133,6 +133,11 @@ bool OpenGLInit(OpenGLRendererBackend* opengl) {
   }
 #endif
 
+  if (!InitUniformRing(&opengl->uniform_ring))
+    return false;
+
+  ResetStateCache(&opengl->state_cache);
+
   opengl->loaded = true;
   return true;
 }
@@ -150,15 +155,15 @@ namespace {
 void OpenGLShutdown(OpenGLRendererBackend* opengl) {
   ASSERT(Valid(opengl));
 
-  for (auto& [shader_uuid, handles] : opengl->loaded_shaders) {
+  for (ShaderHandles& handles : opengl->loaded_shaders) {
     DeleteShaderHandles(&handles);
   }
-  opengl->loaded_shaders.clear();
+  Clear(&opengl->loaded_shaders);
 
-  for (auto& [mesh_uuid, handles] : opengl->loaded_meshes) {
+  for (MeshHandles& handles : opengl->loaded_meshes) {
     DeleteMeshHandles(&handles);
   }
-  opengl->loaded_meshes.clear();
+  Clear(&opengl->loaded_meshes);
 
   if (opengl->camera_ubo.has_value()) {
     glDeleteBuffers(1, &opengl->camera_ubo.value);
@@ -166,6 +171,8 @@ void OpenGLShutdown(OpenGLRendererBackend* opengl) {
   }
   opengl->camera_ubo.clear();
 
+  ShutdownUniformRing(&opengl->uniform_ring);
+
   opengl->loaded = false;
 }
 
@@ -177,23 +184,31 @@ void OpenGLRendererBackend::Shutdown() {
 
 // Mesh Handling ---------------------------------------------------------------
 
-bool OpenGLRendererBackend::StageMesh(Mesh* mesh) {
-  return OpenGLStageMesh(this, mesh);
+// Staging binds and deletes GL objects directly, behind the state cache's back.
+
+MeshHandle OpenGLRendererBackend::StageMesh(Mesh* mesh) {
+  MeshHandle handle = OpenGLStageMesh(this, mesh);
+  ResetStateCache(&this->state_cache);
+  return handle;
 }
 
-inline bool OpenGLRendererBackend::IsMeshStaged(Mesh* mesh) {
+bool OpenGLRendererBackend::IsMeshStaged(MeshHandle handle) {
   ASSERT(Valid(this));
-  return this->loaded_meshes.count(mesh->uuid.value) > 0;
+  return Contains(&this->loaded_meshes, handle);
 }
 
-bool OpenGLRendererBackend::UploadMeshRange(Mesh* mesh,
+bool OpenGLRendererBackend::UploadMeshRange(MeshHandle handle, Mesh* mesh,
                                             IndexRange vert_range,
                                             IndexRange index_range) {
-  return OpenGLRendererUploadMeshRange(this, mesh, vert_range, index_range);
+  bool result = OpenGLRendererUploadMeshRange(this, handle, mesh, vert_range,
+                                              index_range);
+  ResetStateCache(&this->state_cache);
+  return result;
 }
 
-void OpenGLRendererBackend::UnstageMesh(Mesh* mesh) {
-  OpenGLUnstageMesh(this, mesh);
+void OpenGLRendererBackend::UnstageMesh(MeshHandle handle) {
+  OpenGLUnstageMesh(this, handle);
+  ResetStateCache(&this->state_cache);
 }
 
 // Shader Handling -------------------------------------------------------------
@@ -206,33 +221,39 @@ bool OpenGLRendererBackend::ParseShader(Renderer*,
   return OpenGLParseShader(paths, vert_name, frag_name, out);
 }
 
-bool OpenGLRendererBackend::StageShader(Shader* shader) {
-  return OpenGLStageShader(this, shader);
+ShaderHandle OpenGLRendererBackend::StageShader(Shader* shader) {
+  ShaderHandle handle = OpenGLStageShader(this, shader);
+  ResetStateCache(&this->state_cache);
+  return handle;
 }
 
-bool OpenGLRendererBackend::IsShaderStaged(Shader* shader) {
+bool OpenGLRendererBackend::IsShaderStaged(ShaderHandle handle) {
   ASSERT(Valid(this));
-  return this->loaded_shaders.count(shader->uuid.value) > 0;
+  return Contains(&this->loaded_shaders, handle);
 }
 
-void OpenGLRendererBackend::UnstageShader(Shader* shader) {
-  OpenGLUnstageShader(this, shader);
+void OpenGLRendererBackend::UnstageShader(ShaderHandle handle) {
+  OpenGLUnstageShader(this, handle);
+  ResetStateCache(&this->state_cache);
 }
 
 // Texture Handling ------------------------------------------------------------
 
-bool OpenGLRendererBackend::StageTexture(Texture* texture,
-                                         StageTextureConfig* config) {
-  return OpenGLStageTexture(this, texture, config);
+TextureHandle OpenGLRendererBackend::StageTexture(Texture* texture,
+                                                  StageTextureConfig* config) {
+  TextureHandle handle = OpenGLStageTexture(this, texture, config);
+  ResetStateCache(&this->state_cache);
+  return handle;
 }
 
-bool OpenGLRendererBackend::IsTextureStaged(Texture* texture) {
+bool OpenGLRendererBackend::IsTextureStaged(TextureHandle handle) {
   ASSERT(Valid(this));
-  return this->loaded_textures.count(texture->uuid.value) > 0;
+  return Contains(&this->loaded_textures, handle);
 }
 
-void OpenGLRendererBackend::UnstageTexture(Texture* texture) {
-  OpenGLUnstageTexture(this, texture);
+void OpenGLRendererBackend::UnstageTexture(TextureHandle handle) {
+  OpenGLUnstageTexture(this, handle);
+  ResetStateCache(&this->state_cache);
 }
 
 // Start Frame -----------------------------------------------------------------
@@ -250,6 +271,8 @@ void OpenGLStartFrame(Renderer* renderer) {
 }  // namespace
 
 void OpenGLRendererBackend::StartFrame(Renderer* renderer) {
+  StartStateCacheFrame(&this->state_cache);
+  StartUniformRingFrame(&this->uniform_ring);
   OpenGLStartFrame(renderer);
 }
 
@@ -262,109 +285,141 @@ void SetCameraMatrices(OpenGLRendererBackend* opengl, Camera* camera) {
     return;
 
   void* data = &camera->projection;
-  glBindBuffer(GL_UNIFORM_BUFFER, opengl->camera_ubo.value);
+  BindUniformBuffer(&opengl->state_cache, opengl->camera_ubo.value);
   glBufferSubData(GL_UNIFORM_BUFFER, 0, 2 * sizeof(glm::mat4), data);
-  glBindBuffer(GL_UNIFORM_BUFFER, NULL);
 
   opengl->last_set_camera = camera;
 }
 
-void SetUniforms(Shader* shader, ShaderHandles* handles,
+// Copies a uniform block into the uniform ring and binds it. If this frame's
+// ring section is full, falls back to re-specifying the shader's own UBO.
+void SetUniformBlock(OpenGLRendererBackend* opengl, uint32_t binding,
+                     uint32_t shader_ubo, uint8_t* data, uint32_t size) {
+  if (PushUniforms(&opengl->uniform_ring, &opengl->state_cache, binding, data,
+                   size)) {
+    return;
+  }
+
+  // Counted (and logged once a frame) by the ring.
+  BindUniformBuffer(&opengl->state_cache, shader_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STREAM_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, shader_ubo);
+}
+
+void SetUniforms(OpenGLRendererBackend* opengl, ShaderHandles* handles,
                  MeshRenderAction* action) {
   if (handles->vert_ubo_binding > -1) {
     ASSERT(handles->vert_ubo_handle > 0);
     ASSERT(action->vert_uniforms);
-
-    glBindBuffer(GL_UNIFORM_BUFFER, handles->vert_ubo_handle);
-    glBufferData(GL_UNIFORM_BUFFER,
-                 shader->vert_ubo_size,
-                 action->vert_uniforms,
-                 GL_STREAM_DRAW);
+    SetUniformBlock(opengl, handles->vert_ubo_binding,
+                    handles->vert_ubo_handle, action->vert_uniforms,
+                    handles->vert_ubo_size);
   }
 
   if (handles->frag_ubo_binding > -1) {
     ASSERT(handles->frag_ubo_handle > 0);
     ASSERT(action->frag_uniforms);
-
-    glBindBuffer(GL_UNIFORM_BUFFER, handles->frag_ubo_handle);
-    glBufferData(GL_UNIFORM_BUFFER,
-                 shader->frag_ubo_size,
-                 action->frag_uniforms,
-                 GL_STREAM_DRAW);
+    SetUniformBlock(opengl, handles->frag_ubo_binding,
+                    handles->frag_ubo_handle, action->frag_uniforms,
+                    handles->frag_ubo_size);
   }
-
-  glBindBuffer(GL_UNIFORM_BUFFER, NULL);
 }
 
-#define SET_GL_CONFIG(flag, gl_name) \
-  if (flag) {                           \
-    glEnable(gl_name);                  \
-  } else {                              \
-    glDisable(gl_name);                 \
-  }
-
-void SetConfigs(RenderCommandConfig* config) {
+void SetConfigs(StateCache* cache, RenderCommandConfig* config) {
+  SetCapability(cache, StateCache::Capability::kBlend, config->blend_enabled);
   if (config->blend_enabled) {
-    glEnable(GL_BLEND);
-
     // TODO(Cristian): Have a way of setting the blend function!!!!!
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  } else {
-    glDisable(GL_BLEND);
+    SetBlendEquation(cache, GL_FUNC_ADD);
+    SetBlendFunction(cache, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   }
 
-  SET_GL_CONFIG(config->cull_faces, GL_CULL_FACE);
-  SET_GL_CONFIG(config->depth_test, GL_DEPTH_TEST);
-  SET_GL_CONFIG(config->scissor_test, GL_SCISSOR_TEST);
+  SetCapability(cache, StateCache::Capability::kCullFace, config->cull_faces);
+  SetCapability(cache, StateCache::Capability::kDepthTest,
+                config->depth_test);
+  SetCapability(cache, StateCache::Capability::kScissorTest,
+                config->scissor_test);
 }
 
-void ExecuteMeshActions(OpenGLRendererBackend* opengl,
-                        RenderCommand* command,
-                        ShaderHandles* shader_handles) {
-  for (MeshRenderAction& action : command->mesh_actions) {
-    size_t size = GetSize(action.index_range);
-    size_t offset = GetOffset(action.index_range);
-    /* LOG(DEBUG) << ToString(action.index_range); */
-    if (size == 0)
-      continue;
+// What the previous draw used, so consecutive draws of the same command skip
+// the lookups. Redundant GL calls are filtered by the state cache. Draws come
+// sorted by state (see GetSortKey), which is what makes both pay off.
+struct DrawState {
+  RenderCommand* command = nullptr;
+  ShaderHandle shader = {};
+  ShaderHandles* shader_handles = nullptr;
+};
 
-    auto mesh_it = opengl->loaded_meshes.find(action.mesh->uuid.value);
-    ASSERT(mesh_it != opengl->loaded_meshes.end());
+void BindCommand(OpenGLRendererBackend* opengl, DrawState* state,
+                 RenderCommand* command) {
+  if (!state->command || command->shader != state->shader) {
+    state->shader_handles = Find(&opengl->loaded_shaders, command->shader);
+    ASSERT(state->shader_handles) << "Stale shader handle.";
+    UseProgram(&opengl->state_cache, state->shader_handles->program_handle);
+    state->shader = command->shader;
+  }
 
-    SetUniforms(command->shader, shader_handles, &action);
+  SetConfigs(&opengl->state_cache, &command->config);
+  SetCameraMatrices(opengl, command->camera);
 
-    MeshHandles& handles = mesh_it->second;
-    glBindVertexArray(handles.vao);
+  state->command = command;
+}
 
-    for (int i = 0; i < command->shader->texture_count; i++) {
-      Texture* texture = action.textures + i;
-      auto tex_it = opengl->loaded_textures.find(texture->uuid.value);
-      ASSERT(tex_it != opengl->loaded_textures.end());
+void ExecuteDraw(OpenGLRendererBackend* opengl, DrawState* state,
+                 RenderDraw* draw) {
+  MeshRenderAction* action = draw->action;
+  size_t size = GetSize(action->index_range);
+  size_t offset = GetOffset(action->index_range);
+  /* LOG(DEBUG) << ToString(action->index_range); */
+  if (size == 0)
+    return;
 
-      uint32_t tex_handle = tex_it->second.tex_handle;
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, tex_handle);
-    }
+  if (draw->command != state->command)
+    BindCommand(opengl, state, draw->command);
+  ShaderHandles* shader_handles = state->shader_handles;
 
-    // Set scissoring. We check if the rectangle is non zero.
-    if (command->config.scissor_test && Sum(action.scissor) > 0) {
-      glScissor((int)action.scissor.x, (int)action.scissor.y,
-                (int)action.scissor.z, (int)action.scissor.w);
-    }
+  SetUniforms(opengl, shader_handles, action);
+
+  MeshHandles* handles = Find(&opengl->loaded_meshes, action->mesh);
+  ASSERT(handles) << "Stale mesh handle.";
+  BindVertexArray(&opengl->state_cache, handles->vao);
+
+  for (int i = 0; i < shader_handles->texture_count; i++) {
+    TextureHandles* tex_handles = Find(&opengl->loaded_textures,
+                                       action->textures[i]);
+    ASSERT(tex_handles) << "Stale texture handle.";
+    BindTexture2D(&opengl->state_cache, 0, tex_handles->tex_handle);
+  }
 
+  // Set scissoring. We check if the rectangle is non zero.
+  if (draw->command->config.scissor_test && Sum(action->scissor) > 0)
+    SetScissor(&opengl->state_cache, action->scissor);
+
+  if (action->instance_count == 0) {
     glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_INT, (void*)offset);
+    return;
   }
-  glBindVertexArray(NULL);
+
+  // Re-specifying the whole store orphans the previous one, so this doesn't
+  // wait on draws still reading last draw's instances. GL_ARRAY_BUFFER is not
+  // VAO state, so binding it here doesn't disturb the cache.
+  ASSERT(handles->instance_vbo) << "Instanced draw on a non-instanced mesh.";
+  glBindBuffer(GL_ARRAY_BUFFER, handles->instance_vbo);
+  glBufferData(GL_ARRAY_BUFFER,
+               action->instance_count * handles->instance_size,
+               action->instance_data,
+               GL_STREAM_DRAW);
+  glDrawElementsInstanced(GL_TRIANGLES, size, GL_UNSIGNED_INT, (void*)offset,
+                          action->instance_count);
 }
 
 void ValidateRenderCommands(List<RenderCommand>* commands) {
   for (auto& command : *commands) {
     ASSERT(command.camera);
-    ASSERT(command.shader);
+    ASSERT(Valid(command.shader));
     ASSERT(command.type == RenderCommandType::kMesh);
     for (auto& action : command.mesh_actions) {
-      ASSERT(action.mesh);
+      ASSERT(Valid(action.mesh));
+      ASSERT(action.instance_count == 0 || action.instance_data);
     }
   }
 }
@@ -375,28 +430,18 @@ void OpenGLExecuteCommands(OpenGLRendererBackend* opengl,
   ValidateRenderCommands(commands);
 #endif
 
-  for (auto& command : *commands) {
-    auto shader_it = opengl->loaded_shaders.find(command.shader->uuid.value);
-    ASSERT(shader_it != opengl->loaded_shaders.end());
-    ShaderHandles& shader_handles = shader_it->second;
-
-    glUseProgram(shader_handles.program_handle);
-
-    SetConfigs(&command.config);
-    SetCameraMatrices(opengl, command.camera);
-
-    switch (command.type) {
-      case RenderCommandType::kMesh:
-        ExecuteMeshActions(opengl, &command, &shader_handles);
-        break;
-      case RenderCommandType::kNoop:
-        continue;
-      case RenderCommandType::kLast:
-        NOT_REACHED() << "Invalid render command type.";
-    }
+  // The camera matrices could have changed since last frame.
+  opengl->last_set_camera = nullptr;
 
-    glUseProgram(NULL);
-  }
+  Array<RenderDraw> draws = SortDraws(commands);
+
+  DrawState state = {};
+  for (RenderDraw& draw : draws)
+    ExecuteDraw(opengl, &state, &draw);
+
+  // Leave nothing bound, so staging can't write into a draw's VAO.
+  BindVertexArray(&opengl->state_cache, 0);
+  UseProgram(&opengl->state_cache, 0);
 }
 
 }  // namespace
@@ -410,7 +455,10 @@ void OpenGLRendererBackend::ExecuteCommands(Renderer*,
 
 void OpenGLRendererBackend::EndFrame(Renderer*) {
   // Return state to it's appropiate state.
-  glDisable(GL_SCISSOR_TEST);
+  SetCapability(&this->state_cache, StateCache::Capability::kScissorTest,
+                false);
+
+  EndUniformRingFrame(&this->uniform_ring);
 }
 
 // Misc ------------------------------------------------------------------------
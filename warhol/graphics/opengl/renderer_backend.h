@@ -7,11 +7,13 @@
 
 #include <stdio.h>
 
-#include <map>
-
 #include <GL/gl3w.h>
 
+#include "warhol/containers/slot_map.h"
+
 #include "warhol/graphics/opengl/shader.h"
+#include "warhol/graphics/opengl/state_cache.h"
+#include "warhol/graphics/opengl/uniform_ring.h"
 #include "warhol/graphics/opengl/utils.h"
 #include "warhol/utils/clear_on_move.h"
 #include "warhol/utils/location.h"
@@ -24,6 +26,11 @@ struct MeshHandles {
   uint32_t vbo = 0;
   uint32_t ebo = 0;
   uint32_t vao = 0;
+
+  // Only for meshes with instanced attributes. Re-specified on every instanced
+  // draw with that draw's instances.
+  uint32_t instance_vbo = 0;
+  uint32_t instance_size = 0;
 };
 
 struct TextureHandles {
@@ -36,10 +43,10 @@ struct OpenGLRendererBackend : public RendererBackend {
   DELETE_COPY_AND_ASSIGN(OpenGLRendererBackend);
   DEFAULT_MOVE_AND_ASSIGN(OpenGLRendererBackend);
 
-  // Maps from external resource UUID to internal objects.
-  std::map<uint64_t, ShaderHandles> loaded_shaders;
-  std::map<uint64_t, MeshHandles> loaded_meshes;
-  std::map<uint64_t, TextureHandles> loaded_textures;
+  // Staged resources, indexed by the handles given back on staging.
+  SlotMap<ShaderHandles, Shader> loaded_shaders;
+  SlotMap<MeshHandles, Mesh> loaded_meshes;
+  SlotMap<TextureHandles, Texture> loaded_textures;
 
   // Buffer that holds the camera matrices.
   ClearOnMove<uint32_t> camera_ubo = 0;
@@ -47,6 +54,12 @@ struct OpenGLRendererBackend : public RendererBackend {
   // If the last camera was already set, we don't need to re-send the uniforms.
   Camera* last_set_camera = nullptr;
 
+  // Filters redundant state changes while executing commands.
+  StateCache state_cache;
+
+  // Where the per draw uniform blocks are written to.
+  UniformRing uniform_ring;
+
   bool loaded = false;
 
   // Virtual interface ---------------------------------------------------------
@@ -54,11 +67,11 @@ struct OpenGLRendererBackend : public RendererBackend {
   bool Init(Renderer*, Window*) override;
   void Shutdown() override;
 
-  bool StageMesh(Mesh*) override;
-  void UnstageMesh(Mesh*) override;
-  bool IsMeshStaged(Mesh*) override;
+  MeshHandle StageMesh(Mesh*) override;
+  void UnstageMesh(MeshHandle) override;
+  bool IsMeshStaged(MeshHandle) override;
 
-  bool UploadMeshRange(Mesh*,
+  bool UploadMeshRange(MeshHandle, Mesh*,
                        IndexRange vertex_range = {},
                        IndexRange index_range = {}) override;
 
@@ -66,13 +79,13 @@ struct OpenGLRendererBackend : public RendererBackend {
                    const std::string& vert_name,
                    const std::string& frag_name,
                    Shader* out) override;
-  bool StageShader(Shader*) override;
-  void UnstageShader(Shader*) override;
-  bool IsShaderStaged(Shader*) override;
+  ShaderHandle StageShader(Shader*) override;
+  void UnstageShader(ShaderHandle) override;
+  bool IsShaderStaged(ShaderHandle) override;
 
-  bool StageTexture(Texture*, StageTextureConfig*) override;
-  void UnstageTexture(Texture*) override;
-  bool IsTextureStaged(Texture*) override;
+  TextureHandle StageTexture(Texture*, StageTextureConfig*) override;
+  void UnstageTexture(TextureHandle) override;
+  bool IsTextureStaged(TextureHandle) override;
 
   void StartFrame(Renderer*) override;
   void ExecuteCommands(Renderer*, List<RenderCommand>*) override;
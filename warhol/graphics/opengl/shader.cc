@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <third_party/cpptoml/cpptoml.h>
 
+#include <optional>
 #include <set>
 
 #include "warhol/assets/asset_paths.h"
@@ -382,28 +383,28 @@ bool UploadShader(Shader* shader, ShaderHandles* shader_desc) {
 
 // Shader Handling -------------------------------------------------------------
 
-bool OpenGLStageShader(OpenGLRendererBackend* opengl, Shader* shader) {
-  uint64_t uuid = shader->uuid.value;
-  auto it = opengl->loaded_shaders.find(uuid);
-  if (it != opengl->loaded_shaders.end()) {
+ShaderHandle OpenGLStageShader(OpenGLRendererBackend* opengl, Shader* shader) {
+  if (Contains(&opengl->loaded_shaders, shader->handle.value)) {
     LOG(ERROR) << "Shader " << shader->name << " is already loaded.";
-    return false;
+    return {};
   }
 
   ShaderHandles handles;
   if (!UploadShader(shader, &handles))
-    return false;
+    return {};
 
-  opengl->loaded_shaders[uuid] = std::move(handles);
-  return true;
+  handles.vert_ubo_size = shader->vert_ubo_size;
+  handles.frag_ubo_size = shader->frag_ubo_size;
+  handles.texture_count = shader->texture_count;
+  return Insert(&opengl->loaded_shaders, std::move(handles));
 }
 
-void OpenGLUnstageShader(OpenGLRendererBackend* opengl, Shader* shader) {
-  auto it = opengl->loaded_shaders.find(shader->uuid.value);
-  ASSERT(it != opengl->loaded_shaders.end());
+void OpenGLUnstageShader(OpenGLRendererBackend* opengl, ShaderHandle handle) {
+  ShaderHandles* handles = Find(&opengl->loaded_shaders, handle);
+  ASSERT(handles);
 
-  DeleteShaderHandles(&it->second);
-  opengl->loaded_shaders.erase(it);
+  DeleteShaderHandles(handles);
+  Erase(&opengl->loaded_shaders, handle);
 }
 
 void DeleteShaderHandles(ShaderHandles* handles) {
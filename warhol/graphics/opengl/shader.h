@@ -7,6 +7,8 @@
 
 #include <string_view>
 
+#include "warhol/graphics/common/resource_handles.h"
+
 namespace warhol {
 
 struct BasePaths;
@@ -28,6 +30,11 @@ struct ShaderHandles {
 
   uint32_t frag_ubo_handle = 0;
   int frag_ubo_binding = -1;
+
+  // Copied from the Shader, as render commands only carry the handle.
+  int vert_ubo_size = -1;
+  int frag_ubo_size = -1;
+  int texture_count = 0;
 };
 
 bool OpenGLParseShader(BasePaths*,
@@ -35,8 +42,8 @@ bool OpenGLParseShader(BasePaths*,
                        const std::string& frag_name,
                        Shader* out);
 
-bool OpenGLStageShader(OpenGLRendererBackend* opengl, Shader* shader);
-void OpenGLUnstageShader(OpenGLRendererBackend* opengl, Shader* shader);
+ShaderHandle OpenGLStageShader(OpenGLRendererBackend* opengl, Shader* shader);
+void OpenGLUnstageShader(OpenGLRendererBackend* opengl, ShaderHandle handle);
 
 void DeleteShaderHandles(ShaderHandles* handles);
 
@@ -0,0 +1,144 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/graphics/opengl/state_cache.h"
+
+#include "warhol/utils/log.h"
+
+namespace warhol {
+namespace opengl {
+
+namespace {
+
+GLenum CapabilityToGL(StateCache::Capability capability) {
+  switch (capability) {
+    case StateCache::Capability::kBlend: return GL_BLEND;
+    case StateCache::Capability::kCullFace: return GL_CULL_FACE;
+    case StateCache::Capability::kDepthTest: return GL_DEPTH_TEST;
+    case StateCache::Capability::kScissorTest: return GL_SCISSOR_TEST;
+    case StateCache::Capability::kLast: break;
+  }
+
+  NOT_REACHED() << "Invalid capability: " << (uint32_t)capability;
+  return GL_NONE;
+}
+
+// Returns whether the call has to be issued, updating the shadow value and the
+// counters.
+bool Update(StateCache* cache, uint32_t* cached, uint32_t value) {
+  if (*cached == value) {
+    cache->counters.skipped++;
+    return false;
+  }
+
+  *cached = value;
+  cache->counters.issued++;
+  return true;
+}
+
+}  // namespace
+
+void ResetStateCache(StateCache* cache) {
+  for (uint32_t& capability : cache->capabilities)
+    capability = StateCache::kUnknown;
+
+  cache->blend_equation = StateCache::kUnknown;
+  cache->blend_src = StateCache::kUnknown;
+  cache->blend_dst = StateCache::kUnknown;
+
+  cache->program = StateCache::kUnknown;
+  cache->vao = StateCache::kUnknown;
+  cache->uniform_buffer = StateCache::kUnknown;
+
+  cache->active_texture_unit = StateCache::kUnknown;
+  for (uint32_t& texture : cache->textures_2d)
+    texture = StateCache::kUnknown;
+
+  cache->scissor_known = false;
+}
+
+void StartStateCacheFrame(StateCache* cache) {
+  cache->last_frame_counters = cache->counters;
+  cache->counters = {};
+}
+
+void SetCapability(StateCache* cache, StateCache::Capability capability,
+                   bool enabled) {
+  ASSERT(capability != StateCache::Capability::kLast);
+  uint32_t* cached = cache->capabilities + (uint32_t)capability;
+  if (!Update(cache, cached, enabled ? 1 : 0))
+    return;
+
+  if (enabled) {
+    glEnable(CapabilityToGL(capability));
+  } else {
+    glDisable(CapabilityToGL(capability));
+  }
+}
+
+void SetBlendEquation(StateCache* cache, GLenum mode) {
+  if (Update(cache, &cache->blend_equation, mode))
+    glBlendEquation(mode);
+}
+
+void SetBlendFunction(StateCache* cache, GLenum src_factor,
+                      GLenum dst_factor) {
+  if (cache->blend_src == src_factor && cache->blend_dst == dst_factor) {
+    cache->counters.skipped++;
+    return;
+  }
+
+  cache->blend_src = src_factor;
+  cache->blend_dst = dst_factor;
+  cache->counters.issued++;
+  glBlendFunc(src_factor, dst_factor);
+}
+
+void SetScissor(StateCache* cache, Int4 scissor) {
+  Int4& cached = cache->scissor;
+  if (cache->scissor_known &&
+      cached.x == scissor.x && cached.y == scissor.y &&
+      cached.z == scissor.z && cached.w == scissor.w) {
+    cache->counters.skipped++;
+    return;
+  }
+
+  cache->scissor_known = true;
+  cached = scissor;
+  cache->counters.issued++;
+  glScissor(scissor.x, scissor.y, scissor.z, scissor.w);
+}
+
+void UseProgram(StateCache* cache, uint32_t program) {
+  if (Update(cache, &cache->program, program))
+    glUseProgram(program);
+}
+
+void BindVertexArray(StateCache* cache, uint32_t vao) {
+  if (Update(cache, &cache->vao, vao))
+    glBindVertexArray(vao);
+}
+
+void BindUniformBuffer(StateCache* cache, uint32_t ubo) {
+  if (Update(cache, &cache->uniform_buffer, ubo))
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+}
+
+void BindUniformBufferRange(StateCache* cache, uint32_t index, uint32_t ubo,
+                            uint32_t offset, uint32_t size) {
+  cache->uniform_buffer = ubo;
+  cache->counters.issued++;
+  glBindBufferRange(GL_UNIFORM_BUFFER, index, ubo, offset, size);
+}
+
+void BindTexture2D(StateCache* cache, uint32_t unit, uint32_t texture) {
+  ASSERT(unit < StateCache::kTextureUnits);
+  if (Update(cache, &cache->textures_2d[unit], texture)) {
+    if (Update(cache, &cache->active_texture_unit, unit))
+      glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+}
+
+}  // namespace opengl
+}  // namespace warhol
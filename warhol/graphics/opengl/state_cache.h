@@ -0,0 +1,88 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <GL/gl3w.h>
+
+#include "warhol/math/vec.h"
+
+namespace warhol {
+namespace opengl {
+
+// StateCache ------------------------------------------------------------------
+//
+// Shadow copy of the GL state the draw loop touches. Every setter compares
+// against the shadow value and drops the GL call when nothing would change,
+// which matters when driver overhead per call dominates the frame (thousands
+// of small draws re-setting the same state).
+//
+// The cache only knows about the calls that go through it. Code that changes
+// this state with raw GL calls (eg. resource staging) has to call
+// ResetStateCache afterwards, so the next setter re-issues its call. It also
+// has to be reset before its first use.
+
+struct StateCacheCounters {
+  uint32_t issued = 0;
+  uint32_t skipped = 0;
+};
+
+struct StateCache {
+  enum class Capability : uint32_t {
+    kBlend,
+    kCullFace,
+    kDepthTest,
+    kScissorTest,
+    kLast,
+  };
+
+  static constexpr uint32_t kTextureUnits = 16;
+  // Never a valid GL name or enum, so the first call always goes through.
+  static constexpr uint32_t kUnknown = UINT32_MAX;
+
+  uint32_t capabilities[(uint32_t)Capability::kLast];
+
+  uint32_t blend_equation = kUnknown;
+  uint32_t blend_src = kUnknown;
+  uint32_t blend_dst = kUnknown;
+
+  uint32_t program = kUnknown;
+  uint32_t vao = kUnknown;
+  uint32_t uniform_buffer = kUnknown;
+
+  uint32_t active_texture_unit = kUnknown;
+  uint32_t textures_2d[kTextureUnits];
+
+  bool scissor_known = false;
+  Int4 scissor;
+
+  StateCacheCounters counters;              // Current frame.
+  StateCacheCounters last_frame_counters;
+};
+
+// Forgets every shadow value.
+void ResetStateCache(StateCache*);
+
+// Rolls the counters over to |last_frame_counters|.
+void StartStateCacheFrame(StateCache*);
+
+void SetCapability(StateCache*, StateCache::Capability, bool enabled);
+void SetBlendEquation(StateCache*, GLenum mode);
+void SetBlendFunction(StateCache*, GLenum src_factor, GLenum dst_factor);
+void SetScissor(StateCache*, Int4 scissor);
+
+void UseProgram(StateCache*, uint32_t program);
+void BindVertexArray(StateCache*, uint32_t vao);
+// Generic GL_UNIFORM_BUFFER binding (the one glBufferData writes to).
+void BindUniformBuffer(StateCache*, uint32_t ubo);
+// Binds a range to the uniform block |index|. Ranges change every draw, so this
+// is always issued. It also changes the generic binding, which is tracked.
+void BindUniformBufferRange(StateCache*, uint32_t index, uint32_t ubo,
+                            uint32_t offset, uint32_t size);
+// Also sets the active texture unit.
+void BindTexture2D(StateCache*, uint32_t unit, uint32_t texture);
+
+}  // namespace opengl
+}  // namespace warhol
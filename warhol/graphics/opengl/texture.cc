@@ -43,13 +43,12 @@ GLenum FilterToGL(StageTextureConfig::Filter filter) {
 
 }  // namespace
 
-bool OpenGLStageTexture(OpenGLRendererBackend* opengl, Texture* texture,
-                        StageTextureConfig* config) {
-  uint64_t uuid = texture->uuid.value;
-  auto it = opengl->loaded_textures.find(uuid);
-  if (it != opengl->loaded_textures.end()) {
-    LOG(ERROR) << "Shader " << texture->name << " is already loaded.";
-    return false;
+TextureHandle OpenGLStageTexture(OpenGLRendererBackend* opengl,
+                                 Texture* texture,
+                                 StageTextureConfig* config) {
+  if (Contains(&opengl->loaded_textures, texture->handle.value)) {
+    LOG(ERROR) << "Texture " << texture->name << " is already loaded.";
+    return {};
   }
 
   uint32_t handle;
@@ -80,20 +79,20 @@ bool OpenGLStageTexture(OpenGLRendererBackend* opengl, Texture* texture,
   if (config->generate_mipmaps)
     glGenerateMipmap(GL_TEXTURE_2D);
 
+  glBindTexture(GL_TEXTURE_2D, NULL);
+
   TextureHandles handles;
   handles.tex_handle = handle;
-  opengl->loaded_textures[uuid] = std::move(handles);
-
-  glBindTexture(GL_TEXTURE_2D, NULL);
-  return true;
+  return Insert(&opengl->loaded_textures, std::move(handles));
 }
 
-void OpenGLUnstageTexture(OpenGLRendererBackend* opengl, Texture* texture) {
-  auto it = opengl->loaded_textures.find(texture->uuid.value);
-  ASSERT(it != opengl->loaded_textures.end());
+void OpenGLUnstageTexture(OpenGLRendererBackend* opengl,
+                          TextureHandle handle) {
+  TextureHandles* handles = Find(&opengl->loaded_textures, handle);
+  ASSERT(handles);
 
-  glDeleteTextures(1, &it->second.tex_handle);
-  opengl->loaded_textures.erase(it);
+  glDeleteTextures(1, &handles->tex_handle);
+  Erase(&opengl->loaded_textures, handle);
 }
 
 }  // namespace opengl
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "warhol/graphics/common/resource_handles.h"
+
 namespace warhol {
 
 struct StageTextureConfig;
@@ -12,9 +14,10 @@ namespace opengl {
 
 struct OpenGLRendererBackend;
 
-bool OpenGLStageTexture(OpenGLRendererBackend*, Texture*, StageTextureConfig*);
+TextureHandle OpenGLStageTexture(OpenGLRendererBackend*, Texture*,
+                                 StageTextureConfig*);
 
-void OpenGLUnstageTexture(OpenGLRendererBackend*, Texture*);
+void OpenGLUnstageTexture(OpenGLRendererBackend*, TextureHandle);
 
 }  // namespace opengl
 }  // namespace warhol
@@ -0,0 +1,141 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/graphics/opengl/uniform_ring.h"
+
+#include <string.h>
+
+#include "warhol/graphics/opengl/state_cache.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+namespace opengl {
+
+namespace {
+
+inline uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void WaitForFence(GLsync* fence) {
+  if (!*fence)
+    return;
+
+  // Flush on the first try, so the fence is guaranteed to eventually signal.
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (true) {
+    GLenum result = glClientWaitSync(*fence, flags, 1000000);   // 1 ms.
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+      break;
+    if (result == GL_WAIT_FAILED) {
+      LOG(ERROR) << "Waiting for the uniform ring fence failed.";
+      break;
+    }
+    flags = 0;
+  }
+
+  glDeleteSync(*fence);
+  *fence = nullptr;
+}
+
+}  // namespace
+
+bool InitUniformRing(UniformRing* ring, uint32_t frame_size) {
+  ASSERT(!Valid(ring));
+
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  ring->alignment = alignment > 0 ? (uint32_t)alignment : 256;
+  ring->frame_size = AlignUp(frame_size, ring->alignment);
+
+  GLsizeiptr size = (GLsizeiptr)ring->frame_size * kUniformRingFrames;
+  glGenBuffers(1, &ring->buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+
+  if (glBufferStorage) {
+    GLbitfield flags = GL_MAP_WRITE_BIT |
+                       GL_MAP_PERSISTENT_BIT |
+                       GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    ring->mapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size,
+                                              flags);
+    if (!ring->mapped) {
+      LOG(ERROR) << "Could not map the uniform ring.";
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+      glDeleteBuffers(1, &ring->buffer);
+      *ring = {};
+      return false;
+    }
+  } else {
+    LOG(WARNING) << "No glBufferStorage: uniform ring won't be mapped.";
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return true;
+}
+
+void ShutdownUniformRing(UniformRing* ring) {
+  if (!Valid(ring))
+    return;
+
+  for (GLsync& fence : ring->fences) {
+    if (fence)
+      glDeleteSync(fence);
+  }
+
+  if (ring->mapped) {
+    glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  glDeleteBuffers(1, &ring->buffer);
+  *ring = {};
+}
+
+void StartUniformRingFrame(UniformRing* ring) {
+  ASSERT(Valid(ring));
+  WaitForFence(ring->fences + ring->section);
+  ring->offset = 0;
+  ring->overflows = 0;
+}
+
+void EndUniformRingFrame(UniformRing* ring) {
+  ASSERT(Valid(ring));
+  ASSERT(!ring->fences[ring->section]);
+  ring->fences[ring->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  ring->last_frame_bytes = ring->offset;
+  ring->last_frame_overflows = ring->overflows;
+  if (ring->overflows > 0) {
+    LOG(WARNING) << "Uniform ring section (" << ring->frame_size
+                 << " bytes) overflowed " << ring->overflows
+                 << " times this frame.";
+  }
+  ring->section = (ring->section + 1) % kUniformRingFrames;
+}
+
+bool PushUniforms(UniformRing* ring, StateCache* cache, uint32_t binding,
+                  const void* data, uint32_t size) {
+  ASSERT(Valid(ring));
+  uint32_t offset = AlignUp(ring->offset, ring->alignment);
+  if (offset + size > ring->frame_size) {
+    ring->overflows++;
+    return false;
+  }
+
+  uint32_t ring_offset = ring->section * ring->frame_size + offset;
+  if (ring->mapped) {
+    memcpy(ring->mapped + ring_offset, data, size);
+  } else {
+    BindUniformBuffer(cache, ring->buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, ring_offset, size, data);
+  }
+
+  BindUniformBufferRange(cache, binding, ring->buffer, ring_offset, size);
+  ring->offset = offset + size;
+  return true;
+}
+
+}  // namespace opengl
+}  // namespace warhol
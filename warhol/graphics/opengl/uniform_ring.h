@@ -0,0 +1,72 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <GL/gl3w.h>
+
+#include "warhol/utils/types.h"
+
+namespace warhol {
+namespace opengl {
+
+struct StateCache;
+
+// UniformRing -----------------------------------------------------------------
+//
+// One big uniform buffer split in a section per frame in flight. Every draw's
+// uniform blocks are copied into the current section and bound with
+// glBindBufferRange, instead of re-specifying (orphaning) the shader's UBO with
+// glBufferData on every draw.
+//
+// The buffer is created with glBufferStorage and stays persistently and
+// coherently mapped, so pushing is a memcpy. A fence at the end of each frame
+// guards its section: a section is only rewritten once the GPU is done with the
+// frame that used it, kUniformRingFrames frames later.
+//
+// If glBufferStorage is not available (it is GL 4.4) the same layout is written
+// with glBufferSubData.
+
+constexpr uint32_t kUniformRingFrames = 3;
+constexpr uint32_t kUniformRingFrameSize = MEGABYTES(4);
+
+struct UniformRing {
+  uint32_t buffer = 0;
+  uint8_t* mapped = nullptr;    // Null when not persistently mapped.
+
+  uint32_t frame_size = 0;      // Size of each section.
+  uint32_t alignment = 0;       // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+
+  uint32_t section = 0;         // Section the current frame writes to.
+  uint32_t offset = 0;          // Within |section|.
+
+  GLsync fences[kUniformRingFrames] = {};
+
+  uint32_t last_frame_bytes = 0;
+
+  // Pushes that did not fit in the section (see PushUniforms).
+  uint32_t overflows = 0;
+  uint32_t last_frame_overflows = 0;
+};
+
+inline bool Valid(UniformRing* ring) { return ring->buffer != 0; }
+
+bool InitUniformRing(UniformRing*, uint32_t frame_size = kUniformRingFrameSize);
+void ShutdownUniformRing(UniformRing*);
+
+// Waits until the GPU is done with the section this frame is going to write.
+void StartUniformRingFrame(UniformRing*);
+// Fences the section written this frame and moves to the next one. Logs once
+// if any push overflowed during the frame.
+void EndUniformRingFrame(UniformRing*);
+
+// Copies |size| bytes into the ring and binds them to the uniform block
+// |binding|. Returns false when this frame's section is full, in which case
+// nothing is bound and the overflow is counted.
+bool PushUniforms(UniformRing*, StateCache*, uint32_t binding,
+                  const void* data, uint32_t size);
+
+}  // namespace opengl
+}  // namespace warhol
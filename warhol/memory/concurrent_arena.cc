@@ -0,0 +1,152 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/memory/concurrent_arena.h"
+
+#include <stdlib.h>
+
+#include "warhol/memory/memory_pool.h"
+#include "warhol/platform/platform.h"
+#include "warhol/utils/align.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+std::atomic<uint64_t> next_arena_id = 1;
+
+// The sub-blocks a thread is currently allocating from, one per arena it is
+// using. When full, the oldest one is dropped (its arena simply hands out a
+// new sub-block next time).
+struct ThreadBlock {
+  ConcurrentArena* arena = nullptr;
+  uint64_t id = 0;
+  uint8_t* current = nullptr;
+  uint8_t* end = nullptr;
+};
+
+constexpr uint32_t kThreadBlockCount = 4;
+thread_local ThreadBlock tBlocks[kThreadBlockCount];
+thread_local uint32_t tNextBlock = 0;
+
+const char* GetName(ConcurrentArena* arena) {
+  return arena->name ? arena->name : "<unnamed>";
+}
+
+// Takes |size| bytes from the shared offset. Lock-free unless new memory has
+// to be committed.
+uint8_t* TakeShared(ConcurrentArena* arena, size_t size) {
+  size_t start = arena->offset.fetch_add(size, std::memory_order_relaxed);
+  size_t end = start + size;
+  if (end > arena->size) {
+    LOG(ERROR) << "Overflowing concurrent arena " << GetName(arena)
+               << ". Size: " << arena->size << ", required: " << size;
+    abort();
+  }
+
+  if (end > arena->committed.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(arena->commit_mutex);
+    size_t committed = arena->committed.load(std::memory_order_relaxed);
+    if (end > committed) {
+      size_t new_committed = Align(end, MemoryPool::kCommitGranularity);
+      if (new_committed > arena->size)
+        new_committed = arena->size;
+      if (!CommitVirtualMemory(arena->data + committed,
+                               new_committed - committed)) {
+        LOG(ERROR) << "Could not commit memory for concurrent arena "
+                   << GetName(arena);
+        abort();
+      }
+      arena->committed.store(new_committed, std::memory_order_release);
+    }
+  }
+
+  return arena->data + start;
+}
+
+ThreadBlock* GetThreadBlock(ConcurrentArena* arena) {
+  uint64_t id = arena->id.load(std::memory_order_relaxed);
+  for (ThreadBlock& block : tBlocks) {
+    if (block.arena == arena && block.id == id)
+      return &block;
+  }
+
+  ThreadBlock* block = tBlocks + tNextBlock;
+  tNextBlock = (tNextBlock + 1) % kThreadBlockCount;
+  block->arena = arena;
+  block->id = id;
+  block->current = nullptr;
+  block->end = nullptr;
+  return block;
+}
+
+}  // namespace
+
+ConcurrentArena::~ConcurrentArena() {
+  if (Valid(this))
+    ShutdownConcurrentArena(this);
+}
+
+bool InitConcurrentArena(ConcurrentArena* arena, size_t size,
+                         size_t block_size) {
+  ASSERT(!Valid(arena));
+  ASSERT(block_size > 0);
+
+  size = Align(size, MemoryPool::kCommitGranularity);
+  auto* data = (uint8_t*)ReserveVirtualMemory(size);
+  if (!data) {
+    LOG(ERROR) << "Could not reserve " << BytesToString(size)
+               << " of address space.";
+    return false;
+  }
+
+  arena->data = data;
+  arena->size = size;
+  arena->block_size = block_size;
+  arena->offset = 0;
+  arena->committed = 0;
+  arena->id = next_arena_id++;
+  return true;
+}
+
+void ResetConcurrentArena(ConcurrentArena* arena) {
+  ASSERT(Valid(arena));
+  arena->offset = 0;
+  arena->id = next_arena_id++;
+}
+
+void ShutdownConcurrentArena(ConcurrentArena* arena) {
+  ASSERT(Valid(arena));
+  ReleaseVirtualMemory(arena->data, arena->size);
+  arena->data = nullptr;
+  arena->size = 0;
+  arena->offset = 0;
+  arena->committed = 0;
+  arena->id = 0;
+}
+
+uint8_t* Reserve(ConcurrentArena* arena, size_t size, size_t alignment) {
+  ASSERT(Valid(arena));
+  ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0)
+      << "Alignment must be a power of two: " << alignment;
+
+  // Big allocations would waste most of a sub-block.
+  if (size + alignment > arena->block_size / 4) {
+    uint8_t* ptr = TakeShared(arena, size + alignment - 1);
+    return (uint8_t*)Align((uint64_t)ptr, alignment);
+  }
+
+  ThreadBlock* block = GetThreadBlock(arena);
+  auto* ptr = (uint8_t*)Align((uint64_t)block->current, alignment);
+  if (!block->current || ptr + size > block->end) {
+    block->current = TakeShared(arena, arena->block_size);
+    block->end = block->current + arena->block_size;
+    ptr = (uint8_t*)Align((uint64_t)block->current, alignment);
+  }
+
+  block->current = ptr + size;
+  return ptr;
+}
+
+}  // namespace warhol
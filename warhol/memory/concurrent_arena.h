@@ -0,0 +1,87 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "warhol/utils/macros.h"
+#include "warhol/utils/types.h"
+
+namespace warhol {
+
+// ConcurrentArena -------------------------------------------------------------
+//
+// Bump allocator that many threads can push into at the same time (eg. workers
+// recording render actions for the same frame).
+//
+// Threads do not bump the shared offset for every allocation: each one grabs a
+// |block_size| sub-block with a single atomic fetch_add and then bump allocates
+// from it privately. Allocations bigger than a quarter of a block get their
+// own space straight from the shared offset.
+//
+// The memory is reserved up front and committed (under a lock) as sub-blocks
+// are handed out, like a virtual MemoryPool.
+//
+// Reset and Shutdown must not race with allocations (eg. call them at frame
+// boundaries). Overflowing the arena aborts.
+
+struct ConcurrentArena {
+  static constexpr size_t kDefaultBlockSize = KILOBYTES(16);
+
+  ConcurrentArena() = default;
+  ~ConcurrentArena();
+  DELETE_COPY_AND_ASSIGN(ConcurrentArena);
+  DELETE_MOVE_AND_ASSIGN(ConcurrentArena);
+
+  const char* name = nullptr;
+  uint8_t* data = nullptr;
+  size_t size = 0;
+  size_t block_size = 0;
+
+  std::atomic<size_t> offset = 0;       // Where the next sub-block starts.
+  std::atomic<size_t> committed = 0;
+  std::mutex commit_mutex;
+
+  // Threads hold on to their sub-block only while this matches. Unique across
+  // every arena, and changes on every reset.
+  std::atomic<uint64_t> id = 0;
+};
+
+inline bool Valid(ConcurrentArena* arena) { return !!arena->data; }
+
+// Includes the unused ends of the sub-blocks handed out.
+inline size_t Used(ConcurrentArena* arena) {
+  size_t offset = arena->offset.load(std::memory_order_relaxed);
+  return offset < arena->size ? offset : arena->size;
+}
+
+bool InitConcurrentArena(ConcurrentArena*, size_t bytes,
+                         size_t block_size = ConcurrentArena::kDefaultBlockSize);
+
+// Every allocation is gone. No other thread can be allocating.
+void ResetConcurrentArena(ConcurrentArena*);
+
+// RAII semantics will take care of this also.
+void ShutdownConcurrentArena(ConcurrentArena*);
+
+// Thread safe.
+uint8_t* Reserve(ConcurrentArena*, size_t size, size_t alignment);
+
+template <typename T>
+T* Push(ConcurrentArena* arena) {
+  return (T*)Reserve(arena, sizeof(T), alignof(T));
+}
+
+template <typename T>
+T* Push(ConcurrentArena* arena, T t) {
+  return new (Push<T>(arena)) T(std::move(t));
+}
+
+}  // namespace warhol
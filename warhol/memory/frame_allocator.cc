@@ -0,0 +1,51 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/memory/frame_allocator.h"
+
+#include <atomic>
+
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+std::atomic<uint64_t> frame_index = 0;
+
+struct ThreadFrameArenas {
+  MemoryPool arenas[kFrameArenaCount];
+  // Frame each arena was last reset for.
+  uint64_t frames[kFrameArenaCount] = {};
+};
+
+thread_local ThreadFrameArenas tArenas;
+
+}  // namespace
+
+void AdvanceFrameAllocators() {
+  frame_index.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t GetFrameAllocatorIndex() {
+  return frame_index.load(std::memory_order_acquire);
+}
+
+MemoryPool* GetFrameArena() {
+  uint64_t frame = GetFrameAllocatorIndex();
+  uint32_t index = frame % kFrameArenaCount;
+  MemoryPool* arena = tArenas.arenas + index;
+
+  if (!Valid(arena)) {
+    arena->name = "Frame Arena";
+    if (!InitVirtualMemoryPool(arena, kFrameArenaSize))
+      NOT_REACHED() << "Could not reserve a frame arena.";
+  } else if (tArenas.frames[index] != frame) {
+    ResetMemoryPool(arena);
+  }
+
+  tArenas.frames[index] = frame;
+  return arena;
+}
+
+}  // namespace warhol
@@ -0,0 +1,40 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "warhol/memory/memory_pool.h"
+
+namespace warhol {
+
+// Frame Allocators ------------------------------------------------------------
+//
+// Memory for transient per-frame data (command lists, mesh actions, window
+// events, etc.) that does not need to be freed piecemeal.
+//
+// Every thread gets one arena per frame in flight (kFrameArenaCount). The arena
+// for frame N is reset the first time the thread asks for it during frame N,
+// so whatever is allocated from it stays valid until frame
+// N + kFrameArenaCount begins. This is what lets the renderer read frame N's
+// commands while frame N + 1 is being simulated on another thread.
+//
+// Arenas are virtual pools reserved on first use: once they have grown to the
+// steady state working set, frames allocate without ever calling malloc.
+//
+// There is no locking involved: every thread only touches its own arenas.
+
+constexpr uint32_t kFrameArenaCount = 2;
+constexpr size_t kFrameArenaSize = MEGABYTES(32);
+
+// Starts a new frame for every thread's allocators. Must be called once per
+// frame by the thread driving the frame loop (FramePipeline does it).
+void AdvanceFrameAllocators();
+
+uint64_t GetFrameAllocatorIndex();
+
+// Arena of the calling thread for the current frame.
+MemoryPool* GetFrameArena();
+
+}  // namespace warhol
@@ -0,0 +1,170 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+// Replaces the global operator new/delete to count heap allocations (see
+// "Heap Allocations" in memory_tracker.h). Only built with the
+// track_allocations gn arg.
+//
+// Every allocation gets a header right before the returned pointer with its
+// size and tag, so frees can be attributed without any lookup.
+
+#include <stdlib.h>
+
+#include <new>
+
+#include "warhol/memory/memory_tracker.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace warhol {
+namespace {
+
+struct AllocationHeader {
+  uint64_t size;
+  uint32_t offset;        // From the start of the underlying allocation.
+  AllocationTag tag;
+};
+
+constexpr size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+static_assert(sizeof(AllocationHeader) <= kDefaultAlignment,
+              "The header must fit in the default alignment.");
+
+AllocationHeader* GetHeader(void* ptr) {
+  return (AllocationHeader*)ptr - 1;
+}
+
+void* TrackedAllocate(size_t size, size_t alignment) {
+  // The header takes a whole alignment unit so the payload stays aligned.
+  size_t offset = alignment > kDefaultAlignment ? alignment : kDefaultAlignment;
+
+  uint8_t* raw = nullptr;
+  if (alignment > kDefaultAlignment) {
+#if defined(_MSC_VER)
+    raw = (uint8_t*)_aligned_malloc(offset + size, alignment);
+#else
+    size_t total = (offset + size + alignment - 1) & ~(alignment - 1);
+    raw = (uint8_t*)aligned_alloc(alignment, total);
+#endif
+  } else {
+    raw = (uint8_t*)malloc(offset + size);
+  }
+
+  if (!raw)
+    return nullptr;
+
+  void* ptr = raw + offset;
+  AllocationHeader* header = GetHeader(ptr);
+  header->size = size;
+  header->offset = (uint32_t)offset;
+  header->tag = GetCurrentAllocationTag();
+
+  RecordHeapAllocation(size, header->tag);
+  return ptr;
+}
+
+void TrackedFree(void* ptr) {
+  if (!ptr)
+    return;
+
+  AllocationHeader* header = GetHeader(ptr);
+  RecordHeapFree(header->size, header->tag);
+
+  uint8_t* raw = (uint8_t*)ptr - header->offset;
+#if defined(_MSC_VER)
+  if (header->offset > kDefaultAlignment) {
+    _aligned_free(raw);
+    return;
+  }
+#endif
+  free(raw);
+}
+
+void* TrackedAllocateOrThrow(size_t size, size_t alignment) {
+  void* ptr = TrackedAllocate(size, alignment);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+}  // namespace
+}  // namespace warhol
+
+using warhol::TrackedAllocate;
+using warhol::TrackedAllocateOrThrow;
+using warhol::TrackedFree;
+using warhol::kDefaultAlignment;
+
+void* operator new(size_t size) {
+  return TrackedAllocateOrThrow(size, kDefaultAlignment);
+}
+
+void* operator new[](size_t size) {
+  return TrackedAllocateOrThrow(size, kDefaultAlignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return TrackedAllocate(size, kDefaultAlignment);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return TrackedAllocate(size, kDefaultAlignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return TrackedAllocateOrThrow(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return TrackedAllocateOrThrow(size, (size_t)alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return TrackedAllocate(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return TrackedAllocate(size, (size_t)alignment);
+}
+
+void operator delete(void* ptr) noexcept { TrackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { TrackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { TrackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { TrackedFree(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  TrackedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  TrackedFree(ptr);
+}
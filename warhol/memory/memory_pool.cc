@@ -3,18 +3,101 @@
 
 #include "warhol/memory/memory_pool.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "warhol/platform/platform.h"
 #include "warhol/utils/log.h"
 
 namespace warhol {
 
+namespace {
+
+void Overflow(MemoryPool* pool, size_t size, size_t alignment) {
+  NOT_REACHED() << "Overflowing pool!" << std::endl
+                << "Size: " << pool->size << std::endl
+                << "Used: " << Used(pool) << std::endl
+                << " (diff: " << pool->size - Used(pool) << ")." << std::endl
+                << "Required: " << size << " (alignment " << alignment
+                << ").";
+
+  // Release builds: writing past the pool would corrupt whatever is next.
+  LOG(ERROR) << "Overflowing pool " << (pool->name ? pool->name : "<unnamed>")
+             << ". Size: " << pool->size << ", required: " << size;
+  abort();
+}
+
+// Makes sure everything up to |end| is committed.
+void Grow(MemoryPool* pool, uint8_t* end, size_t size, size_t alignment) {
+  size_t needed = end - pool->data.get();
+  if (!pool->is_virtual || needed > pool->size)
+    Overflow(pool, size, alignment);
+
+  size_t committed = Align(needed, MemoryPool::kCommitGranularity);
+  if (committed > pool->size)
+    committed = pool->size;
+
+  uint8_t* start = pool->data.get() + pool->committed;
+  if (!CommitVirtualMemory(start, committed - pool->committed)) {
+    LOG(ERROR) << "Could not commit memory for pool "
+               << (pool->name ? pool->name : "<unnamed>");
+    abort();
+  }
+  pool->committed = committed;
+}
+
+}  // namespace
+
+void PoolMemoryDeleter::operator()(uint8_t* data) const {
+  if (reserved > 0) {
+    ReleaseVirtualMemory(data, reserved);
+  } else {
+    delete[] data;
+  }
+}
+
 void InitMemoryPool(MemoryPool* pool, size_t size) {
   ASSERT(!Valid(pool));
   pool->size = size;
-  pool->data = std::make_unique<uint8_t[]>(size);
+  pool->committed = size;
+  pool->is_virtual = false;
+  pool->data = std::unique_ptr<uint8_t[], PoolMemoryDeleter>(
+      new uint8_t[size](), PoolMemoryDeleter{});
   pool->current = pool->data.get();
 }
 
+bool InitVirtualMemoryPool(MemoryPool* pool, size_t size) {
+  ASSERT(!Valid(pool));
+  size = Align(size, MemoryPool::kCommitGranularity);
+  auto* data = (uint8_t*)ReserveVirtualMemory(size);
+  if (!data) {
+    LOG(ERROR) << "Could not reserve " << BytesToString(size)
+               << " of address space.";
+    return false;
+  }
+
+  pool->size = size;
+  pool->committed = 0;
+  pool->is_virtual = true;
+  pool->data = std::unique_ptr<uint8_t[], PoolMemoryDeleter>(
+      data, PoolMemoryDeleter{size});
+  pool->current = pool->data.get();
+  return true;
+}
+
 void ResetMemoryPool(MemoryPool* pool) {
+  size_t used = pool->current - pool->data.get();
+  if (used * 100 > pool->size * MemoryPool::kNearMissPercent)
+    pool->stats.near_misses++;
+
+  if (pool->is_virtual) {
+    size_t keep = Align(used, MemoryPool::kCommitGranularity);
+    if (keep < pool->committed) {
+      DecommitVirtualMemory(pool->data.get() + keep, pool->committed - keep);
+      pool->committed = keep;
+    }
+  }
+
   pool->current = pool->data.get();
 }
 
@@ -26,38 +109,48 @@ MemoryPool::~MemoryPool() {
 void ShutdownMemoryPool(MemoryPool* pool) {
   ASSERT(Valid(pool));
 
+  if (Valid(&pool->track_token))
+    Untrack(&pool->track_token);
+
   pool->size = 0;
+  pool->committed = 0;
+  pool->is_virtual = false;
   pool->current = nullptr;
   pool->data.reset();
+  pool->stats = {};
 }
 
 uint8_t* Push(MemoryPool* pool, uint8_t* data, size_t size) {
-  ASSERT(Valid(pool));
-#if DEBUG_MODE
-  if (pool->current + size > pool->data.get() + pool->size) {
-    NOT_REACHED() << "Overflowing pool!" << std::endl
-                  << "Size: " << pool->size << std::endl
-                  << "Used: " << Used(pool) << std::endl
-                  << " (diff: " << pool->size - Used(pool) << ")." << std::endl
-                  << "Required: " << size;
-  }
-#endif
+  return Push(pool, data, size, 1);
+}
 
-  uint8_t* return_ptr = pool->current;
-  uint8_t* ptr = pool->current;
-  for (size_t i = 0; i < size; i++) {
-    *ptr++ = *data++;
-  }
-  pool->current += size;
-  return return_ptr;
+uint8_t* Push(MemoryPool* pool, uint8_t* data, size_t size, size_t alignment) {
+  uint8_t* ptr = Reserve(pool, size, alignment);
+  memcpy(ptr, data, size);
+  return ptr;
 }
 
 uint8_t* Reserve(MemoryPool* pool, size_t size) {
+  return Reserve(pool, size, 1);
+}
+
+uint8_t* Reserve(MemoryPool* pool, size_t size, size_t alignment) {
   ASSERT(Valid(pool));
-  ASSERT(pool->current + size < pool->data.get() + pool->size);
+  ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0)
+      << "Alignment must be a power of two: " << alignment;
+
+  // Aligning the address (and not the offset) is what matters to the hardware.
+  uint8_t* ptr = (uint8_t*)Align((uint64_t)pool->current, alignment);
+  if (ptr + size > pool->data.get() + pool->committed)
+    Grow(pool, ptr + size, size, alignment);
+
+  pool->current = ptr + size;
+
+  pool->stats.allocations++;
+  size_t used = pool->current - pool->data.get();
+  if (used > pool->stats.peak_used)
+    pool->stats.peak_used = used;
 
-  uint8_t* ptr = pool->current;
-  pool->current += size;
   return ptr;
 }
 
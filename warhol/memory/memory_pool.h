@@ -8,20 +8,53 @@
 #include <memory>
 
 #include "warhol/memory/memory_tracker.h"
+#include "warhol/utils/align.h"
 #include "warhol/utils/log.h"
 #include "warhol/utils/types.h"
 
 namespace warhol {
 
+// A pool is either:
+//
+// - Committed (InitMemoryPool): all the memory is allocated (and zeroed) up
+//   front.
+// - Virtual (InitVirtualMemoryPool): only address space is reserved. Memory is
+//   committed in |kCommitGranularity| steps as |current| advances, so a pool
+//   sized for the worst case only costs what it actually uses.
+//
+// Both check for overflow in every build.
+
+// Frees either kind of pool memory.
+struct PoolMemoryDeleter {
+  size_t reserved = 0;    // Non-zero for virtual pools.
+  void operator()(uint8_t*) const;
+};
+
+// Read by the MemoryTracker.
+struct MemoryPoolStats {
+  size_t peak_used = 0;
+  uint64_t allocations = 0;
+  uint32_t near_misses = 0;     // Resets above kNearMissPercent of the size.
+};
+
 struct MemoryPool {
+  static constexpr size_t kCommitGranularity = KILOBYTES(64);
+  static constexpr size_t kNearMissPercent = 90;
+
   RAII_CONSTRUCTORS(MemoryPool);
 
   const char* name = nullptr;
   size_t size = 0;                // In bytes.
   uint8_t* current = nullptr;     // Where the next byte will be taken from.
 
-  std::unique_ptr<uint8_t[]> data;
+  // Bytes from the start of |data| backed by memory. Always |size| for
+  // committed pools.
+  size_t committed = 0;
+  bool is_virtual = false;
 
+  std::unique_ptr<uint8_t[], PoolMemoryDeleter> data;
+
+  MemoryPoolStats stats;
   TrackToken track_token;
 };
 
@@ -39,7 +72,13 @@ inline size_t Used(MemoryPool* pool) {
 
 void InitMemoryPool(MemoryPool*, size_t bytes);
 
+// |bytes| is the most the pool can ever grow to (rounded up to
+// kCommitGranularity). Returns false if the address space is not available.
+bool InitVirtualMemoryPool(MemoryPool*, size_t bytes);
+
 // Will not deallocate, but rather treat the memory as cleared.
+// Virtual pools decommit whatever was not used since the last reset, so a
+// spike is given back but the steady state does not fault pages every time.
 void ResetMemoryPool(MemoryPool*);
 
 // RAII semantics will take care of this also.
@@ -48,21 +87,21 @@ void ShutdownMemoryPool(MemoryPool*);
 // Pushes arbitraty data into the memory pool.
 uint8_t* Push(MemoryPool*, uint8_t* data, size_t size);
 
+// Same, but the data will start at a multiple of |alignment| (a power of two).
+uint8_t* Push(MemoryPool*, uint8_t* data, size_t size, size_t alignment);
+
 uint8_t* Reserve(MemoryPool*, size_t size);
+uint8_t* Reserve(MemoryPool*, size_t size, size_t alignment);
 
+// Typed versions are aligned to alignof(T).
 template <typename T>
 T* Push(MemoryPool* pool, T* data, size_t count) {
-  return (T*)Push(pool, (uint8_t*)data, sizeof(T) * count);
+  return (T*)Push(pool, (uint8_t*)data, sizeof(T) * count, alignof(T));
 }
 
 template <typename T>
 T* Push(MemoryPool* pool) {
-  ASSERT(Valid(pool));
-  ASSERT(pool->current + sizeof(T) < pool->data.get() + pool->size);
-
-  T* value = (T*)pool->current;
-  pool->current += sizeof(T);
-  return value;
+  return (T*)Reserve(pool, sizeof(T), alignof(T));
 }
 
 template <typename T>
@@ -72,4 +111,36 @@ T* Push(MemoryPool* pool, T t) {
   return val;
 }
 
+// Markers ---------------------------------------------------------------------
+//
+// Permit using the pool as a stack for temporary allocations:
+//
+//   PoolMarker marker = GetMarker(pool);
+//   <push scratch data>
+//   RollbackToMarker(pool, marker);   // Everything after the marker is gone.
+//
+// ScopedPoolMarker does the rollback when going out of scope.
+
+struct PoolMarker {
+  size_t used = 0;
+};
+
+inline PoolMarker GetMarker(MemoryPool* pool) { return {Used(pool)}; }
+
+inline void RollbackToMarker(MemoryPool* pool, PoolMarker marker) {
+  ASSERT(marker.used <= Used(pool)) << "Marker is past the current position.";
+  pool->current = pool->data.get() + marker.used;
+}
+
+struct ScopedPoolMarker {
+  ScopedPoolMarker(MemoryPool* pool) : pool(pool), marker(GetMarker(pool)) {}
+  ~ScopedPoolMarker() { RollbackToMarker(pool, marker); }
+
+  DELETE_COPY_AND_ASSIGN(ScopedPoolMarker);
+  DELETE_MOVE_AND_ASSIGN(ScopedPoolMarker);
+
+  MemoryPool* pool;
+  PoolMarker marker;
+};
+
 }  // namespace warhol
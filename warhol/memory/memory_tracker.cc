@@ -3,15 +3,25 @@
 
 #include "warhol/memory/memory_tracker.h"
 
-#include <atomic>
-#include <mutex>
-
-#include "warhol/graphics/common/mesh.h"
 #include "warhol/memory/memory_pool.h"
+#include "warhol/memory/slab_allocator.h"
+#include "warhol/utils/file.h"
 #include "warhol/utils/log.h"
+#include "warhol/utils/string.h"
 
 namespace warhol {
 
+const char* ToString(TrackType type) {
+  switch (type) {
+    case TrackType::kMemoryPool: return "MemoryPool";
+    case TrackType::kSlabAllocator: return "SlabAllocator";
+    case TrackType::kLast: return "<last>";
+  }
+
+  NOT_REACHED() << "Unknown track type: " << (uint32_t)type;
+  return nullptr;
+}
+
 // TrackToken ------------------------------------------------------------------
 
 namespace {
@@ -45,6 +55,11 @@ TrackToken& TrackToken::operator=(TrackToken&& other) {
   // If something is being tracker, it cannot move!
   ASSERT(!Valid(&other));
 
+  // Whatever we were tracking is being replaced, so the registry must not
+  // keep pointing at it.
+  if (Valid(this))
+    Untrack(this);
+
   type = other.type;
   id = other.id;
   Clear(&other);
@@ -53,14 +68,75 @@ TrackToken& TrackToken::operator=(TrackToken&& other) {
 
 // MemoryTracker ---------------------------------------------------------------
 
-
 namespace {
 
-std::mutex gMutex;
+MemoryTracker gMemoryTracker;
 
-std::atomic<uint32_t> gNextMemoryPoolID = 1;
+uint32_t Register(void* object, TrackType type) {
+  for (uint32_t i = 0; i < MemoryTracker::kMaxTracked; i++) {
+    MemoryTracker::Entry& entry = gMemoryTracker.entries[i];
+    void* expected = nullptr;
+    if (!entry.object.compare_exchange_strong(expected, object,
+                                              std::memory_order_acq_rel)) {
+      continue;
+    }
 
-MemoryTracker gMemoryTracker;
+    entry.allocations_at_frame_start.store(0, std::memory_order_relaxed);
+    entry.allocations_last_frame.store(0, std::memory_order_relaxed);
+    entry.type.store(type, std::memory_order_release);
+    return i + 1;
+  }
+
+  LOG(ERROR) << "Memory tracker is full (" << MemoryTracker::kMaxTracked
+             << " entries). Not tracking " << ToString(type) << ".";
+  return 0;
+}
+
+uint64_t GetTotalAllocations(TrackType type, void* object) {
+  switch (type) {
+    case TrackType::kMemoryPool:
+      return ((MemoryPool*)object)->stats.allocations;
+    case TrackType::kSlabAllocator:
+    case TrackType::kLast:
+      break;
+  }
+
+  return 0;
+}
+
+void FillStats(TrackType type, void* object, TrackedStats* stats) {
+  switch (type) {
+    case TrackType::kMemoryPool: {
+      auto* pool = (MemoryPool*)object;
+      if (!Valid(pool))
+        return;
+      stats->name = pool->name;
+      stats->reserved = pool->size;
+      stats->committed = pool->committed;
+      stats->used = Used(pool);
+      stats->peak_used = pool->stats.peak_used;
+      stats->total_allocations = pool->stats.allocations;
+      stats->near_misses = pool->stats.near_misses;
+      return;
+    }
+    case TrackType::kSlabAllocator: {
+      auto* slab = (SlabAllocator*)object;
+      if (!Valid(slab))
+        return;
+      stats->name = slab->name;
+      stats->reserved = GetReservedBytes(slab);
+      stats->committed = stats->reserved;
+      stats->used = GetLiveCount(slab) * slab->object_size;
+      // Slabs are never given back, so the capacity is the high-water mark.
+      stats->peak_used = GetCapacity(slab) * slab->object_size;
+      return;
+    }
+    case TrackType::kLast:
+      break;
+  }
+
+  NOT_REACHED() << "Invalid track type: " << (uint32_t)type;
+}
 
 }  // namespace
 
@@ -68,47 +144,241 @@ const MemoryTracker& GetGlobalTracker() {
   return gMemoryTracker;
 }
 
-
 void Track(MemoryPool* pool) {
-  uint32_t id = gNextMemoryPoolID++;
-
-  {
-    std::lock_guard<std::mutex> lock(gMutex);
-    gMemoryTracker.tracked_pools[id] = pool;
-  }
+  ASSERT(!Valid(&pool->track_token));
+  uint32_t id = Register(pool, TrackType::kMemoryPool);
+  if (id == 0)
+    return;
 
-  LOG(DEBUG) << "Tracking Memory Pool " << id;
   pool->track_token.id = id;
   pool->track_token.type = TrackType::kMemoryPool;
 }
 
-// Untrack
+void Track(SlabAllocator* slab) {
+  ASSERT(!Valid(&slab->track_token));
+  uint32_t id = Register(slab, TrackType::kSlabAllocator);
+  if (id == 0)
+    return;
 
-namespace {
+  slab->track_token.id = id;
+  slab->track_token.type = TrackType::kSlabAllocator;
+}
+
+void Untrack(TrackToken* token) {
+  ASSERT(Valid(token));
+  ASSERT(token->id <= MemoryTracker::kMaxTracked);
 
+  MemoryTracker::Entry& entry = gMemoryTracker.entries[token->id - 1];
+  ASSERT(entry.type.load(std::memory_order_relaxed) == token->type);
+  entry.type.store(TrackType::kLast, std::memory_order_release);
+  entry.object.store(nullptr, std::memory_order_release);
 
+  Clear(token);
+}
+
+namespace {
+
+void HeapNewFrame();
 
 }  // namespace
 
-void Untrack(TrackToken* token) {
-  LOG(DEBUG) << "Untracking "<< token->id;
-  ASSERT(Valid(token));
-  {
-    std::lock_guard<std::mutex> lock(gMutex);
-    switch (token->type) {
-      case TrackType::kMemoryPool: {
-        auto it = gMemoryTracker.tracked_pools.find(token->id);
-        ASSERT(it != gMemoryTracker.tracked_pools.end());
-        gMemoryTracker.tracked_pools.erase(it);
-        break;
-      }
-      case TrackType::kLast:
-        NOT_REACHED() << "Invalid track type: " << (uint32_t)token->type;
-        break;
-    }
+void MemoryTrackerNewFrame() {
+  for (MemoryTracker::Entry& entry : gMemoryTracker.entries) {
+    TrackType type = entry.type.load(std::memory_order_acquire);
+    if (type == TrackType::kLast)
+      continue;
+
+    void* object = entry.object.load(std::memory_order_acquire);
+    if (!object)
+      continue;
+
+    uint64_t total = GetTotalAllocations(type, object);
+    uint64_t start =
+        entry.allocations_at_frame_start.load(std::memory_order_relaxed);
+    entry.allocations_last_frame.store((uint32_t)(total - start),
+                                       std::memory_order_relaxed);
+    entry.allocations_at_frame_start.store(total, std::memory_order_relaxed);
   }
 
-  Clear(token);
+  HeapNewFrame();
+  gMemoryTracker.frame_index++;
+}
+
+// Stats -----------------------------------------------------------------------
+
+std::vector<TrackedStats> GetTrackedStats() {
+  std::vector<TrackedStats> result;
+  for (uint32_t i = 0; i < MemoryTracker::kMaxTracked; i++) {
+    MemoryTracker::Entry& entry = gMemoryTracker.entries[i];
+    TrackType type = entry.type.load(std::memory_order_acquire);
+    if (type == TrackType::kLast)
+      continue;
+
+    void* object = entry.object.load(std::memory_order_acquire);
+    if (!object)
+      continue;
+
+    TrackedStats stats = {};
+    stats.id = i + 1;
+    stats.type = type;
+    stats.allocations_last_frame =
+        entry.allocations_last_frame.load(std::memory_order_relaxed);
+    FillStats(type, object, &stats);
+    result.push_back(stats);
+  }
+
+  return result;
+}
+
+TrackedStats GetTrackedTotals(const std::vector<TrackedStats>& stats) {
+  TrackedStats totals = {};
+  totals.name = "Total";
+  for (const TrackedStats& entry : stats) {
+    totals.reserved += entry.reserved;
+    totals.committed += entry.committed;
+    totals.used += entry.used;
+    totals.peak_used += entry.peak_used;
+    totals.allocations_last_frame += entry.allocations_last_frame;
+    totals.total_allocations += entry.total_allocations;
+    totals.near_misses += entry.near_misses;
+  }
+
+  return totals;
+}
+
+std::string MemoryTrackerToCSV(const std::vector<TrackedStats>& stats) {
+  std::string csv =
+      "id,type,name,reserved,committed,used,peak_used,"
+      "allocations_last_frame,total_allocations,near_misses\n";
+  for (const TrackedStats& entry : stats) {
+    csv += StringPrintf("%u,%s,%s,%zu,%zu,%zu,%zu,%u,%llu,%u\n",
+                        entry.id, ToString(entry.type),
+                        entry.name ? entry.name : "",
+                        entry.reserved, entry.committed, entry.used,
+                        entry.peak_used, entry.allocations_last_frame,
+                        (unsigned long long)entry.total_allocations,
+                        entry.near_misses);
+  }
+
+  return csv;
+}
+
+bool DumpMemoryTrackerCSV(const std::string& path) {
+  FileHandle file = OpenFile(path);
+  if (!Valid(&file)) {
+    LOG(ERROR) << "Could not open " << path << " for the memory stats.";
+    return false;
+  }
+
+  std::string csv = MemoryTrackerToCSV(GetTrackedStats());
+  WriteToFile(&file, csv.data(), csv.size());
+  return true;
+}
+
+// Heap Allocations ------------------------------------------------------------
+
+const char* ToString(AllocationTag tag) {
+  switch (tag) {
+    case AllocationTag::kUntagged: return "Untagged";
+    case AllocationTag::kRenderer: return "Renderer";
+    case AllocationTag::kMeshes: return "Meshes";
+    case AllocationTag::kShaders: return "Shaders";
+    case AllocationTag::kTextures: return "Textures";
+    case AllocationTag::kWindow: return "Window";
+    case AllocationTag::kImgui: return "Imgui";
+    case AllocationTag::kGame: return "Game";
+    case AllocationTag::kLast: return "<last>";
+  }
+
+  NOT_REACHED() << "Unknown allocation tag: " << (uint32_t)tag;
+  return nullptr;
+}
+
+namespace {
+
+constexpr size_t kTagCount = (size_t)AllocationTag::kLast;
+
+// Constant initialized, so they are ready before any static constructor calls
+// operator new.
+struct HeapCounters {
+  std::atomic<uint64_t> allocations = 0;
+  std::atomic<uint64_t> frees = 0;
+  std::atomic<uint64_t> allocated_bytes = 0;
+  std::atomic<uint64_t> freed_bytes = 0;
+};
+HeapCounters gHeapCounters[kTagCount];
+
+// Only touched by MemoryTrackerNewFrame.
+HeapStats gHeapFrameStart[kTagCount];
+HeapStats gHeapLastFrame[kTagCount];
+
+thread_local AllocationTag tAllocationTag = AllocationTag::kUntagged;
+
+HeapStats LoadHeapStats(AllocationTag tag) {
+  HeapCounters& counters = gHeapCounters[(size_t)tag];
+  HeapStats stats;
+  stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+  stats.frees = counters.frees.load(std::memory_order_relaxed);
+  stats.allocated_bytes =
+      counters.allocated_bytes.load(std::memory_order_relaxed);
+  stats.freed_bytes = counters.freed_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void HeapNewFrame() {
+  for (size_t i = 0; i < kTagCount; i++) {
+    HeapStats total = LoadHeapStats((AllocationTag)i);
+    HeapStats& start = gHeapFrameStart[i];
+    HeapStats& last = gHeapLastFrame[i];
+    last.allocations = total.allocations - start.allocations;
+    last.frees = total.frees - start.frees;
+    last.allocated_bytes = total.allocated_bytes - start.allocated_bytes;
+    last.freed_bytes = total.freed_bytes - start.freed_bytes;
+    start = total;
+  }
+}
+
+}  // namespace
+
+ScopedAllocationTag::ScopedAllocationTag(AllocationTag tag)
+    : previous(tAllocationTag) {
+  tAllocationTag = tag;
+}
+
+ScopedAllocationTag::~ScopedAllocationTag() {
+  tAllocationTag = previous;
+}
+
+AllocationTag GetCurrentAllocationTag() {
+  return tAllocationTag;
+}
+
+bool HeapTrackingEnabled() {
+#if defined(WARHOL_TRACK_ALLOCATIONS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RecordHeapAllocation(size_t size, AllocationTag tag) {
+  HeapCounters& counters = gHeapCounters[(size_t)tag];
+  counters.allocations.fetch_add(1, std::memory_order_relaxed);
+  counters.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void RecordHeapFree(size_t size, AllocationTag tag) {
+  HeapCounters& counters = gHeapCounters[(size_t)tag];
+  counters.frees.fetch_add(1, std::memory_order_relaxed);
+  counters.freed_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+HeapStats GetHeapFrameStats(AllocationTag tag) {
+  return gHeapLastFrame[(size_t)tag];
+}
+
+HeapStats GetHeapTotalStats(AllocationTag tag) {
+  return LoadHeapStats(tag);
 }
 
 }  // namespace warhol
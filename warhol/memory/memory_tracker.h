@@ -3,7 +3,9 @@
 
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <string>
+#include <vector>
 
 #include "warhol/utils/log.h"
 
@@ -11,9 +13,11 @@ namespace warhol {
 
 struct MemoryPool;
 struct Mesh;
+struct SlabAllocator;
 
 enum class TrackType : uint32_t {
   kMemoryPool,
+  kSlabAllocator,
   kLast,
 };
 const char* ToString(TrackType);
@@ -31,16 +35,136 @@ inline bool
 Valid(TrackToken* t) { return t->type != TrackType::kLast && t->id != 0; }
 
 // Memory Tracker --------------------------------------------------------------
+//
+// Global registry of allocators, so their usage can be seen (imgui window,
+// CSV dump) and pools can be sized from data instead of guesses.
+//
+// Registration claims a free slot with a CAS, so tracking and untracking never
+// lock. Reading stats of an allocator that is being used by another thread is
+// racy, so numbers are approximate in that case (good enough for a panel).
+//
+// MemoryTrackerNewFrame (called by the frame pipeline) closes a frame, which is
+// what the per frame allocation counts are measured against.
 
 struct MemoryTracker {
-  std::map<uint32_t, MemoryPool*> tracked_pools;
+  static constexpr uint32_t kMaxTracked = 256;
+
+  struct Entry {
+    // |object| claims the slot. |type| is set after it and cleared before the
+    // slot is released, so seeing a valid |type| means |object| can be read.
+    std::atomic<void*> object = nullptr;
+    std::atomic<TrackType> type = TrackType::kLast;
+
+    // Written by MemoryTrackerNewFrame, and reset by registration, which can
+    // happen concurrently from any thread.
+    std::atomic<uint64_t> allocations_at_frame_start = 0;
+    std::atomic<uint32_t> allocations_last_frame = 0;
+  };
+
+  Entry entries[kMaxTracked];
+  std::atomic<uint64_t> frame_index = 0;
 };
 
 const MemoryTracker& GetGlobalTracker();
 
 // Track will be specialized in the .cc
+// Tracked objects are untracked when shut down, destroyed or moved over.
 void Track(MemoryPool*);
+void Track(SlabAllocator*);
 
 void Untrack(TrackToken*);
 
+void MemoryTrackerNewFrame();
+
+// Stats -----------------------------------------------------------------------
+
+struct TrackedStats {
+  uint32_t id = 0;
+  TrackType type = TrackType::kLast;
+  const char* name = nullptr;
+
+  size_t reserved = 0;      // Address space (or memory) set aside.
+  size_t committed = 0;     // Actually backed by memory.
+  size_t used = 0;
+  size_t peak_used = 0;
+
+  uint32_t allocations_last_frame = 0;
+  uint64_t total_allocations = 0;
+  uint32_t near_misses = 0;
+};
+
+// One per tracked allocator.
+std::vector<TrackedStats> GetTrackedStats();
+
+// Sum over every tracked allocator.
+TrackedStats GetTrackedTotals(const std::vector<TrackedStats>&);
+
+// Header plus one line per tracked allocator.
+std::string MemoryTrackerToCSV(const std::vector<TrackedStats>&);
+bool DumpMemoryTrackerCSV(const std::string& path);
+
+// Heap Allocations ------------------------------------------------------------
+//
+// Opt-in (gn arg track_allocations = true): global operator new/delete are
+// replaced (see heap_hooks.cc) to count every heap allocation, attributed to
+// the subsystem tag of the calling thread:
+//
+//   void RendererExecuteCommands(...) {
+//     SCOPED_ALLOCATION_TAG(kRenderer);
+//     ...
+//   }
+//
+// Tags nest and are per-thread. Memory freed under another tag still counts
+// against the tag it was allocated with. MemoryTrackerNewFrame turns the
+// running totals into per frame numbers, which is what a steady state frame
+// should get down to 0. Without the hooks everything reads as 0.
+
+enum class AllocationTag : uint32_t {
+  kUntagged,
+  kRenderer,
+  kMeshes,
+  kShaders,
+  kTextures,
+  kWindow,
+  kImgui,
+  kGame,
+  kLast,
+};
+const char* ToString(AllocationTag);
+
+#define SCOPED_ALLOCATION_TAG(tag) \
+  ::warhol::ScopedAllocationTag STRINGIFY(__allocation_tag_, __LINE__)( \
+      ::warhol::AllocationTag::tag)
+
+struct ScopedAllocationTag {
+  ScopedAllocationTag(AllocationTag);
+  ~ScopedAllocationTag();
+  DELETE_COPY_AND_ASSIGN(ScopedAllocationTag);
+  DELETE_MOVE_AND_ASSIGN(ScopedAllocationTag);
+
+  AllocationTag previous;
+};
+
+AllocationTag GetCurrentAllocationTag();
+
+// Whether the allocation hooks are compiled in.
+bool HeapTrackingEnabled();
+
+// Called by the hooks. Cannot allocate. Frees are attributed to the tag the
+// memory was allocated with.
+void RecordHeapAllocation(size_t size, AllocationTag);
+void RecordHeapFree(size_t size, AllocationTag);
+
+struct HeapStats {
+  uint64_t allocations = 0;
+  uint64_t frees = 0;
+  uint64_t allocated_bytes = 0;
+  uint64_t freed_bytes = 0;
+};
+
+// During the last closed frame, per tag.
+HeapStats GetHeapFrameStats(AllocationTag);
+// Since startup, per tag.
+HeapStats GetHeapTotalStats(AllocationTag);
+
 }  // namespace warhol
@@ -0,0 +1,321 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/memory/slab_allocator.h"
+
+#include <stdlib.h>
+
+#include "warhol/platform/platform.h"
+#include "warhol/utils/align.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+constexpr uint32_t kNoThreadCache = (uint32_t)-1;
+
+// Thread Cache Slots ----------------------------------------------------------
+//
+// Every thread gets the same cache index for every allocator. The index is
+// given back when the thread exits, after flushing that cache of every
+// allocator using thread caches (which is why they are registered here).
+
+struct ThreadCacheRegistry {
+  std::mutex mutex;
+  std::vector<SlabAllocator*> allocators;
+  std::vector<uint32_t> free_indices;
+  uint32_t next_index = 0;
+};
+
+ThreadCacheRegistry& GetThreadCacheRegistry() {
+  static ThreadCacheRegistry registry;
+  return registry;
+}
+
+void FlushThreadCache(SlabAllocator*, uint32_t index);
+
+// Its destructor is the thread exit hook.
+struct ThreadCacheSlot {
+  ~ThreadCacheSlot();
+
+  uint32_t index = kNoThreadCache;
+  bool assigned = false;
+};
+
+ThreadCacheSlot::~ThreadCacheSlot() {
+  if (index == kNoThreadCache)
+    return;
+
+  ThreadCacheRegistry& registry = GetThreadCacheRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (SlabAllocator* slab : registry.allocators)
+    FlushThreadCache(slab, index);
+  registry.free_indices.push_back(index);
+}
+
+uint32_t AcquireThreadCacheIndex() {
+  ThreadCacheRegistry& registry = GetThreadCacheRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (!registry.free_indices.empty()) {
+    uint32_t index = registry.free_indices.back();
+    registry.free_indices.pop_back();
+    return index;
+  }
+
+  if (registry.next_index < SlabAllocator::kMaxThreadCaches)
+    return registry.next_index++;
+  return kNoThreadCache;
+}
+
+uint32_t GetThreadCacheIndex() {
+  thread_local ThreadCacheSlot slot;
+  if (!slot.assigned) {
+    slot.index = AcquireThreadCacheIndex();
+    slot.assigned = true;
+  }
+
+  return slot.index;
+}
+
+void RegisterThreadCaches(SlabAllocator* slab) {
+  ThreadCacheRegistry& registry = GetThreadCacheRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.allocators.push_back(slab);
+}
+
+void UnregisterThreadCaches(SlabAllocator* slab) {
+  ThreadCacheRegistry& registry = GetThreadCacheRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto& allocators = registry.allocators;
+  for (size_t i = 0; i < allocators.size(); i++) {
+    if (allocators[i] == slab) {
+      allocators[i] = allocators.back();
+      allocators.pop_back();
+      return;
+    }
+  }
+}
+
+SlabAllocator::ThreadCache* GetThreadCache(SlabAllocator* slab) {
+  if (!slab->caches)
+    return nullptr;
+
+  uint32_t index = GetThreadCacheIndex();
+  if (index == kNoThreadCache)
+    return nullptr;
+  return slab->caches.get() + index;
+}
+
+// Chains every object of a new slab into the shared free list.
+// Must be called with the lock held.
+void AddSlab(SlabAllocator* slab) {
+  auto* data = (uint8_t*)ReserveVirtualMemory(slab->slab_size);
+  if (!data || !CommitVirtualMemory(data, slab->slab_size)) {
+    LOG(ERROR) << "Could not allocate a slab for "
+               << (slab->name ? slab->name : "<unnamed>");
+    abort();
+  }
+  slab->slabs.push_back(data);
+
+  // Chained in address order, so allocations walk the slab forward.
+  for (uint32_t i = 0; i < slab->objects_per_slab; i++) {
+    auto* node = (SlabAllocator::FreeNode*)(data + i * slab->object_size);
+    node->next = i + 1 < slab->objects_per_slab
+        ? (SlabAllocator::FreeNode*)(data + (i + 1) * slab->object_size)
+        : slab->free_list;
+  }
+  slab->free_list = (SlabAllocator::FreeNode*)data;
+}
+
+// Must be called with the lock held.
+SlabAllocator::FreeNode* PopShared(SlabAllocator* slab) {
+  if (!slab->free_list)
+    AddSlab(slab);
+
+  SlabAllocator::FreeNode* node = slab->free_list;
+  slab->free_list = node->next;
+  return node;
+}
+
+void Refill(SlabAllocator* slab, SlabAllocator::ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock(slab->mutex);
+  for (uint32_t i = 0; i < SlabAllocator::kCacheBatch; i++) {
+    SlabAllocator::FreeNode* node = PopShared(slab);
+    node->next = cache->head;
+    cache->head = node;
+  }
+  cache->count += SlabAllocator::kCacheBatch;
+}
+
+// Gives back half of the cache, so a thread that only frees (eg. a consumer)
+// does not hoard memory.
+void Drain(SlabAllocator* slab, SlabAllocator::ThreadCache* cache) {
+  SlabAllocator::FreeNode* first = cache->head;
+  SlabAllocator::FreeNode* last = first;
+  for (uint32_t i = 1; i < SlabAllocator::kCacheBatch; i++)
+    last = last->next;
+
+  cache->head = last->next;
+  cache->count -= SlabAllocator::kCacheBatch;
+
+  std::lock_guard<std::mutex> lock(slab->mutex);
+  last->next = slab->free_list;
+  slab->free_list = first;
+}
+
+// Moves the whole cache (and its live count) to the shared state. The cache's
+// thread is exiting, so nobody else touches it.
+void FlushThreadCache(SlabAllocator* slab, uint32_t index) {
+  SlabAllocator::ThreadCache* cache = slab->caches.get() + index;
+  std::lock_guard<std::mutex> lock(slab->mutex);
+  while (cache->head) {
+    SlabAllocator::FreeNode* node = cache->head;
+    cache->head = node->next;
+    node->next = slab->free_list;
+    slab->free_list = node;
+  }
+  cache->count = 0;
+
+  slab->shared_live += cache->live.exchange(0, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+SlabAllocator::~SlabAllocator() {
+  if (Valid(this))
+    ShutdownSlabAllocator(this);
+}
+
+void InitSlabAllocator(SlabAllocator* slab, const SlabAllocatorConfig& config) {
+  ASSERT(!Valid(slab));
+  ASSERT(config.object_size > 0);
+  ASSERT(config.object_alignment > 0 &&
+         (config.object_alignment & (config.object_alignment - 1)) == 0)
+      << "Alignment must be a power of two: " << config.object_alignment;
+
+  size_t page_size = GetPageSize();
+  ASSERT(config.object_alignment <= page_size);
+
+  // Free objects hold the free list pointer.
+  size_t alignment = config.object_alignment;
+  if (alignment < alignof(SlabAllocator::FreeNode))
+    alignment = alignof(SlabAllocator::FreeNode);
+  size_t object_size = config.object_size;
+  if (object_size < sizeof(SlabAllocator::FreeNode))
+    object_size = sizeof(SlabAllocator::FreeNode);
+  object_size = Align(object_size, alignment);
+
+  uint32_t min_objects = config.min_objects_per_slab;
+  if (min_objects == 0)
+    min_objects = 1;
+
+  slab->name = config.name;
+  slab->object_size = object_size;
+  slab->object_alignment = alignment;
+  slab->slab_size = Align(object_size * min_objects, page_size);
+  slab->objects_per_slab = (uint32_t)(slab->slab_size / object_size);
+
+  if (config.thread_caches) {
+    slab->caches =
+        std::make_unique<SlabAllocator::ThreadCache[]>(
+            SlabAllocator::kMaxThreadCaches);
+    RegisterThreadCaches(slab);
+  }
+
+  Track(slab);
+}
+
+void ShutdownSlabAllocator(SlabAllocator* slab) {
+  ASSERT(Valid(slab));
+
+  if (Valid(&slab->track_token))
+    Untrack(&slab->track_token);
+  if (slab->caches)
+    UnregisterThreadCaches(slab);
+
+  for (uint8_t* data : slab->slabs)
+    ReleaseVirtualMemory(data, slab->slab_size);
+  slab->slabs.clear();
+  slab->free_list = nullptr;
+  slab->shared_live = 0;
+  slab->caches.reset();
+  slab->object_size = 0;
+}
+
+void* Allocate(SlabAllocator* slab) {
+  ASSERT(Valid(slab));
+
+  SlabAllocator::ThreadCache* cache = GetThreadCache(slab);
+  if (!cache) {
+    std::lock_guard<std::mutex> lock(slab->mutex);
+    slab->shared_live++;
+    return PopShared(slab);
+  }
+
+  if (!cache->head)
+    Refill(slab, cache);
+
+  SlabAllocator::FreeNode* node = cache->head;
+  cache->head = node->next;
+  cache->count--;
+  cache->live.store(cache->live.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+  return node;
+}
+
+void Free(SlabAllocator* slab, void* ptr) {
+  ASSERT(Valid(slab));
+  if (!ptr)
+    return;
+
+  auto* node = (SlabAllocator::FreeNode*)ptr;
+  SlabAllocator::ThreadCache* cache = GetThreadCache(slab);
+  if (!cache) {
+    std::lock_guard<std::mutex> lock(slab->mutex);
+    node->next = slab->free_list;
+    slab->free_list = node;
+    slab->shared_live--;
+    return;
+  }
+
+  node->next = cache->head;
+  cache->head = node;
+  cache->count++;
+  cache->live.store(cache->live.load(std::memory_order_relaxed) - 1,
+                    std::memory_order_relaxed);
+
+  if (cache->count >= 2 * SlabAllocator::kCacheBatch)
+    Drain(slab, cache);
+}
+
+// Stats -----------------------------------------------------------------------
+
+size_t GetLiveCount(SlabAllocator* slab) {
+  int64_t live = 0;
+  {
+    std::lock_guard<std::mutex> lock(slab->mutex);
+    live = slab->shared_live;
+  }
+
+  // An object can be allocated in one thread and freed in another, so only
+  // the sum means something.
+  if (slab->caches) {
+    for (uint32_t i = 0; i < SlabAllocator::kMaxThreadCaches; i++)
+      live += slab->caches[i].live.load(std::memory_order_relaxed);
+  }
+
+  return live > 0 ? (size_t)live : 0;
+}
+
+size_t GetCapacity(SlabAllocator* slab) {
+  std::lock_guard<std::mutex> lock(slab->mutex);
+  return slab->slabs.size() * slab->objects_per_slab;
+}
+
+size_t GetReservedBytes(SlabAllocator* slab) {
+  std::lock_guard<std::mutex> lock(slab->mutex);
+  return slab->slabs.size() * slab->slab_size;
+}
+
+}  // namespace warhol
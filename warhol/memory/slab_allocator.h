@@ -0,0 +1,133 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "warhol/memory/memory_tracker.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// SlabAllocator ---------------------------------------------------------------
+//
+// Allocates objects of a single size out of page sized slabs. Free objects are
+// chained through their own memory (intrusive free list), so both Allocate
+// and Free are O(1) and objects of the same type end up packed together.
+//
+// Slabs are never given back until the allocator is reset or shut down, so
+// there is no fragmentation: any freed slot can be reused by the next object.
+//
+// With |thread_caches| on, every thread keeps a small private free list and
+// only goes to the shared one (which takes a lock) to move |kCacheBatch|
+// objects at a time. At most kMaxThreadCaches threads have a cache at the same
+// time; others use the shared list. When a thread exits its caches are flushed
+// back to the shared lists and its cache slot goes to the next thread.
+//
+// Use the typed helpers at the bottom:
+//
+//   SlabAllocator chunks;
+//   InitSlabAllocator<VoxelChunk>(&chunks, "Chunks");
+//   VoxelChunk* chunk = SlabNew<VoxelChunk>(&chunks, ...);
+//   SlabDelete(&chunks, chunk);
+
+struct SlabAllocator {
+  static constexpr uint32_t kMaxThreadCaches = 64;
+  static constexpr uint32_t kCacheBatch = 32;
+
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  // Only touched by its own thread (besides |live|, which is read for stats).
+  struct alignas(64) ThreadCache {
+    FreeNode* head = nullptr;
+    uint32_t count = 0;
+    std::atomic<int64_t> live = 0;
+  };
+
+  SlabAllocator() = default;
+  ~SlabAllocator();
+  DELETE_COPY_AND_ASSIGN(SlabAllocator);
+  DELETE_MOVE_AND_ASSIGN(SlabAllocator);
+
+  const char* name = nullptr;
+  size_t object_size = 0;         // Already a multiple of |object_alignment|.
+  size_t object_alignment = 0;
+  size_t slab_size = 0;           // Multiple of the page size.
+  uint32_t objects_per_slab = 0;
+
+  // Shared state, protected by |mutex|.
+  std::mutex mutex;
+  FreeNode* free_list = nullptr;
+  std::vector<uint8_t*> slabs;
+  int64_t shared_live = 0;
+
+  std::unique_ptr<ThreadCache[]> caches;    // Null if no thread caches.
+
+  TrackToken track_token;
+};
+
+struct SlabAllocatorConfig {
+  const char* name = nullptr;
+  size_t object_size = 0;
+  size_t object_alignment = alignof(void*);
+
+  // Slabs get at least this many objects (rounded up to a whole page).
+  uint32_t min_objects_per_slab = 64;
+  bool thread_caches = false;
+};
+
+inline bool Valid(SlabAllocator* slab) { return slab->object_size > 0; }
+
+void InitSlabAllocator(SlabAllocator*, const SlabAllocatorConfig&);
+
+// Frees every slab. Everything allocated from it is gone.
+// RAII semantics will take care of this.
+void ShutdownSlabAllocator(SlabAllocator*);
+
+// Uninitialized memory for one object. Never returns null (aborts on OOM).
+void* Allocate(SlabAllocator*);
+void Free(SlabAllocator*, void* ptr);
+
+// Stats. Approximate if other threads are allocating at the same time.
+size_t GetLiveCount(SlabAllocator*);
+size_t GetCapacity(SlabAllocator*);
+size_t GetReservedBytes(SlabAllocator*);
+
+// Typed helpers ---------------------------------------------------------------
+
+template <typename T>
+void InitSlabAllocator(SlabAllocator* slab, const char* name,
+                       bool thread_caches = false) {
+  SlabAllocatorConfig config;
+  config.name = name;
+  config.object_size = sizeof(T);
+  config.object_alignment = alignof(T);
+  config.thread_caches = thread_caches;
+  InitSlabAllocator(slab, config);
+}
+
+template <typename T, typename... Args>
+T* SlabNew(SlabAllocator* slab, Args&&... args) {
+  return new (Allocate(slab)) T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void SlabDelete(SlabAllocator* slab, T* t) {
+  if (!t)
+    return;
+  t->~T();
+  Free(slab, t);
+}
+
+}  // namespace warhol
@@ -0,0 +1,388 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/memory/tlsf_allocator.h"
+
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "warhol/utils/align.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+using Block = TLSFAllocator::Block;
+
+constexpr size_t kHeaderSize = offsetof(Block, next_free);
+constexpr size_t kMinBlockSize = sizeof(Block) - kHeaderSize;
+
+constexpr size_t kFreeBit = 1 << 0;
+constexpr size_t kPrevFreeBit = 1 << 1;
+constexpr size_t kFlagMask = kFreeBit | kPrevFreeBit;
+
+static_assert(kHeaderSize == TLSFAllocator::kAlignment,
+              "Headers must keep the payloads aligned.");
+
+// Bit scanning ----------------------------------------------------------------
+
+uint32_t LowestBit(uint32_t mask) {
+  ASSERT(mask != 0);
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (uint32_t)index;
+#else
+  return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+uint32_t FloorLog2(size_t x) {
+  ASSERT(x != 0);
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, (uint64_t)x);
+  return (uint32_t)index;
+#else
+  return 63 - (uint32_t)__builtin_clzll((uint64_t)x);
+#endif
+}
+
+// Blocks ----------------------------------------------------------------------
+
+size_t BlockSize(Block* block) { return block->size & ~kFlagMask; }
+bool IsFree(Block* block) { return block->size & kFreeBit; }
+bool IsPrevFree(Block* block) { return block->size & kPrevFreeBit; }
+
+void SetSize(Block* block, size_t size) {
+  block->size = size | (block->size & kFlagMask);
+}
+
+uint8_t* Payload(Block* block) { return (uint8_t*)block + kHeaderSize; }
+Block* FromPayload(void* ptr) { return (Block*)((uint8_t*)ptr - kHeaderSize); }
+
+Block* NextPhysical(Block* block) {
+  return (Block*)(Payload(block) + BlockSize(block));
+}
+
+Block* LinkNext(Block* block) {
+  Block* next = NextPhysical(block);
+  next->prev_physical = block;
+  return next;
+}
+
+void MarkFree(Block* block) {
+  block->size |= kFreeBit;
+  LinkNext(block)->size |= kPrevFreeBit;
+}
+
+void MarkUsed(Block* block) {
+  block->size &= ~kFreeBit;
+  NextPhysical(block)->size &= ~kPrevFreeBit;
+}
+
+// Size classes ----------------------------------------------------------------
+
+void Mapping(size_t size, uint32_t* fl, uint32_t* sl) {
+  if (size < TLSFAllocator::kSmallBlockSize) {
+    *fl = 0;
+    *sl = (uint32_t)(size / (TLSFAllocator::kSmallBlockSize /
+                             TLSFAllocator::kSLCount));
+    return;
+  }
+
+  uint32_t log = FloorLog2(size);
+  *sl = (uint32_t)(size >> (log - TLSFAllocator::kSLBits)) ^
+        TLSFAllocator::kSLCount;
+  *fl = log - (TLSFAllocator::kFLShift - 1);
+}
+
+// Rounds up to the next size class, so that any block in it is big enough.
+void MappingSearch(size_t size, uint32_t* fl, uint32_t* sl) {
+  if (size >= TLSFAllocator::kSmallBlockSize)
+    size += ((size_t)1 << (FloorLog2(size) - TLSFAllocator::kSLBits)) - 1;
+  Mapping(size, fl, sl);
+}
+
+Block* FindSuitable(TLSFAllocator* tlsf, uint32_t* fl, uint32_t* sl) {
+  uint32_t sl_map = tlsf->sl_bitmaps[*fl] & (~0u << *sl);
+  if (!sl_map) {
+    // Nothing in this level. Go for the next one with anything in it.
+    uint32_t fl_map =
+        *fl + 1 < 32 ? tlsf->fl_bitmap & (~0u << (*fl + 1)) : 0;
+    if (!fl_map)
+      return nullptr;
+
+    *fl = LowestBit(fl_map);
+    sl_map = tlsf->sl_bitmaps[*fl];
+  }
+
+  *sl = LowestBit(sl_map);
+  return tlsf->free_lists[*fl][*sl];
+}
+
+// Free lists ------------------------------------------------------------------
+
+void Insert(TLSFAllocator* tlsf, Block* block) {
+  uint32_t fl, sl;
+  Mapping(BlockSize(block), &fl, &sl);
+
+  Block* head = tlsf->free_lists[fl][sl];
+  block->next_free = head;
+  block->prev_free = nullptr;
+  if (head)
+    head->prev_free = block;
+  tlsf->free_lists[fl][sl] = block;
+
+  tlsf->fl_bitmap |= 1u << fl;
+  tlsf->sl_bitmaps[fl] |= 1u << sl;
+}
+
+void Remove(TLSFAllocator* tlsf, Block* block) {
+  uint32_t fl, sl;
+  Mapping(BlockSize(block), &fl, &sl);
+
+  if (block->prev_free)
+    block->prev_free->next_free = block->next_free;
+  if (block->next_free)
+    block->next_free->prev_free = block->prev_free;
+
+  if (tlsf->free_lists[fl][sl] != block)
+    return;
+
+  tlsf->free_lists[fl][sl] = block->next_free;
+  if (!block->next_free) {
+    tlsf->sl_bitmaps[fl] &= ~(1u << sl);
+    if (!tlsf->sl_bitmaps[fl])
+      tlsf->fl_bitmap &= ~(1u << fl);
+  }
+}
+
+// Leaves |size| bytes in |block| and gives back the rest, if worth it.
+void Split(TLSFAllocator* tlsf, Block* block, size_t size) {
+  if (BlockSize(block) < size + kHeaderSize + kMinBlockSize)
+    return;
+
+  auto* rest = (Block*)(Payload(block) + size);
+  rest->size = BlockSize(block) - size - kHeaderSize;
+  SetSize(block, size);
+
+  MarkFree(rest);
+  Insert(tlsf, rest);
+}
+
+// Gives back the start of |block| so that its payload ends up at |aligned|.
+Block* TrimFront(TLSFAllocator* tlsf, Block* block, uint8_t* aligned) {
+  size_t gap = aligned - Payload(block);
+  if (gap == 0)
+    return block;
+  ASSERT(gap >= kHeaderSize + kMinBlockSize);
+
+  auto* aligned_block = (Block*)(aligned - kHeaderSize);
+  aligned_block->size = (BlockSize(block) - gap) | kPrevFreeBit;
+  aligned_block->prev_physical = block;
+  LinkNext(aligned_block);
+
+  // |block| keeps its flags: it is still free and its previous is not.
+  SetSize(block, gap - kHeaderSize);
+  Insert(tlsf, block);
+  return aligned_block;
+}
+
+}  // namespace
+
+bool InitTLSFAllocator(TLSFAllocator* tlsf, MemoryPool* pool, size_t size) {
+  ASSERT(!Valid(tlsf));
+  size = size & ~(TLSFAllocator::kAlignment - 1);
+
+  // One block plus the sentinel at the end.
+  if (size < 2 * kHeaderSize + kMinBlockSize) {
+    LOG(ERROR) << "TLSF region too small: " << size;
+    return false;
+  }
+
+  if (size >= ((size_t)1 << TLSFAllocator::kFLMax)) {
+    LOG(ERROR) << "TLSF region too big: " << BytesToString(size);
+    return false;
+  }
+
+  tlsf->data = Reserve(pool, size, TLSFAllocator::kAlignment);
+  tlsf->size = size;
+
+  auto* block = (Block*)tlsf->data;
+  block->prev_physical = nullptr;
+  block->size = size - 2 * kHeaderSize;
+
+  // The sentinel is a zero sized used block, so the last real block never
+  // tries to merge with whatever is after the region.
+  Block* sentinel = NextPhysical(block);
+  sentinel->size = 0;
+
+  MarkFree(block);
+  Insert(tlsf, block);
+  return true;
+}
+
+void ShutdownTLSFAllocator(TLSFAllocator* tlsf) {
+  ASSERT(Valid(tlsf));
+  tlsf->data = nullptr;
+  tlsf->size = 0;
+  tlsf->fl_bitmap = 0;
+  for (uint32_t fl = 0; fl < TLSFAllocator::kFLCount; fl++) {
+    tlsf->sl_bitmaps[fl] = 0;
+    for (uint32_t sl = 0; sl < TLSFAllocator::kSLCount; sl++)
+      tlsf->free_lists[fl][sl] = nullptr;
+  }
+  tlsf->used = 0;
+  tlsf->peak_used = 0;
+  tlsf->allocation_count = 0;
+}
+
+void* Allocate(TLSFAllocator* tlsf, size_t size, size_t alignment) {
+  ASSERT(Valid(tlsf));
+  ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0)
+      << "Alignment must be a power of two: " << alignment;
+
+  if (size >= tlsf->size)
+    return nullptr;
+
+  size = Align(size < kMinBlockSize ? kMinBlockSize : size,
+               TLSFAllocator::kAlignment);
+
+  // Bigger alignments need room to give back the front of the block.
+  size_t request = size;
+  if (alignment > TLSFAllocator::kAlignment)
+    request += alignment + kHeaderSize + kMinBlockSize;
+
+  uint32_t fl, sl;
+  MappingSearch(request, &fl, &sl);
+  if (fl >= TLSFAllocator::kFLCount)
+    return nullptr;
+
+  Block* block = FindSuitable(tlsf, &fl, &sl);
+  if (!block)
+    return nullptr;
+  Remove(tlsf, block);
+
+  if (alignment > TLSFAllocator::kAlignment) {
+    uint8_t* payload = Payload(block);
+    auto* aligned = (uint8_t*)Align((uint64_t)payload, alignment);
+    size_t gap = aligned - payload;
+    if (gap > 0 && gap < kHeaderSize + kMinBlockSize) {
+      aligned = (uint8_t*)Align(
+          (uint64_t)(payload + kHeaderSize + kMinBlockSize), alignment);
+    }
+    block = TrimFront(tlsf, block, aligned);
+  }
+
+  Split(tlsf, block, size);
+  MarkUsed(block);
+
+  tlsf->used += BlockSize(block);
+  if (tlsf->used > tlsf->peak_used)
+    tlsf->peak_used = tlsf->used;
+  tlsf->allocation_count++;
+  return Payload(block);
+}
+
+void Free(TLSFAllocator* tlsf, void* ptr) {
+  ASSERT(Valid(tlsf));
+  if (!ptr)
+    return;
+
+  Block* block = FromPayload(ptr);
+  ASSERT(!IsFree(block)) << "Double free.";
+  tlsf->used -= BlockSize(block);
+  tlsf->allocation_count--;
+
+  MarkFree(block);
+
+  if (IsPrevFree(block)) {
+    Block* prev = block->prev_physical;
+    Remove(tlsf, prev);
+    SetSize(prev, BlockSize(prev) + kHeaderSize + BlockSize(block));
+    block = prev;
+    LinkNext(block);
+  }
+
+  Block* next = NextPhysical(block);
+  if (IsFree(next)) {
+    Remove(tlsf, next);
+    SetSize(block, BlockSize(block) + kHeaderSize + BlockSize(next));
+    LinkNext(block);
+  }
+
+  Insert(tlsf, block);
+}
+
+size_t GetAllocationSize(void* ptr) {
+  return BlockSize(FromPayload(ptr));
+}
+
+bool CheckIntegrity(TLSFAllocator* tlsf) {
+  ASSERT(Valid(tlsf));
+
+  // Physical blocks.
+  size_t free_count = 0;
+  size_t used = 0;
+  bool prev_free = false;
+  auto* block = (Block*)tlsf->data;
+  uint8_t* end = tlsf->data + tlsf->size - kHeaderSize;
+  while ((uint8_t*)block < end) {
+    if (IsPrevFree(block) != prev_free)
+      return false;
+    if (prev_free && IsFree(block))
+      return false;   // Should have been merged.
+    if (BlockSize(block) % TLSFAllocator::kAlignment != 0)
+      return false;
+
+    Block* next = NextPhysical(block);
+    if (IsFree(block)) {
+      free_count++;
+      if (next->prev_physical != block)
+        return false;
+    } else {
+      used += BlockSize(block);
+    }
+
+    prev_free = IsFree(block);
+    block = next;
+  }
+
+  // Should have landed right in the sentinel.
+  if ((uint8_t*)block != end || BlockSize(block) != 0 || IsFree(block))
+    return false;
+  if (used != tlsf->used)
+    return false;
+
+  // Free lists.
+  size_t listed = 0;
+  for (uint32_t fl = 0; fl < TLSFAllocator::kFLCount; fl++) {
+    bool fl_set = tlsf->fl_bitmap & (1u << fl);
+    if (fl_set != (tlsf->sl_bitmaps[fl] != 0))
+      return false;
+
+    for (uint32_t sl = 0; sl < TLSFAllocator::kSLCount; sl++) {
+      Block* head = tlsf->free_lists[fl][sl];
+      bool sl_set = tlsf->sl_bitmaps[fl] & (1u << sl);
+      if (sl_set != (head != nullptr))
+        return false;
+
+      for (Block* it = head; it; it = it->next_free) {
+        uint32_t block_fl, block_sl;
+        Mapping(BlockSize(it), &block_fl, &block_sl);
+        if (!IsFree(it) || block_fl != fl || block_sl != sl)
+          return false;
+        listed++;
+      }
+    }
+  }
+
+  return listed == free_count;
+}
+
+}  // namespace warhol
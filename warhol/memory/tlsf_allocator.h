@@ -0,0 +1,88 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "warhol/memory/memory_pool.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// TLSFAllocator ---------------------------------------------------------------
+//
+// General purpose allocator (variable sizes, individual frees) over a region
+// taken from a MemoryPool. Two-Level Segregated Fit: free blocks are kept in
+// size classes indexed by their power of two (first level) and a linear
+// subdivision of it (second level). A couple of bitmap scans find a block big
+// enough, so Allocate and Free are O(1) and their time is bounded regardless
+// of how fragmented the region is.
+//
+// Every block has a 16 byte header and payloads are 16 byte aligned. Freed
+// blocks are merged with their free neighbours right away.
+//
+// Not thread safe. Does not own its memory: the pool has to outlive it.
+
+struct TLSFAllocator {
+  static constexpr uint32_t kAlignShift = 4;
+  static constexpr size_t kAlignment = 1 << kAlignShift;
+
+  // Every power of two is divided in kSLCount size classes.
+  static constexpr uint32_t kSLBits = 5;
+  static constexpr uint32_t kSLCount = 1 << kSLBits;
+
+  // Blocks smaller than kSmallBlockSize all go to the first level 0, linearly.
+  static constexpr uint32_t kFLShift = kSLBits + kAlignShift;
+  static constexpr size_t kSmallBlockSize = 1 << kFLShift;
+  static constexpr uint32_t kFLMax = 40;    // Regions of up to 1 TB.
+  static constexpr uint32_t kFLCount = kFLMax - kFLShift + 1;
+
+  struct Block {
+    Block* prev_physical;   // Only valid if the previous block is free.
+    size_t size;            // Of the payload. The low bits hold the flags.
+
+    // Only valid if the block is free. They live in the payload.
+    Block* next_free;
+    Block* prev_free;
+  };
+
+  TLSFAllocator() = default;
+  DELETE_COPY_AND_ASSIGN(TLSFAllocator);
+  DELETE_MOVE_AND_ASSIGN(TLSFAllocator);
+
+  uint8_t* data = nullptr;
+  size_t size = 0;
+
+  uint32_t fl_bitmap = 0;
+  uint32_t sl_bitmaps[kFLCount] = {};
+  Block* free_lists[kFLCount][kSLCount] = {};
+
+  // Stats (payload bytes, not counting headers).
+  size_t used = 0;
+  size_t peak_used = 0;
+  uint32_t allocation_count = 0;
+};
+
+inline bool Valid(TLSFAllocator* tlsf) { return !!tlsf->data; }
+
+// Takes |size| bytes out of |pool|.
+bool InitTLSFAllocator(TLSFAllocator*, MemoryPool* pool, size_t size);
+
+// Forgets about every allocation. The region stays in the pool.
+void ShutdownTLSFAllocator(TLSFAllocator*);
+
+// |alignment| must be a power of two. Returns null if there is no free block
+// big enough.
+void* Allocate(TLSFAllocator*, size_t size,
+               size_t alignment = TLSFAllocator::kAlignment);
+void Free(TLSFAllocator*, void* ptr);
+
+// Usable size of an allocation. Can be bigger than what was asked.
+size_t GetAllocationSize(void* ptr);
+
+// Walks every block checking the allocator invariants. Slow, for debugging.
+bool CheckIntegrity(TLSFAllocator*);
+
+}  // namespace warhol
@@ -0,0 +1,525 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/multithreading/job_system.h"
+
+#include "warhol/platform/platform.h"
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+// Which system (and which queue within it) the current thread belongs to.
+thread_local JobSystem* tJobSystem = nullptr;
+thread_local int tWorkerIndex = -1;
+
+// Priority of the job this thread is running (if any).
+thread_local JobPriority tCurrentPriority = JobPriority::kNormal;
+// How many background jobs this thread is running (they can nest when waiting).
+thread_local uint32_t tBackgroundDepth = 0;
+
+// How many times an idle worker will look for work before going to sleep.
+constexpr int kIdleSpinCount = 64;
+
+uint32_t QueueCount(JobSystem* js) { return js->worker_count + 1; }
+
+void RunJob(JobSystem*, const Job&);
+
+uint32_t NextRandom(uint32_t* state) {
+  // Xorshift32.
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// Finding Work ----------------------------------------------------------------
+
+uint32_t Lane(JobPriority priority) {
+  ASSERT(priority < JobPriority::kLast);
+  return (uint32_t)priority;
+}
+
+bool StealJob(JobSystem* js, int thief_index, uint32_t lane, Job* out) {
+  uint32_t queue_count = QueueCount(js);
+  uint32_t random_state = thief_index >= 0 ?
+                          NextRandom(&js->queues[thief_index].random_state) :
+                          (uint32_t)std::hash<std::thread::id>()(
+                              std::this_thread::get_id());
+
+  // Start from a random victim and go around once.
+  uint32_t start = random_state % queue_count;
+  for (uint32_t i = 0; i < queue_count; i++) {
+    uint32_t victim = (start + i) % queue_count;
+    if ((int)victim == thief_index)
+      continue;
+
+    if (Steal(&js->queues[victim].deques[lane], out))
+      return true;
+  }
+
+  return false;
+}
+
+bool FindJobInLane(JobSystem* js, int worker_index, uint32_t lane, Job* out) {
+  if (worker_index >= 0 && Pop(&js->queues[worker_index].deques[lane], out))
+    return true;
+
+  if (TryPop(&js->injection_queues[lane], out))
+    return true;
+
+  return StealJob(js, worker_index, lane, out);
+}
+
+// Whether the thread could run a background job, not counting the deadline.
+bool BackgroundAllowed(JobSystem* js, int worker_index) {
+  // Already running one, so it's not taking a new core.
+  if (tBackgroundDepth > 0)
+    return true;
+  // Shutting down: everything has to go.
+  if (!js->running.load(std::memory_order_acquire))
+    return true;
+  // Worker 0 and outside threads are normally the ones with frame work.
+  if (worker_index <= 0 && js->worker_count > 0)
+    return false;
+
+  return js->background_workers.load(std::memory_order_relaxed) <
+         js->max_background_workers;
+}
+
+bool NearFrameDeadline(JobSystem* js) {
+  uint64_t deadline = js->frame_deadline.load(std::memory_order_relaxed);
+  if (deadline == 0)
+    return false;
+
+  uint64_t now = GetNanoseconds();
+  return now < deadline &&
+         now + JobSystem::kBackgroundDeadlineMarginNs >= deadline;
+}
+
+// Reserves one of the background slots. Threads already running a background
+// job do not need one.
+bool ReserveBackground(JobSystem* js, int worker_index) {
+  if (!BackgroundAllowed(js, worker_index))
+    return false;
+  if (tBackgroundDepth > 0 || !js->running.load(std::memory_order_acquire))
+    return true;
+  if (NearFrameDeadline(js))
+    return false;
+
+  uint32_t running = js->background_workers.load(std::memory_order_relaxed);
+  while (running < js->max_background_workers) {
+    if (js->background_workers.compare_exchange_weak(running, running + 1))
+      return true;
+  }
+  return false;
+}
+
+void ReleaseBackground(JobSystem* js) {
+  if (tBackgroundDepth > 0 || !js->running.load(std::memory_order_acquire))
+    return;
+  js->background_workers.fetch_sub(1);
+}
+
+// Goes through the lanes from the highest priority down.
+// A background job returned by this is already holding a background slot.
+bool FindJob(JobSystem* js, int worker_index, Job* out) {
+  for (uint32_t lane = 0; lane < kJobPriorityCount; lane++) {
+    if (lane != Lane(JobPriority::kBackground)) {
+      if (FindJobInLane(js, worker_index, lane, out))
+        return true;
+      continue;
+    }
+
+    if (!ReserveBackground(js, worker_index))
+      continue;
+    if (FindJobInLane(js, worker_index, lane, out))
+      return true;
+    ReleaseBackground(js);
+  }
+
+  return false;
+}
+
+bool HasPendingJobs(JobSystem* js, int worker_index) {
+  for (uint32_t lane = 0; lane < kJobPriorityCount; lane++) {
+    // Background work we could not run anyway doesn't keep us awake.
+    if (lane == Lane(JobPriority::kBackground) &&
+        !BackgroundAllowed(js, worker_index)) {
+      continue;
+    }
+
+    if (!Empty(&js->injection_queues[lane]))
+      return true;
+
+    for (uint32_t i = 0; i < QueueCount(js); i++) {
+      if (!Empty(&js->queues[i].deques[lane]))
+        return true;
+    }
+  }
+
+  return false;
+}
+
+// Wake up to |count| sleeping workers, with a single notification.
+void WakeWorkers(JobSystem* js, uint32_t count) {
+  // Pairs with the fence in WorkerLoop: either we see the sleeping worker or
+  // the worker sees the job we just pushed.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint32_t sleeping = js->sleeping_workers.load(std::memory_order_relaxed);
+  if (sleeping > 0)
+    js->semaphore.Notify(sleeping < count ? sleeping : count);
+}
+
+// Puts the job into a queue. Does no accounting and only wakes workers if the
+// queues are full (so they help draining them).
+void InsertJob(JobSystem* js, const Job& job) {
+  uint32_t lane = Lane(job.priority);
+  int worker_index = GetCurrentWorkerIndex(js);
+  if (worker_index >= 0 && Push(&js->queues[worker_index].deques[lane], job))
+    return;
+
+  // Outside thread or our own queue is full: use the shared one.
+  while (!TryPush(&js->injection_queues[lane], job)) {
+    // Back-pressure: make room by doing some work.
+    WakeWorkers(js, js->worker_count);
+    if (!RunPendingJob(js))
+      std::this_thread::yield();
+  }
+}
+
+void EnqueueJob(JobSystem* js, const Job& job) {
+  InsertJob(js, job);
+  WakeWorkers(js, 1);
+}
+
+// Job Counters ----------------------------------------------------------------
+
+// Jobs that were waiting on a counter, copied out of it so they can be pushed
+// once the counter is released.
+struct CounterDependents {
+  JobSystem* js = nullptr;
+  Job jobs[JobCounter::kMaxDependents];
+  uint32_t count = 0;
+};
+
+// Called by the thread that took the counter to zero. Takes the dependents out
+// and wakes the waiters, but does not push the dependents: a dependent can be
+// the one destroying the counter (eg. a Task resumed after it), so they have to
+// wait until the counter is released (see DecrementCounter).
+void FinishCounter(JobCounter* counter, CounterDependents* out) {
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex);
+    out->js = counter->dependents_system;
+    out->count = counter->dependent_count;
+    for (uint32_t i = 0; i < out->count; i++)
+      out->jobs[i] = counter->dependents[i];
+    counter->dependent_count = 0;
+  }
+
+  // Pairs with WaitForCounter: either we see the waiter or the waiter sees the
+  // counter at zero. Each waiter gets its own notification.
+  uint32_t waiters = counter->waiters.load();
+  counter->semaphore.Notify(waiters);
+}
+
+void PushDependents(const CounterDependents& dependents) {
+  for (uint32_t i = 0; i < dependents.count; i++)
+    InsertJob(dependents.js, dependents.jobs[i]);
+  if (dependents.count > 0)
+    WakeWorkers(dependents.js, dependents.count);
+}
+
+// Background jobs must come with a reserved slot (see FindJob).
+void RunJob(JobSystem* js, const Job& job) {
+  ASSERT(Valid(job));
+
+  bool background = job.priority == JobPriority::kBackground;
+  JobPriority previous_priority = tCurrentPriority;
+  tCurrentPriority = job.priority;
+  if (background)
+    tBackgroundDepth++;
+
+  job.func(job.user_data);
+
+  if (background) {
+    tBackgroundDepth--;
+    ReleaseBackground(js);
+  }
+  tCurrentPriority = previous_priority;
+
+  js->completed_jobs.fetch_add(1, std::memory_order_acq_rel);
+  if (job.counter)
+    DecrementCounter(job.counter);
+
+  // A background slot was freed, so a sleeping worker might be able to run
+  // the next one.
+  if (background && tBackgroundDepth == 0)
+    WakeWorkers(js, 1);
+}
+
+// Worker Threads --------------------------------------------------------------
+
+void WorkerLoop(void* user_data, uint32_t pool_index) {
+  auto* js = (JobSystem*)user_data;
+  int worker_index = (int)pool_index + 1;   // 0 is the initializing thread.
+  tJobSystem = js;
+  tWorkerIndex = worker_index;
+
+  int idle_count = 0;
+  while (js->running.load(std::memory_order_acquire)) {
+    Job job;
+    if (FindJob(js, worker_index, &job)) {
+      RunJob(js, job);
+      idle_count = 0;
+      continue;
+    }
+
+    if (idle_count++ < kIdleSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Go to sleep. We need to re-check for work *after* announcing that we're
+    // sleeping, otherwise a push could miss us.
+    js->sleeping_workers.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (HasPendingJobs(js, worker_index) ||
+        !js->running.load(std::memory_order_acquire)) {
+      js->sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+      idle_count = 0;
+      continue;
+    }
+
+    js->semaphore.Wait();
+    js->sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+    idle_count = 0;
+  }
+
+  tJobSystem = nullptr;
+  tWorkerIndex = -1;
+}
+
+}  // namespace
+
+// Init / Shutdown -------------------------------------------------------------
+
+JobCounter::~JobCounter() {
+  ASSERT(Done(this)) << "Destroying a counter with pending jobs.";
+}
+
+JobSystem::~JobSystem() {
+  if (Valid(this))
+    ShutdownJobSystem(this);
+}
+
+bool InitJobSystem(JobSystem* js, uint32_t worker_count) {
+  WorkerPoolConfig config;
+  config.worker_count = worker_count;
+  return InitJobSystem(js, config);
+}
+
+bool InitJobSystem(JobSystem* js, WorkerPoolConfig config) {
+  ASSERT(!Valid(js));
+  ASSERT(tJobSystem == nullptr) << "Thread is already part of a job system.";
+
+  // The queues have to exist before the workers start.
+  uint32_t worker_count = GetWorkerCount(GetCpuTopology(), config);
+  config.worker_count = worker_count;
+
+  js->worker_count = worker_count;
+  // Always leave one worker free for frame work.
+  js->max_background_workers = worker_count > 1 ? worker_count - 1 : 1;
+  js->background_workers = 0;
+  js->frame_deadline = 0;
+  js->queues = std::make_unique<JobSystem::WorkerQueue[]>(QueueCount(js));
+  for (uint32_t i = 0; i < QueueCount(js); i++) {
+    // Xorshift cannot have a zero state.
+    js->queues[i].random_state = 0x9e3779b9u * (i + 1);
+  }
+
+  // The initializing thread is worker 0.
+  tJobSystem = js;
+  tWorkerIndex = 0;
+
+  js->running = true;
+  if (!StartWorkerPool(&js->worker_pool, config, WorkerLoop, js)) {
+    LOG(ERROR) << "Could not start the worker pool.";
+    js->running = false;
+    tJobSystem = nullptr;
+    tWorkerIndex = -1;
+    js->queues.reset();
+    return false;
+  }
+
+  LOG(DEBUG) << "Started job system with " << worker_count << " workers.";
+  return true;
+}
+
+void ShutdownJobSystem(JobSystem* js) {
+  ASSERT(Valid(js));
+
+  js->running.store(false, std::memory_order_release);
+
+  // One notification per worker: the semaphore keeps the count, so workers that
+  // are about to sleep will also get it.
+  js->semaphore.Notify(js->worker_count);
+
+  JoinWorkerPool(&js->worker_pool);
+
+  // Whatever was left gets run by this thread.
+  Job job;
+  while (FindJob(js, GetCurrentWorkerIndex(js), &job))
+    RunJob(js, job);
+
+  if (tJobSystem == js) {
+    tJobSystem = nullptr;
+    tWorkerIndex = -1;
+  }
+
+  js->queues.reset();
+  js->worker_count = 0;
+}
+
+// Jobs ------------------------------------------------------------------------
+
+const char* ToString(JobPriority priority) {
+  switch (priority) {
+    case JobPriority::kFrameCritical: return "FrameCritical";
+    case JobPriority::kNormal: return "Normal";
+    case JobPriority::kBackground: return "Background";
+    case JobPriority::kLast: return "Last";
+  }
+
+  NOT_REACHED();
+  return nullptr;
+}
+
+int GetCurrentWorkerIndex(JobSystem* js) {
+  return tJobSystem == js ? tWorkerIndex : -1;
+}
+
+void PushJob(JobSystem* js, Job job, JobCounter* counter) {
+  ASSERT(Valid(js));
+  ASSERT(Valid(job));
+
+  job.counter = counter;
+  if (counter)
+    counter->count.fetch_add(1);
+  js->pushed_jobs.fetch_add(1, std::memory_order_acq_rel);
+
+  EnqueueJob(js, job);
+}
+
+void PushJobs(JobSystem* js, const Job* jobs, uint32_t count,
+              JobCounter* counter) {
+  ASSERT(Valid(js));
+  if (count == 0)
+    return;
+
+  if (counter)
+    counter->count.fetch_add(count);
+  js->pushed_jobs.fetch_add(count, std::memory_order_acq_rel);
+
+  for (uint32_t i = 0; i < count; i++) {
+    ASSERT(Valid(jobs[i]));
+    Job job = jobs[i];
+    job.counter = counter;
+    InsertJob(js, job);
+  }
+
+  WakeWorkers(js, count);
+}
+
+void PushJobAfter(JobSystem* js, JobCounter* dependency, Job job,
+                  JobCounter* counter) {
+  ASSERT(Valid(js));
+  ASSERT(Valid(job));
+
+  job.counter = counter;
+  if (counter)
+    counter->count.fetch_add(1);
+  js->pushed_jobs.fetch_add(1, std::memory_order_acq_rel);
+
+  {
+    // FinishCounter takes this same lock *after* the count reaches zero, so
+    // if we see a non-zero count here the job will be picked up by it.
+    std::lock_guard<std::mutex> lock(dependency->mutex);
+    if (dependency->count.load() > 0 &&
+        dependency->dependent_count < JobCounter::kMaxDependents) {
+      ASSERT(!dependency->dependents_system ||
+             dependency->dependents_system == js);
+      dependency->dependents_system = js;
+      dependency->dependents[dependency->dependent_count++] = job;
+      return;
+    }
+  }
+
+  // Either the dependency is done or it has no more space for dependents.
+  WaitForCounter(js, dependency);
+  EnqueueJob(js, job);
+}
+
+void DecrementCounter(JobCounter* counter) {
+  // |finishing| guards the counter from being considered done (and thus maybe
+  // destroyed) while we still touch it.
+  counter->finishing.fetch_add(1);
+  CounterDependents dependents;
+  if (counter->count.fetch_sub(1) == 1)
+    FinishCounter(counter, &dependents);
+  // Nothing can touch the counter after this.
+  counter->finishing.fetch_sub(1);
+
+  PushDependents(dependents);
+}
+
+void SetFrameDeadline(JobSystem* js, uint64_t deadline_ns) {
+  js->frame_deadline.store(deadline_ns, std::memory_order_relaxed);
+}
+
+JobPriority GetCurrentJobPriority() { return tCurrentPriority; }
+
+void WaitForCounter(JobSystem* js, JobCounter* counter) {
+  int idle_count = 0;
+  while (!Done(counter)) {
+    if (RunPendingJob(js)) {
+      idle_count = 0;
+      continue;
+    }
+
+    // The count being zero means someone is finishing the counter, which is
+    // quick, so we simply wait it out.
+    if (idle_count++ < kIdleSpinCount || counter->count.load() == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Nothing to do, so we sleep until the counter finishes. Pairs with
+    // FinishCounter.
+    counter->waiters.fetch_add(1);
+    if (counter->count.load() > 0)
+      counter->semaphore.Wait();
+    counter->waiters.fetch_sub(1);
+    idle_count = 0;
+  }
+}
+
+bool RunPendingJob(JobSystem* js) {
+  ASSERT(Valid(js));
+
+  Job job;
+  if (!FindJob(js, GetCurrentWorkerIndex(js), &job))
+    return false;
+
+  RunJob(js, job);
+  return true;
+}
+
+void RunPendingJobs(JobSystem* js) {
+  while (RunPendingJob(js)) {}
+}
+
+}  // namespace warhol
@@ -0,0 +1,227 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "warhol/multithreading/mpmc_queue.h"
+#include "warhol/multithreading/semaphore.h"
+#include "warhol/multithreading/work_stealing_deque.h"
+#include "warhol/multithreading/worker_pool.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+struct JobCounter;
+struct JobSystem;
+
+// Job -------------------------------------------------------------------------
+
+// Every priority has its own lane (set of queues). Workers always drain the
+// higher lanes first.
+enum class JobPriority : uint8_t {
+  kFrameCritical,   // Has to be done this frame.
+  kNormal,
+  // Streaming, decoding, etc. Only runs on idle workers and never on worker 0
+  // (normally the main thread). See SetFrameDeadline.
+  kBackground,
+  kLast,
+};
+const char* ToString(JobPriority);
+
+constexpr uint32_t kJobPriorityCount = (uint32_t)JobPriority::kLast;
+
+struct Job {
+  using JobFunc = void (*)(void*);
+
+  JobFunc func = nullptr;
+  void* user_data = nullptr;
+
+  // Set by PushJob. Will be decremented when the job is done.
+  JobCounter* counter = nullptr;
+
+  JobPriority priority = JobPriority::kNormal;
+};
+
+inline bool Valid(const Job& job) { return job.func != nullptr; }
+
+// JobCounter ------------------------------------------------------------------
+//
+// Tracks a batch of jobs: every job pushed with a counter increments it, and
+// decrements it when done. This permits waiting on only a particular set of
+// jobs (fork-join) and having jobs that depend on others (PushJobAfter).
+//
+// The counter must outlive all the jobs associated with it. Calling
+// WaitForCounter before destroying it is the simplest way to guarantee that.
+
+struct JobCounter {
+  // How many jobs can be waiting on a counter to reach zero. When full, the
+  // pushing thread will wait for the counter (running other jobs meanwhile).
+  static constexpr uint32_t kMaxDependents = 16;
+
+  JobCounter() = default;
+  ~JobCounter();
+  DELETE_COPY_AND_ASSIGN(JobCounter);
+  DELETE_MOVE_AND_ASSIGN(JobCounter);
+
+  std::atomic<uint32_t> count = 0;
+
+  // How many threads are currently finishing the counter (the last decrement).
+  // The counter cannot be considered done until this reaches zero, as those
+  // threads are still touching it.
+  std::atomic<uint32_t> finishing = 0;
+
+  // Threads sleeping on |semaphore|, waiting for the counter to reach zero.
+  std::atomic<uint32_t> waiters = 0;
+  Semaphore semaphore;
+
+  // Jobs that will be pushed once the counter reaches zero.
+  std::mutex mutex;
+  JobSystem* dependents_system = nullptr;
+  Job dependents[kMaxDependents];
+  uint32_t dependent_count = 0;
+};
+
+inline bool Done(JobCounter* counter) {
+  return counter->count.load(std::memory_order_acquire) == 0 &&
+         counter->finishing.load(std::memory_order_acquire) == 0;
+}
+
+// Manual accounting, for work that is not a single job (eg. a Task that
+// suspends in between). Every increment has to be matched by a decrement.
+inline void IncrementCounter(JobCounter* counter, uint32_t count = 1) {
+  counter->count.fetch_add(count);
+}
+
+// Pushes the dependent jobs and wakes the waiters if the counter reaches zero.
+void DecrementCounter(JobCounter*);
+
+// JobSystem -------------------------------------------------------------------
+//
+// Work stealing job system. Every thread that is part of the system has its
+// own deque of jobs:
+//
+// - Jobs pushed from a thread within the system go into its own deque.
+// - Jobs pushed from outside threads go into a lock-free injection queue.
+// - Idle threads steal from a random victim, and go to sleep after a while of
+//   not finding any work.
+//
+// The thread that calls InitJobSystem is registered as worker 0 (normally the
+// main thread). It has a deque, but it only runs jobs when explicitly asked to
+// (RunPendingJob(s)). The other |worker_count| threads are owned by the system
+// (through a WorkerPool).
+//
+// Queues are bounded. When a queue is full, the pushing thread will run pending
+// jobs until there is space, instead of overwriting unfinished work.
+//
+// Every queue is actually one per JobPriority. Background jobs are further
+// restricted so they cannot starve the frame:
+//
+// - At most |max_background_workers| threads run them at the same time, so
+//   there is always a worker free to pick up frame-critical work.
+// - Worker 0 never runs them (unless there are no other workers).
+// - No new background job is started when the frame deadline is close.
+
+struct JobSystem {
+  static constexpr uint32_t kDequeCapacity = 4096;
+  static constexpr uint32_t kInjectionCapacity = 4096;
+
+  // How close to the frame deadline background jobs stop being started.
+  static constexpr uint64_t kBackgroundDeadlineMarginNs = 2 * 1000 * 1000;
+
+  struct WorkerQueue {
+    WorkStealingDeque<Job, kDequeCapacity> deques[kJobPriorityCount];
+    uint32_t random_state = 0;    // For choosing victims.
+  };
+
+  JobSystem() = default;
+  ~JobSystem();
+  DELETE_COPY_AND_ASSIGN(JobSystem);
+  DELETE_MOVE_AND_ASSIGN(JobSystem);
+
+  uint32_t worker_count = 0;    // Owned threads (not counting worker 0).
+
+  // |worker_count| + 1 queues. Index 0 belongs to the initializing thread.
+  std::unique_ptr<WorkerQueue[]> queues;
+  WorkerPool worker_pool;
+
+  // Jobs pushed by threads that are not part of the system.
+  MPMCQueue<Job, kInjectionCapacity> injection_queues[kJobPriorityCount];
+
+  uint32_t max_background_workers = 0;
+  std::atomic<uint32_t> background_workers = 0;   // Running background jobs.
+
+  // GetNanoseconds timestamp. 0 means no deadline.
+  std::atomic<uint64_t> frame_deadline = 0;
+
+  Semaphore semaphore;
+  std::atomic<uint32_t> sleeping_workers = 0;
+  std::atomic<bool> running = false;
+
+  std::atomic<uint64_t> pushed_jobs = 0;
+  std::atomic<uint64_t> completed_jobs = 0;
+};
+
+inline bool Valid(JobSystem* js) { return !!js->queues; }
+
+// A |worker_count| of 0 means one per CPU, minus the calling thread's core.
+// Workers are pinned and named (see WorkerPool).
+bool InitJobSystem(JobSystem*, uint32_t worker_count = 0);
+bool InitJobSystem(JobSystem*, WorkerPoolConfig);
+
+// Will run all the pending jobs and join the worker threads.
+// RAII semantics will take care of this also.
+void ShutdownJobSystem(JobSystem*);
+
+// Thread safe.
+// If |counter| is given, it will be incremented now and decremented once the
+// job is done.
+void PushJob(JobSystem*, Job, JobCounter* counter = nullptr);
+
+// Pushes |count| jobs at once. Cheaper than calling PushJob for each, as the
+// sleeping workers are woken up with a single notification at the end.
+void PushJobs(JobSystem*, const Job* jobs, uint32_t count,
+              JobCounter* counter = nullptr);
+
+// Same as PushJob, but the job will only be started once |dependency| reaches
+// zero. |counter| is incremented immediately, so waiting on it also waits for
+// the job that has yet to be started.
+void PushJobAfter(JobSystem*, JobCounter* dependency, Job,
+                  JobCounter* counter = nullptr);
+
+// Hint of when the current frame's critical work has to be done, as a
+// GetNanoseconds timestamp. Background jobs won't be started within
+// |kBackgroundDeadlineMarginNs| of it. 0 clears the deadline.
+void SetFrameDeadline(JobSystem*, uint64_t deadline_ns);
+
+// Priority of the job the calling thread is running. Jobs pushed from within a
+// job normally should use this (ParallelFor does).
+// kNormal if the thread is not running a job.
+JobPriority GetCurrentJobPriority();
+
+// Waits for |counter| to reach zero. Instead of blocking, the calling thread
+// will run other pending jobs meanwhile. It only goes to sleep when there is
+// nothing else to do.
+void WaitForCounter(JobSystem*, JobCounter*);
+
+// Tries to find a pending job (own queue, injection queue or stealing) and run
+// it. Returns false if no job was found.
+bool RunPendingJob(JobSystem*);
+
+// Will run jobs as long as they're available. Returns when the thread could not
+// find any more jobs to do within the system.
+void RunPendingJobs(JobSystem*);
+
+// Returns -1 if the calling thread is not part of this system.
+int GetCurrentWorkerIndex(JobSystem*);
+
+inline bool AllJobsCompleted(JobSystem* js) {
+  return js->completed_jobs.load(std::memory_order_acquire) ==
+         js->pushed_jobs.load(std::memory_order_acquire);
+}
+
+}  // namespace warhol
@@ -0,0 +1,147 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// Bounded MPMC queue ----------------------------------------------------------
+//
+// Fixed capacity multi-producer/multi-consumer FIFO queue. No locks: producers
+// and consumers claim a position with a compare and exchange and then
+// synchronize through the sequence number of the cell at that position:
+//
+// - sequence == position:                 the cell is free to be written.
+// - sequence == position + 1:             the cell holds a value to be read.
+// - sequence == position + kCapacity:     free again, for the next lap.
+//
+// The value is written *before* the sequence is published (release) and read
+// *after* the sequence is observed (acquire), so a consumer never sees a
+// half-written value.
+//
+// When full, TryPush returns false instead of overwriting. It is up to the
+// caller to apply back-pressure.
+//
+// Based on Dmitry Vyukov's bounded MPMC queue.
+
+template <typename T, uint32_t kCapacity>
+struct MPMCQueue {
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "Capacity must be a power of two.");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Values are copied in and out of the cells.");
+
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    T value;
+  };
+
+  MPMCQueue() {
+    for (uint32_t i = 0; i < kCapacity; i++)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  DELETE_COPY_AND_ASSIGN(MPMCQueue);
+  DELETE_MOVE_AND_ASSIGN(MPMCQueue);
+
+  // Producers hammer |tail| and consumers hammer |head|, so they get their
+  // own cache lines.
+  alignas(64) std::atomic<uint64_t> head = 0;   // Next position to pop.
+  alignas(64) std::atomic<uint64_t> tail = 0;   // Next position to push.
+  alignas(64) Cell cells[kCapacity];
+};
+
+// Any thread can call these.
+// Returns false if the queue is full.
+template <typename T, uint32_t kCapacity>
+bool TryPush(MPMCQueue<T, kCapacity>*, const T&);
+
+// Returns false if the queue is empty.
+template <typename T, uint32_t kCapacity>
+bool TryPop(MPMCQueue<T, kCapacity>*, T* out);
+
+// This is only an approximation when other threads are touching the queue.
+template <typename T, uint32_t kCapacity>
+inline uint32_t Size(MPMCQueue<T, kCapacity>* queue) {
+  uint64_t head = queue->head.load(std::memory_order_acquire);
+  uint64_t tail = queue->tail.load(std::memory_order_acquire);
+  return tail > head ? (uint32_t)(tail - head) : 0;
+}
+
+template <typename T, uint32_t kCapacity>
+inline bool Empty(MPMCQueue<T, kCapacity>* queue) {
+  return Size(queue) == 0;
+}
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+template <typename T, uint32_t kCapacity>
+bool TryPush(MPMCQueue<T, kCapacity>* queue, const T& t) {
+  using Cell = typename MPMCQueue<T, kCapacity>::Cell;
+
+  Cell* cell;
+  uint64_t pos = queue->tail.load(std::memory_order_relaxed);
+  while (true) {
+    cell = &queue->cells[pos & (kCapacity - 1)];
+    uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+    int64_t diff = (int64_t)seq - (int64_t)pos;
+    if (diff == 0) {
+      // The cell is free. Try to claim the position.
+      if (queue->tail.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The cell still holds the value of the previous lap: full.
+      return false;
+    } else {
+      // Another producer claimed this position. Catch up.
+      pos = queue->tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->value = t;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint32_t kCapacity>
+bool TryPop(MPMCQueue<T, kCapacity>* queue, T* out) {
+  using Cell = typename MPMCQueue<T, kCapacity>::Cell;
+
+  Cell* cell;
+  uint64_t pos = queue->head.load(std::memory_order_relaxed);
+  while (true) {
+    cell = &queue->cells[pos & (kCapacity - 1)];
+    uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+    int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+    if (diff == 0) {
+      // The cell has a value. Try to claim the position.
+      if (queue->head.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The producer has not published this cell yet: empty.
+      return false;
+    } else {
+      // Another consumer claimed this position. Catch up.
+      pos = queue->head.load(std::memory_order_relaxed);
+    }
+  }
+
+  *out = cell->value;
+  // Free the cell for the producer of the next lap.
+  cell->sequence.store(pos + kCapacity, std::memory_order_release);
+  return true;
+}
+
+}  // namespace warhol
@@ -0,0 +1,21 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/multithreading/parallel_for.h"
+
+namespace warhol {
+
+size_t CalculateGrain(uint64_t elapsed_ns, size_t items) {
+  if (items == 0)
+    return 1;
+
+  // Avoid dividing by zero with very cheap items (or a coarse clock).
+  uint64_t ns_per_item = elapsed_ns / items;
+  if (ns_per_item == 0)
+    ns_per_item = 1;
+
+  size_t grain = (size_t)(kParallelForTargetChunkNs / ns_per_item);
+  return grain > 0 ? grain : 1;
+}
+
+}  // namespace warhol
@@ -0,0 +1,240 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+#include <utility>
+
+#include "warhol/multithreading/job_system.h"
+#include "warhol/platform/platform.h"
+
+namespace warhol {
+
+// ParallelFor / ParallelReduce ------------------------------------------------
+//
+// Runs |func| over [0, count) on the job system:
+//
+//   ParallelFor(job_system, chunks.size(), [&](size_t i) {
+//     chunks[i]->CalculateMesh();
+//   });
+//
+// The range is divided into chunks of (at least) |grain| items. The calling
+// thread splits the range recursively in halves: each split pushes the right
+// half as a job that will split itself further, which lets idle workers steal
+// big pieces of work first. The calling thread works on the range too, and
+// returns once all the items are done.
+//
+// The chunks are pushed with the priority of the calling job (see
+// GetCurrentJobPriority), so a ParallelFor within a background job stays in the
+// background.
+//
+// A |grain| of 0 means "measure it": the first few items are run serially on
+// the calling thread and timed, so that every chunk ends up being roughly
+// |kParallelForTargetChunkNs| of work.
+//
+// No heap allocation is done: the bookkeeping for every chunk lives on the
+// stack of the caller. Because of this, the amount of chunks is capped to
+// |kParallelForMaxChunks| (the chunks are made bigger instead).
+
+constexpr uint32_t kParallelForMaxChunks = 256;
+constexpr uint64_t kParallelForTargetChunkNs = 50 * 1000;   // 50 us.
+
+template <typename Func>
+void ParallelFor(JobSystem*, size_t count, Func&& func, size_t grain = 0);
+
+// |map| is T(size_t index). |reduce| is T(T, T) and must be associative.
+// T must be default constructible. The partial results are reduced in index
+// order, so |reduce| does not need to be commutative.
+template <typename T, typename MapFunc, typename ReduceFunc>
+T ParallelReduce(JobSystem*, size_t count, T identity,
+                 MapFunc&& map, ReduceFunc&& reduce, size_t grain = 0);
+
+// Given how long it took to run |items| items, returns a grain that would make
+// every chunk about |kParallelForTargetChunkNs| long.
+size_t CalculateGrain(uint64_t elapsed_ns, size_t items);
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+namespace parallel_for_internal {
+
+// |ChunkFunc| is called with (chunk index, begin, end).
+template <typename ChunkFunc>
+struct Context {
+  JobSystem* job_system = nullptr;
+  JobCounter* counter = nullptr;
+  ChunkFunc* chunk_func = nullptr;
+  JobPriority priority = JobPriority::kNormal;
+
+  size_t begin = 0;
+  size_t end = 0;
+  size_t chunk_size = 0;
+
+  struct Node {
+    Context* context = nullptr;
+    uint32_t chunk_begin = 0;
+    uint32_t chunk_end = 0;
+  };
+
+  // A node is always indexed by its first chunk, as every chunk is the start of
+  // at most one split.
+  Node nodes[kParallelForMaxChunks];
+};
+
+template <typename ChunkFunc>
+void RunNode(typename Context<ChunkFunc>::Node* node);
+
+template <typename ChunkFunc>
+void NodeJob(void* user_data) {
+  RunNode<ChunkFunc>((typename Context<ChunkFunc>::Node*)user_data);
+}
+
+template <typename ChunkFunc>
+void RunNode(typename Context<ChunkFunc>::Node* node) {
+  Context<ChunkFunc>* context = node->context;
+  uint32_t chunk_begin = node->chunk_begin;
+  uint32_t chunk_end = node->chunk_end;
+
+  // Keep giving away the right half until only one chunk is left.
+  while (chunk_end - chunk_begin > 1) {
+    uint32_t mid = chunk_begin + (chunk_end - chunk_begin) / 2;
+    auto* child = context->nodes + mid;
+    child->context = context;
+    child->chunk_begin = mid;
+    child->chunk_end = chunk_end;
+    Job job = {NodeJob<ChunkFunc>, child};
+    job.priority = context->priority;
+    PushJob(context->job_system, job, context->counter);
+
+    chunk_end = mid;
+  }
+
+  size_t begin = context->begin + chunk_begin * context->chunk_size;
+  size_t end = begin + context->chunk_size;
+  if (end > context->end)
+    end = context->end;
+  (*context->chunk_func)(chunk_begin, begin, end);
+}
+
+// Runs items serially until enough time has passed to have an idea of how
+// expensive they are. Returns how many items were run.
+template <typename ItemFunc>
+size_t SampleItems(size_t count, ItemFunc&& item_func, size_t* out_grain) {
+  // Below this we cannot trust the clock.
+  constexpr uint64_t kMinSampleNs = 2 * 1000;
+
+  uint64_t start = GetNanoseconds();
+  uint64_t elapsed = 0;
+  size_t index = 0;
+  size_t batch = 1;
+  while (index < count) {
+    size_t batch_end = index + batch;
+    if (batch_end > count)
+      batch_end = count;
+    for (; index < batch_end; index++)
+      item_func(index);
+
+    elapsed = GetNanoseconds() - start;
+    if (elapsed >= kMinSampleNs)
+      break;
+    batch *= 2;
+  }
+
+  *out_grain = CalculateGrain(elapsed, index);
+  return index;
+}
+
+// Divides [begin, end) into chunks and runs them on the job system.
+// Returns the amount of chunks used.
+template <typename ChunkFunc>
+uint32_t RunChunks(JobSystem* job_system, size_t begin, size_t end,
+                   size_t grain, ChunkFunc&& chunk_func) {
+  size_t count = end - begin;
+  if (count == 0)
+    return 0;
+  if (grain == 0)
+    grain = 1;
+
+  size_t chunk_count = (count + grain - 1) / grain;
+  if (chunk_count > kParallelForMaxChunks)
+    chunk_count = kParallelForMaxChunks;
+  size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+  chunk_count = (count + chunk_size - 1) / chunk_size;
+
+  // Not worth going through the job system.
+  if (chunk_count == 1) {
+    chunk_func(0, begin, end);
+    return 1;
+  }
+
+  using FuncType = typename std::remove_reference<ChunkFunc>::type;
+  JobCounter counter;
+  Context<FuncType> context;
+  context.job_system = job_system;
+  context.counter = &counter;
+  context.chunk_func = &chunk_func;
+  context.priority = GetCurrentJobPriority();
+  context.begin = begin;
+  context.end = end;
+  context.chunk_size = chunk_size;
+
+  auto* root = context.nodes;
+  root->context = &context;
+  root->chunk_begin = 0;
+  root->chunk_end = (uint32_t)chunk_count;
+  RunNode<FuncType>(root);
+
+  WaitForCounter(job_system, &counter);
+  return (uint32_t)chunk_count;
+}
+
+}  // namespace parallel_for_internal
+
+template <typename Func>
+void ParallelFor(JobSystem* job_system, size_t count, Func&& func,
+                 size_t grain) {
+  size_t begin = 0;
+  if (grain == 0)
+    begin = parallel_for_internal::SampleItems(count, func, &grain);
+
+  parallel_for_internal::RunChunks(
+      job_system, begin, count, grain,
+      [&func](uint32_t, size_t chunk_begin, size_t chunk_end) {
+        for (size_t i = chunk_begin; i < chunk_end; i++)
+          func(i);
+      });
+}
+
+template <typename T, typename MapFunc, typename ReduceFunc>
+T ParallelReduce(JobSystem* job_system, size_t count, T identity,
+                 MapFunc&& map, ReduceFunc&& reduce, size_t grain) {
+  T result = identity;
+
+  size_t begin = 0;
+  if (grain == 0) {
+    begin = parallel_for_internal::SampleItems(
+        count, [&](size_t i) { result = reduce(std::move(result), map(i)); },
+        &grain);
+  }
+
+  T partials[kParallelForMaxChunks];
+  uint32_t chunk_count = parallel_for_internal::RunChunks(
+      job_system, begin, count, grain,
+      [&](uint32_t chunk, size_t chunk_begin, size_t chunk_end) {
+        T partial = identity;
+        for (size_t i = chunk_begin; i < chunk_end; i++)
+          partial = reduce(std::move(partial), map(i));
+        partials[chunk] = std::move(partial);
+      });
+
+  for (uint32_t i = 0; i < chunk_count; i++)
+    result = reduce(std::move(result), std::move(partials[i]));
+  return result;
+}
+
+}  // namespace warhol
@@ -3,32 +3,166 @@
 
 #include "warhol/multithreading/semaphore.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "warhol/platform/platform.h"
+
 namespace warhol {
 
-void Semaphore::Wait() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  // This while will guard against spurious wake ups.
-  while (!count_) {
-    // The condition variable takes ownership of the lock. During this
-    // command, the lock is freed.
-    threads_waiting_++;
-    condition_.wait(lock);
-    // At this point the lock is acquired again.
+namespace {
+
+// Bounds for the adaptive spin of Semaphore::Wait, in pause iterations.
+constexpr int32_t kMinSpinCount = 16;
+constexpr int32_t kMaxSpinCount = 4096;
+constexpr int32_t kInitialSpinCount = 256;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+  _mm_pause();
+#endif
+}
+
+}  // namespace
+
+// Semaphore -------------------------------------------------------------------
+
+bool Semaphore::TryWait() {
+  int32_t count = count_.load(std::memory_order_relaxed);
+  while (count > 0) {
+    if (count_.compare_exchange_weak(count, count - 1,
+                                     std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Semaphore::SpinWait() {
+  int32_t spin_count = spin_count_.load(std::memory_order_relaxed);
+  if (spin_count == 0)
+    spin_count = kInitialSpinCount;
+
+  for (int32_t i = 0; i < spin_count; i++) {
+    if (TryWait()) {
+      // Spinning paid off, so we're more willing to spin next time.
+      int32_t new_spin = spin_count * 2;
+      spin_count_.store(new_spin < kMaxSpinCount ? new_spin : kMaxSpinCount,
+                        std::memory_order_relaxed);
+      return true;
+    }
+    CpuRelax();
+  }
+
+  int32_t new_spin = spin_count / 2;
+  spin_count_.store(new_spin > kMinSpinCount ? new_spin : kMinSpinCount,
+                    std::memory_order_relaxed);
+  return false;
+}
+
+void Semaphore::Park() {
+  // We're already accounted as a waiter in |count_|. A notifier will hand us
+  // a wake up through |wakeups_|.
+  while (true) {
+    uint32_t wakeups = wakeups_.load(std::memory_order_acquire);
+    while (wakeups > 0) {
+      if (wakeups_.compare_exchange_weak(wakeups, wakeups - 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    // Returns right away if a wake up arrived since we loaded it.
+    FutexWait(&wakeups_, 0);
   }
-  threads_waiting_--;
-  count_--;
 }
 
-void Semaphore::Notify() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  count_++;
-  condition_.notify_one();
+void Semaphore::Wait() {
+  if (TryWait() || SpinWait())
+    return;
+
+  // Nothing came while spinning: register as a waiter.
+  if (count_.fetch_sub(1, std::memory_order_acquire) > 0)
+    return;
+  Park();
+}
+
+void Semaphore::Notify(uint32_t count) {
+  if (count == 0)
+    return;
+
+  int32_t old = count_.fetch_add((int32_t)count, std::memory_order_release);
+  if (old >= 0)
+    return;
+
+  // Some threads are (or will be) parked. Wake up as many as we can.
+  uint32_t waiting = (uint32_t)-old;
+  uint32_t to_wake = waiting < count ? waiting : count;
+  wakeups_.fetch_add(to_wake, std::memory_order_release);
+  FutexWake(&wakeups_, to_wake);
 }
 
 void Semaphore::NotifyAll() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  count_ += threads_waiting_;
-  condition_.notify_all();
+  int32_t count = count_.load(std::memory_order_relaxed);
+  if (count < 0)
+    Notify((uint32_t)-count);
+}
+
+// Event -----------------------------------------------------------------------
+
+Event::Event(Type type, bool signaled)
+    : type_(type), status_(signaled ? 1 : 0) {}
+
+void Event::Signal() {
+  if (type_ == Type::kManualReset) {
+    int32_t old = status_.exchange(1, std::memory_order_release);
+    if (old < 0)
+      semaphore_.Notify((uint32_t)-old);
+    return;
+  }
+
+  // Auto reset: either release one waiter or become signaled.
+  int32_t old = status_.load(std::memory_order_relaxed);
+  while (true) {
+    int32_t new_status = old < 1 ? old + 1 : 1;
+    if (status_.compare_exchange_weak(old, new_status,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  if (old < 0)
+    semaphore_.Notify();
+}
+
+void Event::Reset() {
+  int32_t signaled = 1;
+  status_.compare_exchange_strong(signaled, 0, std::memory_order_relaxed);
+}
+
+void Event::Wait() {
+  if (type_ == Type::kAutoReset) {
+    if (status_.fetch_sub(1, std::memory_order_acquire) < 1)
+      semaphore_.Wait();
+    return;
+  }
+
+  // Manual reset: a signaled event is never consumed by waiting on it.
+  int32_t status = status_.load(std::memory_order_acquire);
+  while (true) {
+    if (status == 1)
+      return;
+    if (status_.compare_exchange_weak(status, status - 1,
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+      semaphore_.Wait();
+      return;
+    }
+  }
 }
 
 }  // namespace warhol
@@ -3,31 +3,94 @@
 
 #pragma once
 
-#include <condition_variable>
-#include <mutex>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "warhol/utils/macros.h"
 
 namespace warhol {
 
+// Semaphore -------------------------------------------------------------------
+//
+// Lightweight semaphore: the count lives in an atomic, so Notify/Wait only
+// touch the kernel when a thread actually has to sleep or be woken up.
+//
+// Wait spins for a short while before parking the thread on a futex (see
+// FutexWait in warhol/platform/platform.h). The amount of spinning adapts to
+// how often spinning actually paid off.
+
 class Semaphore {
   public:
+    Semaphore() = default;
+    DELETE_COPY_AND_ASSIGN(Semaphore);
+    DELETE_MOVE_AND_ASSIGN(Semaphore);
+
     // If there are no notifications waiting, the thread will wait on some other
     // thread to call on Notify.
     void Wait();
 
-    // Will add one to the count of pending notifications. If there are threads
-    // already waiting, this will wake up one of them. If no threads are
+    // Consumes a notification if there is one. Never blocks.
+    bool TryWait();
+
+    // Will add |count| to the pending notifications. If there are threads
+    // already waiting, this will wake up to |count| of them. If no threads are
     // waiting, the next time a thread calls Wait, it won't sleep but rather
     // decrease the notification count.
-    void Notify();
+    void Notify(uint32_t count = 1);
+
+    // Wakes up all the threads that are waiting right now.
     void NotifyAll();
 
   private:
-    std::mutex mutex_;
-    std::condition_variable condition_;
+    bool SpinWait();
+    void Park();
+
+    // Positive: notifications waiting to be consumed.
+    // Negative: amount of threads waiting (or about to wait).
+    std::atomic<int32_t> count_ = 0;
+
+    // Notifications handed to parked threads. This is the word they sleep on.
+    std::atomic<uint32_t> wakeups_ = 0;
+
+    std::atomic<int32_t> spin_count_ = 0;
+};
+
+// Event -----------------------------------------------------------------------
+//
+// Binary signal built on top of Semaphore:
+//
+// - kAutoReset: Signal releases exactly one waiter. If nobody is waiting, the
+//   event stays signaled until the next Wait consumes it.
+// - kManualReset: Signal releases every waiter and the event stays signaled
+//   (Wait returns immediately) until Reset is called.
+
+class Event {
+  public:
+    enum class Type {
+      kAutoReset,
+      kManualReset,
+    };
+
+    explicit Event(Type type = Type::kAutoReset, bool signaled = false);
+    DELETE_COPY_AND_ASSIGN(Event);
+    DELETE_MOVE_AND_ASSIGN(Event);
+
+    void Signal();
+    void Reset();
+    void Wait();
+
+    bool IsSignaled() const { return status_.load() == 1; }
+    Type type() const { return type_; }
+
+  private:
+    Type type_;
 
-    // Tracks how many notifications are currently "waiting".
-    uint32_t count_ = 0;
-    uint32_t threads_waiting_ = 0;
+    // 1: Signaled.
+    // 0: Not signaled, nobody waiting.
+    // -N: Not signaled, N threads waiting.
+    std::atomic<int32_t> status_;
+    Semaphore semaphore_;
 };
 
 }  // namespace warhol
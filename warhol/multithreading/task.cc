@@ -0,0 +1,65 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/multithreading/task.h"
+
+#include "warhol/utils/file.h"
+
+namespace warhol {
+
+namespace task_internal {
+
+void ResumeJob(void* user_data) {
+  std::coroutine_handle<>::from_address(user_data).resume();
+}
+
+}  // namespace task_internal
+
+// Awaitables ------------------------------------------------------------------
+
+void SwitchToWorker::await_suspend(std::coroutine_handle<> handle) {
+  Job job = {task_internal::ResumeJob, handle.address()};
+  job.priority = priority;
+  PushJob(job_system, job);
+}
+
+void WaitFor::await_suspend(std::coroutine_handle<> handle) {
+  // The counter is commonly a local of the coroutine, so the resumed coroutine
+  // can destroy it. Dependents only run once the counter has been released
+  // (see DecrementCounter), which makes that safe. Neither |this| nor the
+  // counter can be touched once the job is pushed.
+  Job job = {task_internal::ResumeJob, handle.address()};
+  job.priority = GetCurrentJobPriority();
+  PushJobAfter(job_system, counter, job);
+}
+
+Task<bool> ReadFileAsync(JobSystem* js, std::string path, std::string* out,
+                         bool add_extra_zero) {
+  co_await SwitchToWorker(js, JobPriority::kBackground);
+  co_return ReadWholeFile(path, out, add_extra_zero);
+}
+
+// FrameContinuations ----------------------------------------------------------
+
+void NextFrame::await_suspend(std::coroutine_handle<> handle) {
+  std::lock_guard<std::mutex> lock(continuations->mutex);
+  continuations->pending.push_back(handle);
+}
+
+uint32_t RunFrameContinuations(FrameContinuations* continuations) {
+  {
+    std::lock_guard<std::mutex> lock(continuations->mutex);
+    ASSERT(continuations->running.empty()) << "Called recursively.";
+    continuations->pending.swap(continuations->running);
+  }
+
+  // Whatever awaits NextFrame from here on goes into |pending|.
+  uint32_t count = (uint32_t)continuations->running.size();
+  for (std::coroutine_handle<> handle : continuations->running)
+    handle.resume();
+  continuations->running.clear();
+
+  return count;
+}
+
+}  // namespace warhol
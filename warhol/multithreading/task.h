@@ -0,0 +1,289 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "warhol/multithreading/job_system.h"
+#include "warhol/utils/log.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// Task ------------------------------------------------------------------------
+//
+// C++20 coroutine that runs on the job system. Lets multi-step work (read ->
+// decode -> upload) be written linearly while each step runs where it should:
+//
+//   Task<bool> LoadThing(JobSystem* js, FrameContinuations* main_thread,
+//                        std::string path, Thing* out) {
+//     std::string data;
+//     if (!co_await ReadFileAsync(js, path, &data))   // Background worker.
+//       co_return false;
+//     Decode(data, out);                              // Still on the worker.
+//     co_await NextFrame(main_thread);                // Main thread.
+//     co_return Upload(out);
+//   }
+//
+// Tasks are lazy: nothing runs until the task is either awaited by another
+// coroutine (it then starts on the awaiting thread) or given to RunTask (it
+// then starts on a worker). The Task object owns the coroutine, so it has to be
+// kept alive until it's done.
+//
+// Things a Task can co_await:
+//
+// - Another Task: runs it and resumes with its result.
+// - SwitchToWorker: continues as a job with the given priority.
+// - WaitFor: continues once a JobCounter reaches zero (see PushJob).
+// - ReadFileAsync: reads a file on a background worker.
+// - NextFrame: continues on the thread that runs the FrameContinuations.
+//
+// Exceptions are not supported: they abort.
+
+template <typename T = void>
+class Task;
+
+namespace task_internal {
+
+struct PromiseBase {
+  // Lazy start.
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  // When done, continues directly with whoever awaited us (if any).
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      PromiseBase& promise = handle.promise();
+      if (promise.continuation)
+        return promise.continuation;
+
+      // Started by RunTask. The waiter can destroy the task as soon as the
+      // counter is decremented, so nothing can touch the promise after that.
+      JobCounter* counter = promise.counter;
+      if (counter)
+        DecrementCounter(counter);
+      return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { NOT_REACHED() << "Exception within a Task."; }
+
+  std::coroutine_handle<> continuation;
+  JobCounter* counter = nullptr;    // Set by RunTask.
+};
+
+template <typename T>
+struct Promise : public PromiseBase {
+  Task<T> get_return_object();
+
+  template <typename U>
+  void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+
+  T TakeResult() {
+    ASSERT(result.has_value());
+    return std::move(*result);
+  }
+
+  std::optional<T> result;
+};
+
+template <>
+struct Promise<void> : public PromiseBase {
+  Task<void> get_return_object();
+
+  void return_void() {}
+  void TakeResult() {}
+};
+
+// Job that resumes the coroutine given as |user_data|.
+void ResumeJob(void* user_data);
+
+}  // namespace task_internal
+
+template <typename T>
+class Task {
+  public:
+    using promise_type = task_internal::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle_(handle) {}
+    ~Task() { Reset(); }
+
+    DELETE_COPY_AND_ASSIGN(Task);
+    Task(Task&& rhs) : handle_(std::exchange(rhs.handle_, nullptr)) {}
+    Task& operator=(Task&& rhs) {
+      if (this != &rhs) {
+        Reset();
+        handle_ = std::exchange(rhs.handle_, nullptr);
+      }
+      return *this;
+    }
+
+    bool valid() const { return !!handle_; }
+    bool done() const { return handle_ && handle_.done(); }
+    Handle handle() const { return handle_; }
+
+    // Moves the result out. Only valid once the task is done.
+    T TakeResult() {
+      ASSERT(done());
+      return handle_.promise().TakeResult();
+    }
+
+    // Awaiting a task starts it on the awaiting thread. The awaiter is resumed
+    // by whatever thread finishes the task.
+    auto operator co_await() && noexcept {
+      struct Awaiter {
+        bool await_ready() noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<> awaiting) noexcept {
+          handle.promise().continuation = awaiting;
+          return handle;
+        }
+
+        T await_resume() {
+          ASSERT(handle) << "Awaiting an empty task.";
+          return handle.promise().TakeResult();
+        }
+
+        Handle handle;
+      };
+      return Awaiter{handle_};
+    }
+    auto operator co_await() & noexcept {
+      return std::move(*this).operator co_await();
+    }
+
+  private:
+    void Reset() {
+      if (!handle_)
+        return;
+      ASSERT(handle_.done()) << "Destroying a task that is still running.";
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+
+    Handle handle_;
+};
+
+namespace task_internal {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+}  // namespace task_internal
+
+// Starts |task| as a job. |counter| is incremented now and decremented once the
+// task is done (not when it first suspends), so WaitForCounter can be used to
+// join on it.
+template <typename T>
+void RunTask(JobSystem* js, Task<T>* task, JobCounter* counter,
+             JobPriority priority = JobPriority::kNormal) {
+  ASSERT(task->valid() && !task->done());
+  ASSERT(!task->handle().promise().continuation) << "Task already awaited.";
+
+  IncrementCounter(counter);
+  task->handle().promise().counter = counter;
+
+  Job job = {task_internal::ResumeJob, task->handle().address()};
+  job.priority = priority;
+  PushJob(js, job);
+}
+
+// Runs |task| on the job system and waits for it (running other jobs
+// meanwhile, see WaitForCounter).
+// NOTE: Do not use it from the thread that runs the FrameContinuations the
+//       task waits on, as they would never be run.
+template <typename T>
+T RunTaskAndWait(JobSystem* js, Task<T> task) {
+  JobCounter counter;
+  RunTask(js, &task, &counter);
+  WaitForCounter(js, &counter);
+  return task.TakeResult();
+}
+
+// Awaitables ------------------------------------------------------------------
+
+// co_await SwitchToWorker(js) continues the coroutine as a new job.
+struct SwitchToWorker {
+  SwitchToWorker(JobSystem* js, JobPriority priority = JobPriority::kNormal)
+      : job_system(js), priority(priority) {}
+
+  bool await_ready() noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() noexcept {}
+
+  JobSystem* job_system;
+  JobPriority priority;
+};
+
+// co_await WaitFor(js, counter) continues the coroutine as a job once |counter|
+// reaches zero. The job keeps the priority of the awaiting one.
+// |counter| can live in the coroutine's frame: it is not touched anymore once
+// the coroutine is resumed.
+struct WaitFor {
+  WaitFor(JobSystem* js, JobCounter* counter)
+      : job_system(js), counter(counter) {}
+
+  bool await_ready() noexcept { return Done(counter); }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() noexcept {}
+
+  JobSystem* job_system;
+  JobCounter* counter;
+};
+
+// Reads |path| on a background worker (see ReadWholeFile). The awaiting
+// coroutine continues on that worker.
+Task<bool> ReadFileAsync(JobSystem*, std::string path, std::string* out,
+                         bool add_extra_zero = true);
+
+// FrameContinuations ----------------------------------------------------------
+//
+// Coroutines waiting to be resumed by a particular thread (normally the main
+// one, for things like uploading to the GPU). The owner calls
+// RunFrameContinuations once per frame. Coroutines that await NextFrame while
+// those are running go to the next frame.
+
+struct FrameContinuations {
+  std::mutex mutex;
+  std::vector<std::coroutine_handle<>> pending;
+  std::vector<std::coroutine_handle<>> running;   // Reused to avoid allocs.
+};
+
+// co_await NextFrame(continuations).
+struct NextFrame {
+  NextFrame(FrameContinuations* continuations)
+      : continuations(continuations) {}
+
+  bool await_ready() noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() noexcept {}
+
+  FrameContinuations* continuations;
+};
+
+// Resumes the coroutines that were waiting on |continuations|. Returns how many
+// were resumed.
+uint32_t RunFrameContinuations(FrameContinuations*);
+
+}  // namespace warhol
@@ -0,0 +1,166 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// Chase-Lev work stealing deque -----------------------------------------------
+//
+// Fixed capacity single-producer/multi-consumer deque:
+//
+// - The owner thread pushes and pops from the bottom (LIFO), which keeps the
+//   cache warm with the work it just generated.
+// - Any other thread can steal from the top (FIFO), which tends to take the
+//   oldest (and normally biggest) chunks of work.
+//
+// The capacity is fixed: when full, Push returns false instead of overwriting
+// unfinished work. It is up to the caller to apply back-pressure.
+//
+// Values are stored as a series of relaxed atomic words, so a thief reading a
+// slot the owner is overwriting is not a data race. Such a read can only occur
+// when the thief has already lost the race for |top|, so the (possibly torn)
+// value is discarded by the failing compare and exchange.
+//
+// Based on "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Lê, Pop, Cohen, Zappa Nardelli, 2013).
+
+template <typename T, uint32_t kCapacity>
+struct WorkStealingDeque {
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "Capacity must be a power of two.");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Values are copied word by word.");
+
+  static constexpr uint32_t kWordCount = (sizeof(T) + 7) / 8;
+
+  struct Slot {
+    std::atomic<uint64_t> words[kWordCount];
+  };
+
+  WorkStealingDeque() = default;
+  DELETE_COPY_AND_ASSIGN(WorkStealingDeque);
+  DELETE_MOVE_AND_ASSIGN(WorkStealingDeque);
+
+  // Top and bottom are on their own cache lines, as thieves hammer |top| while
+  // the owner is constantly touching |bottom|.
+  alignas(64) std::atomic<int64_t> top = 0;
+  alignas(64) std::atomic<int64_t> bottom = 0;
+  alignas(64) Slot slots[kCapacity];
+};
+
+// Only the owner thread can call these.
+template <typename T, uint32_t kCapacity>
+bool Push(WorkStealingDeque<T, kCapacity>*, const T&);
+template <typename T, uint32_t kCapacity>
+bool Pop(WorkStealingDeque<T, kCapacity>*, T* out);
+
+// Any thread can call these.
+template <typename T, uint32_t kCapacity>
+bool Steal(WorkStealingDeque<T, kCapacity>*, T* out);
+
+// This is only an approximation when other threads are touching the deque.
+template <typename T, uint32_t kCapacity>
+inline uint32_t Size(WorkStealingDeque<T, kCapacity>* deque) {
+  int64_t b = deque->bottom.load(std::memory_order_relaxed);
+  int64_t t = deque->top.load(std::memory_order_relaxed);
+  return b > t ? (uint32_t)(b - t) : 0;
+}
+
+template <typename T, uint32_t kCapacity>
+inline bool Empty(WorkStealingDeque<T, kCapacity>* deque) {
+  return Size(deque) == 0;
+}
+
+// *****************************************************************************
+// Template Implementation
+// *****************************************************************************
+
+template <typename T, uint32_t kCapacity>
+inline void
+StoreSlot(typename WorkStealingDeque<T, kCapacity>::Slot* slot, const T& t) {
+  uint64_t words[WorkStealingDeque<T, kCapacity>::kWordCount] = {};
+  memcpy(words, &t, sizeof(T));
+  for (uint32_t i = 0; i < WorkStealingDeque<T, kCapacity>::kWordCount; i++)
+    slot->words[i].store(words[i], std::memory_order_relaxed);
+}
+
+template <typename T, uint32_t kCapacity>
+inline void
+LoadSlot(typename WorkStealingDeque<T, kCapacity>::Slot* slot, T* out) {
+  uint64_t words[WorkStealingDeque<T, kCapacity>::kWordCount];
+  for (uint32_t i = 0; i < WorkStealingDeque<T, kCapacity>::kWordCount; i++)
+    words[i] = slot->words[i].load(std::memory_order_relaxed);
+  memcpy((void*)out, words, sizeof(T));
+}
+
+template <typename T, uint32_t kCapacity>
+bool Push(WorkStealingDeque<T, kCapacity>* deque, const T& t) {
+  int64_t b = deque->bottom.load(std::memory_order_relaxed);
+  int64_t top = deque->top.load(std::memory_order_acquire);
+  if (b - top >= (int64_t)kCapacity)
+    return false;
+
+  StoreSlot<T, kCapacity>(&deque->slots[b & (kCapacity - 1)], t);
+  // Publish the slot before the new bottom is visible to thieves.
+  deque->bottom.store(b + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint32_t kCapacity>
+bool Pop(WorkStealingDeque<T, kCapacity>* deque, T* out) {
+  int64_t b = deque->bottom.load(std::memory_order_relaxed) - 1;
+  deque->bottom.store(b, std::memory_order_relaxed);
+  // The bottom store has to be visible before we read top, otherwise a thief
+  // and the owner could both take the last element.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = deque->top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    // Empty deque. Restore the bottom.
+    deque->bottom.store(b + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  LoadSlot<T, kCapacity>(&deque->slots[b & (kCapacity - 1)], out);
+  if (t < b)
+    return true;
+
+  // Last element: we race with the thieves for it.
+  bool won = deque->top.compare_exchange_strong(t, t + 1,
+                                                std::memory_order_seq_cst,
+                                                std::memory_order_relaxed);
+  deque->bottom.store(b + 1, std::memory_order_relaxed);
+  return won;
+}
+
+template <typename T, uint32_t kCapacity>
+bool Steal(WorkStealingDeque<T, kCapacity>* deque, T* out) {
+  int64_t t = deque->top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = deque->bottom.load(std::memory_order_acquire);
+  if (t >= b)
+    return false;
+
+  T value;
+  LoadSlot<T, kCapacity>(&deque->slots[t & (kCapacity - 1)], &value);
+  if (!deque->top.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+    // Either another thief or the owner got it.
+    return false;
+  }
+
+  *out = value;
+  return true;
+}
+
+}  // namespace warhol
@@ -0,0 +1,97 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include "warhol/multithreading/worker_pool.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "warhol/utils/log.h"
+
+namespace warhol {
+
+namespace {
+
+// CPUs in the order workers get them. The first core is left for the calling
+// thread.
+std::vector<uint32_t> GetWorkerCpus(const CpuTopology& topology,
+                                    const WorkerPoolConfig& config) {
+  std::vector<uint32_t> cpus;
+  for (const CpuInfo& cpu : topology.cpus) {
+    if (cpu.core == topology.cpus.front().core)
+      continue;
+    if (cpu.smt_sibling && !config.use_smt_siblings)
+      continue;
+    cpus.push_back(cpu.id);
+  }
+
+  return cpus;
+}
+
+void WorkerMain(WorkerPool::WorkerFunc func, void* user_data, uint32_t index,
+                std::string name, int32_t cpu) {
+  char thread_name[64];
+  snprintf(thread_name, sizeof(thread_name), "%s %u", name.c_str(), index);
+  SetCurrentThreadName(thread_name);
+
+  if (cpu != WorkerPool::kNotPinned && !SetCurrentThreadAffinity(cpu))
+    LOG(WARNING) << "Could not pin " << thread_name << " to CPU " << cpu;
+
+  func(user_data, index);
+}
+
+}  // namespace
+
+WorkerPool::~WorkerPool() {
+  if (Valid(this))
+    JoinWorkerPool(this);
+}
+
+uint32_t GetWorkerCount(const CpuTopology& topology,
+                        const WorkerPoolConfig& config) {
+  if (config.worker_count > 0)
+    return config.worker_count;
+
+  uint32_t count = (uint32_t)GetWorkerCpus(topology, config).size();
+  return count > 0 ? count : 1;
+}
+
+bool StartWorkerPool(WorkerPool* pool, const WorkerPoolConfig& config,
+                     WorkerPool::WorkerFunc func, void* user_data) {
+  ASSERT(!Valid(pool));
+
+  pool->topology = GetCpuTopology();
+  pool->worker_count = GetWorkerCount(pool->topology, config);
+
+  std::vector<uint32_t> worker_cpus = GetWorkerCpus(pool->topology, config);
+  pool->cpus = std::make_unique<int32_t[]>(pool->worker_count);
+  for (uint32_t i = 0; i < pool->worker_count; i++) {
+    bool pinned = config.pin_threads && i < worker_cpus.size();
+    pool->cpus[i] = pinned ? (int32_t)worker_cpus[i] : WorkerPool::kNotPinned;
+  }
+
+  pool->threads = std::make_unique<std::thread[]>(pool->worker_count);
+  for (uint32_t i = 0; i < pool->worker_count; i++) {
+    pool->threads[i] = std::thread(WorkerMain, func, user_data, i,
+                                   std::string(config.name), pool->cpus[i]);
+  }
+
+  LOG(DEBUG) << "Started " << pool->worker_count << " workers on "
+             << pool->topology.core_count << " cores ("
+             << pool->topology.cpus.size() << " logical CPUs).";
+  return true;
+}
+
+void JoinWorkerPool(WorkerPool* pool) {
+  ASSERT(Valid(pool));
+
+  for (uint32_t i = 0; i < pool->worker_count; i++)
+    pool->threads[i].join();
+
+  pool->threads.reset();
+  pool->cpus.reset();
+  pool->worker_count = 0;
+}
+
+}  // namespace warhol
@@ -0,0 +1,74 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <thread>
+
+#include "warhol/platform/platform.h"
+#include "warhol/utils/macros.h"
+
+namespace warhol {
+
+// WorkerPool ------------------------------------------------------------------
+//
+// Owns a set of long lived threads. Each one is named (so it shows up in
+// debuggers and profilers) and optionally pinned to its own CPU, so the OS
+// does not migrate it around (which shows up as frame time jitter).
+//
+// CPUs are handed out core by core (see CpuTopology): the first core is left
+// for the thread that starts the pool (normally the main thread), then every
+// worker gets the first logical CPU of a different core. SMT siblings are only
+// used once every core has a worker, and only if |use_smt_siblings| is set.
+// Workers that do not get a CPU of their own are not pinned.
+//
+// The pool knows nothing about *what* the workers do: |func| is expected to
+// return once its owner tells it to (eg. JobSystem::running). JoinWorkerPool
+// then waits for all of them.
+
+struct WorkerPoolConfig {
+  // 0 means one per CPU we can use (see |use_smt_siblings|), minus the calling
+  // thread's. Always at least one.
+  uint32_t worker_count = 0;
+
+  bool pin_threads = true;
+  bool use_smt_siblings = true;
+
+  // Threads are named "<name> <index>".
+  const char* name = "Worker";
+};
+
+struct WorkerPool {
+  // |worker_index| goes from 0 to |worker_count| - 1.
+  using WorkerFunc = void (*)(void* user_data, uint32_t worker_index);
+
+  static constexpr int32_t kNotPinned = -1;
+
+  WorkerPool() = default;
+  ~WorkerPool();
+  DELETE_COPY_AND_ASSIGN(WorkerPool);
+  DELETE_MOVE_AND_ASSIGN(WorkerPool);
+
+  CpuTopology topology;
+  uint32_t worker_count = 0;
+
+  std::unique_ptr<std::thread[]> threads;
+  std::unique_ptr<int32_t[]> cpus;    // Logical CPU per worker or kNotPinned.
+};
+
+inline bool Valid(WorkerPool* pool) { return !!pool->threads; }
+
+// How many workers a config would start with this topology.
+uint32_t GetWorkerCount(const CpuTopology&, const WorkerPoolConfig&);
+
+bool StartWorkerPool(WorkerPool*, const WorkerPoolConfig&,
+                     WorkerPool::WorkerFunc, void* user_data);
+
+// Waits for every worker function to return. The owner has to make them do so.
+// RAII semantics will take care of this also.
+void JoinWorkerPool(WorkerPool*);
+
+}  // namespace warhol
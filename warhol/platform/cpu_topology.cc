@@ -0,0 +1,67 @@
+// Copyright 2019, Cristián Donoso.
+// This code has a BSD license. See LICENSE.
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "warhol/platform/platform.h"
+
+namespace warhol {
+
+namespace {
+
+std::vector<CpuInfo> FallbackCpus() {
+  uint32_t count = std::thread::hardware_concurrency();
+  if (count == 0)
+    count = 1;
+
+  std::vector<CpuInfo> cpus(count);
+  for (uint32_t i = 0; i < count; i++) {
+    cpus[i].id = i;
+    cpus[i].core = i;
+  }
+  return cpus;
+}
+
+}  // namespace
+
+CpuTopology GetCpuTopology() {
+  std::vector<CpuInfo> cpus;
+  if (!ReadPlatformCpus(&cpus) || cpus.empty())
+    cpus = FallbackCpus();
+
+  std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+    return a.id < b.id;
+  });
+
+  // OS core ids only identify a core within its package.
+  CpuTopology topology = {};
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> cores;
+  std::map<uint32_t, uint32_t> packages;
+  for (CpuInfo& cpu : cpus) {
+    auto [package_it, new_package] =
+        packages.insert({cpu.package, (uint32_t)packages.size()});
+    (void)new_package;
+
+    auto [core_it, new_core] =
+        cores.insert({{cpu.package, cpu.core}, (uint32_t)cores.size()});
+    cpu.package = package_it->second;
+    cpu.core = core_it->second;
+    cpu.smt_sibling = !new_core;
+  }
+
+  // First logical CPU of every core first, then the siblings.
+  std::stable_sort(cpus.begin(), cpus.end(),
+                   [](const CpuInfo& a, const CpuInfo& b) {
+    return !a.smt_sibling && b.smt_sibling;
+  });
+
+  topology.cpus = std::move(cpus);
+  topology.core_count = (uint32_t)cores.size();
+  topology.package_count = (uint32_t)packages.size();
+  return topology;
+}
+
+}  // namespace warhol
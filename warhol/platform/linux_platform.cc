@@ -4,8 +4,14 @@
 #include "warhol/platform/platform.h"
 
 #include <errno.h>
+#include <linux/futex.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -49,4 +55,134 @@ uint64_t GetNanoseconds() {
   return now.tv_sec * 1000000000 + now.tv_nsec;
 }
 
+// Futex -----------------------------------------------------------------------
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Futexes operate on plain 32-bit words.");
+
+void FutexWait(std::atomic<uint32_t>* address, uint32_t expected) {
+  // Returns immediately (EAGAIN) if the value is not |expected| anymore.
+  syscall(SYS_futex, (uint32_t*)address, FUTEX_WAIT_PRIVATE, expected,
+          nullptr, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t>* address, uint32_t count) {
+  if (count > INT_MAX)
+    count = INT_MAX;
+  syscall(SYS_futex, (uint32_t*)address, FUTEX_WAKE_PRIVATE, (int)count,
+          nullptr, nullptr, 0);
+}
+
+// Virtual Memory --------------------------------------------------------------
+
+size_t GetPageSize() {
+  static size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+void* ReserveVirtualMemory(size_t size) {
+  // NORESERVE: don't count it against the overcommit limit until it's used.
+  void* address = mmap(nullptr, size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return address != MAP_FAILED ? address : nullptr;
+}
+
+bool CommitVirtualMemory(void* address, size_t size) {
+  return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void DecommitVirtualMemory(void* address, size_t size) {
+  // DONTNEED drops the pages right away. They are zero-filled when touched
+  // again.
+  madvise(address, size, MADV_DONTNEED);
+  mprotect(address, size, PROT_NONE);
+}
+
+void ReleaseVirtualMemory(void* address, size_t size) {
+  munmap(address, size);
+}
+
+// CPU Topology ----------------------------------------------------------------
+
+namespace {
+
+bool ReadUint(const char* path, uint32_t* out) {
+  FILE* file = fopen(path, "r");
+  if (!file)
+    return false;
+  bool ok = fscanf(file, "%u", out) == 1;
+  fclose(file);
+  return ok;
+}
+
+// Parses a CPU list as the kernel writes them: "0-3,8,10-11".
+bool ReadCpuList(const char* path, std::vector<uint32_t>* out) {
+  FILE* file = fopen(path, "r");
+  if (!file)
+    return false;
+
+  uint32_t begin, end;
+  while (fscanf(file, "%u", &begin) == 1) {
+    end = begin;
+    int c = fgetc(file);
+    if (c == '-') {
+      if (fscanf(file, "%u", &end) != 1)
+        break;
+      c = fgetc(file);
+    }
+
+    for (uint32_t cpu = begin; cpu <= end; cpu++)
+      out->push_back(cpu);
+    if (c != ',')
+      break;
+  }
+
+  fclose(file);
+  return !out->empty();
+}
+
+}  // namespace
+
+bool ReadPlatformCpus(std::vector<CpuInfo>* out) {
+  std::vector<uint32_t> online;
+  if (!ReadCpuList("/sys/devices/system/cpu/online", &online))
+    return false;
+
+  char path[128];
+  for (uint32_t id : online) {
+    CpuInfo cpu = {};
+    cpu.id = id;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%u/topology/core_id", id);
+    if (!ReadUint(path, &cpu.core))
+      return false;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", id);
+    if (!ReadUint(path, &cpu.package))
+      return false;
+
+    out->push_back(cpu);
+  }
+
+  return true;
+}
+
+// Threads ---------------------------------------------------------------------
+
+bool SetCurrentThreadAffinity(uint32_t cpu_id) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu_id, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void SetCurrentThreadName(const char* name) {
+  // The kernel only takes 15 characters (plus the zero).
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%s", name);
+  pthread_setname_np(pthread_self(), buf);
+}
+
 }  // namespace warhol
@@ -6,6 +6,9 @@
 #include <errno.h>
 #include <stdio.h>
 #include <mach-o/dyld.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <sys/errno.h>
 
 #include "warhol/platform/path.h"
@@ -47,3 +50,69 @@ std::string GetBasePath() {
 #error GetPerformanceFrequency not implemented.
 
 }  // namespace warhol
+
+#include <condition_variable>
+#include <mutex>
+
+namespace warhol {
+
+// Futex -----------------------------------------------------------------------
+//
+// MacOS has no public futex API, so we emulate it with a global condition
+// variable. The wake takes the same lock the sleeper checks the value under,
+// so no wake up can be missed.
+
+namespace {
+
+std::mutex gFutexMutex;
+std::condition_variable gFutexCondition;
+
+}  // namespace
+
+void FutexWait(std::atomic<uint32_t>* address, uint32_t expected) {
+  std::unique_lock<std::mutex> lock(gFutexMutex);
+  if (address->load() == expected)
+    gFutexCondition.wait(lock);
+}
+
+void FutexWake(std::atomic<uint32_t>*, uint32_t) {
+  std::lock_guard<std::mutex> lock(gFutexMutex);
+  gFutexCondition.notify_all();
+}
+
+// Virtual Memory --------------------------------------------------------------
+
+size_t GetPageSize() { return (size_t)getpagesize(); }
+
+void* ReserveVirtualMemory(size_t size) {
+  void* address = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+  return address != MAP_FAILED ? address : nullptr;
+}
+
+bool CommitVirtualMemory(void* address, size_t size) {
+  return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void DecommitVirtualMemory(void* address, size_t size) {
+  // Unlike Linux, MADV_DONTNEED does not zero the pages here. Mapping over
+  // them does.
+  mmap(address, size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0);
+}
+
+void ReleaseVirtualMemory(void* address, size_t size) {
+  munmap(address, size);
+}
+
+// CPU Topology ----------------------------------------------------------------
+
+// Not exposed by MacOS in a way we use yet.
+bool ReadPlatformCpus(std::vector<CpuInfo>*) { return false; }
+
+// Threads ---------------------------------------------------------------------
+
+// MacOS has no way of pinning threads (only affinity hints).
+bool SetCurrentThreadAffinity(uint32_t) { return false; }
+
+void SetCurrentThreadName(const char* name) { pthread_setname_np(name); }
+
+}  // namespace warhol
@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <atomic>
 #include <string>
+#include <vector>
 
 namespace warhol {
 
@@ -17,4 +21,68 @@ std::string GetCurrentExecutableDirectory();
 
 uint64_t GetNanoseconds();
 
+// Futex -----------------------------------------------------------------------
+//
+// Lowest level thread parking primitive. Higher level synchronization objects
+// (see warhol/multithreading/semaphore.h) are built on top of these.
+
+// Puts the calling thread to sleep if |*address| is still |expected|. It will
+// sleep until some other thread calls FutexWake on the same address.
+// Can wake up spuriously, so always re-check the condition after returning.
+void FutexWait(std::atomic<uint32_t>* address, uint32_t expected);
+
+// Wakes up to |count| threads sleeping on |address|.
+void FutexWake(std::atomic<uint32_t>* address, uint32_t count);
+
+// Virtual Memory --------------------------------------------------------------
+//
+// Address space can be reserved without being backed by physical memory. Pages
+// only cost memory once committed, and can be given back (decommitted) while
+// keeping the range reserved.
+
+size_t GetPageSize();
+
+// |size| is rounded up to whole pages. Returns nullptr on failure.
+void* ReserveVirtualMemory(size_t size);
+
+// Committed memory reads as zero the first time (and after a decommit).
+bool CommitVirtualMemory(void* address, size_t size);
+void DecommitVirtualMemory(void* address, size_t size);
+
+void ReleaseVirtualMemory(void* address, size_t size);
+
+// CPU Topology ----------------------------------------------------------------
+
+struct CpuInfo {
+  uint32_t id = 0;          // Logical CPU, as the OS knows it (for affinity).
+  uint32_t core = 0;        // Index of the physical core within the topology.
+  uint32_t package = 0;
+  bool smt_sibling = false; // Not the first logical CPU of its core.
+};
+
+struct CpuTopology {
+  // Online CPUs. The first logical CPU of every core comes first (in core
+  // order), then the SMT siblings. Taking a prefix spreads over the cores.
+  std::vector<CpuInfo> cpus;
+  uint32_t core_count = 0;
+  uint32_t package_count = 0;
+};
+
+// Reads the topology from the OS (/sys/devices/system/cpu in Linux). If it's
+// not available, every hardware thread is reported as its own core.
+CpuTopology GetCpuTopology();
+
+// Implemented by each platform, used by GetCpuTopology. Only has to fill the
+// ids, with |core| being the OS core id (which can repeat across packages).
+// Returns false if the topology is not available.
+bool ReadPlatformCpus(std::vector<CpuInfo>* out);
+
+// Threads ---------------------------------------------------------------------
+
+// Pins the calling thread to the logical CPU |cpu_id| (see CpuInfo::id).
+bool SetCurrentThreadAffinity(uint32_t cpu_id);
+
+// Name shown by debuggers and profilers. Linux truncates it to 15 characters.
+void SetCurrentThreadName(const char* name);
+
 }  // namespace warhol
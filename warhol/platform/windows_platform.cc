@@ -72,4 +72,101 @@ uint64_t GetNanoseconds() {
   return (uint64_t)ddiff;
 }
 
+// Futex -----------------------------------------------------------------------
+
+void FutexWait(std::atomic<uint32_t>* address, uint32_t expected) {
+  ::WaitOnAddress(address, &expected, sizeof(uint32_t), INFINITE);
+}
+
+void FutexWake(std::atomic<uint32_t>* address, uint32_t count) {
+  if (count == 1) {
+    ::WakeByAddressSingle(address);
+  } else {
+    ::WakeByAddressAll(address);
+  }
+}
+
+// Virtual Memory --------------------------------------------------------------
+
+size_t GetPageSize() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (size_t)info.dwPageSize;
+}
+
+void* ReserveVirtualMemory(size_t size) {
+  return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool CommitVirtualMemory(void* address, size_t size) {
+  return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void DecommitVirtualMemory(void* address, size_t size) {
+  VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void ReleaseVirtualMemory(void* address, size_t) {
+  VirtualFree(address, 0, MEM_RELEASE);
+}
+
+// CPU Topology ----------------------------------------------------------------
+
+bool ReadPlatformCpus(std::vector<CpuInfo>* out) {
+  DWORD size = 0;
+  GetLogicalProcessorInformation(nullptr, &size);
+  if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+    return false;
+
+  using Info = SYSTEM_LOGICAL_PROCESSOR_INFORMATION;
+  std::vector<Info> infos(size / sizeof(Info));
+  if (!GetLogicalProcessorInformation(infos.data(), &size))
+    return false;
+
+  // Only the first processor group (64 CPUs) is visible through this API.
+  uint32_t core = 0;
+  for (const Info& info : infos) {
+    if (info.Relationship != RelationProcessorCore)
+      continue;
+    for (uint32_t id = 0; id < 64; id++) {
+      if (info.ProcessorMask & ((ULONG_PTR)1 << id)) {
+        CpuInfo cpu = {};
+        cpu.id = id;
+        cpu.core = core;
+        out->push_back(cpu);
+      }
+    }
+    core++;
+  }
+
+  uint32_t package = 0;
+  for (const Info& info : infos) {
+    if (info.Relationship != RelationProcessorPackage)
+      continue;
+    for (CpuInfo& cpu : *out) {
+      if (info.ProcessorMask & ((ULONG_PTR)1 << cpu.id))
+        cpu.package = package;
+    }
+    package++;
+  }
+
+  return true;
+}
+
+// Threads ---------------------------------------------------------------------
+
+bool SetCurrentThreadAffinity(uint32_t cpu_id) {
+  if (cpu_id >= 64)
+    return false;
+  return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu_id) != 0;
+}
+
+void SetCurrentThreadName(const char* name) {
+  constexpr int kMaxLength = 64;
+  wchar_t wide_name[kMaxLength];
+  int len = MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, kMaxLength);
+  if (len > 0)
+    SetThreadDescription(GetCurrentThread(), wide_name);
+}
+
 }  // namespace warhol
@@ -12,6 +12,7 @@
 #include "warhol/input/input.h"
 #include "warhol/memory/memory_tracker.h"
 #include "warhol/utils/log.h"
+#include "warhol/utils/string.h"
 #include "warhol/platform/timing.h"
 #include "warhol/window/common/window.h"
 
@@ -133,6 +134,7 @@ void ImguiStartFrame(Window* window, PlatformTime* time, InputState* input,
                      ImguiContext* imgui) {
   ASSERT(Valid(window));
   ASSERT(Valid(imgui));
+  SCOPED_ALLOCATION_TAG(kImgui);
 
   imgui->io->DisplaySize = {(float)window->width, (float)window->height};
   imgui->io->DisplayFramebufferScale = {1.0f, 1.0f};
@@ -154,6 +156,7 @@ namespace {
 
 RenderCommand ImguiEndFrame(ImguiContext* imgui) {
   SCOPE_LOCATION();
+  SCOPED_ALLOCATION_TAG(kImgui);
 
   ASSERT(Valid(imgui));
   // Will finalize the draw data needed for getting the draw lists for getting
@@ -162,10 +165,114 @@ RenderCommand ImguiEndFrame(ImguiContext* imgui) {
   return ImguiGetRenderCommand(&imgui->imgui_renderer);
 }
 
-/* void TrackImguiMemory(MemoryTracker* tracker, ImguiContext* imgui) { */
-/*   Track(tracker, &imgui->imgui_renderer.memory_pool); */
-/*   Track(tracker, &imgui->imgui_renderer.mesh); */
-/* } */
+// Memory ----------------------------------------------------------------------
+
+void TrackImguiMemory(ImguiContext* imgui) {
+  ImguiRenderer* renderer = &imgui->imgui_renderer;
+  if (!renderer->memory_pool.name)
+    renderer->memory_pool.name = "Imgui";
+  Track(&renderer->memory_pool);
+  Track(&renderer->mesh.vertices);
+  Track(&renderer->mesh.indices);
+}
+
+namespace {
+
+void MemoryStatsRow(const TrackedStats& stats) {
+  float used_ratio = stats.reserved > 0
+      ? (float)stats.used / (float)stats.reserved
+      : 0.0f;
+  auto used_str = BytesToString(stats.used);
+  auto reserved_str = BytesToString(stats.reserved);
+  auto bar = StringPrintf("%s/%s", used_str.c_str(), reserved_str.c_str());
+
+  ImGui::Text("%s", stats.name ? stats.name : ToString(stats.type));
+  ImGui::NextColumn();
+  ImGui::ProgressBar(used_ratio, {-1, 0}, bar.c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%s", BytesToString(stats.peak_used).c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%s", BytesToString(stats.committed).c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%u", stats.allocations_last_frame);
+  ImGui::NextColumn();
+  if (stats.near_misses > 0) {
+    ImGui::TextColored({1.0f, 0.4f, 0.4f, 1.0f}, "%u", stats.near_misses);
+  } else {
+    ImGui::Text("0");
+  }
+  ImGui::NextColumn();
+}
+
+}  // namespace
+
+void ImguiMemoryTrackerWindow(bool* open) {
+  if (!ImGui::Begin("Memory", open)) {
+    ImGui::End();
+    return;
+  }
+
+  std::vector<TrackedStats> stats = GetTrackedStats();
+  TrackedStats totals = GetTrackedTotals(stats);
+
+  ImGui::Text("Frame %llu. Used %s of %s reserved (%s committed).",
+              (unsigned long long)GetGlobalTracker().frame_index.load(),
+              BytesToString(totals.used).c_str(),
+              BytesToString(totals.reserved).c_str(),
+              BytesToString(totals.committed).c_str());
+  if (ImGui::Button("Dump CSV"))
+    DumpMemoryTrackerCSV("memory_stats.csv");
+  ImGui::Separator();
+
+  ImGui::Columns(6, "memory_stats");
+  ImGui::Text("Name"); ImGui::NextColumn();
+  ImGui::Text("Used/Reserved"); ImGui::NextColumn();
+  ImGui::Text("Peak"); ImGui::NextColumn();
+  ImGui::Text("Committed"); ImGui::NextColumn();
+  ImGui::Text("Allocs/frame"); ImGui::NextColumn();
+  ImGui::Text("Near misses"); ImGui::NextColumn();
+  ImGui::Separator();
+
+  for (const TrackedStats& entry : stats)
+    MemoryStatsRow(entry);
+
+  ImGui::Separator();
+  MemoryStatsRow(totals);
+  ImGui::Columns(1);
+
+  if (HeapTrackingEnabled() && ImGui::CollapsingHeader("Heap")) {
+    ImGui::Columns(4, "heap_stats");
+    ImGui::Text("Tag"); ImGui::NextColumn();
+    ImGui::Text("Allocs/frame"); ImGui::NextColumn();
+    ImGui::Text("Bytes/frame"); ImGui::NextColumn();
+    ImGui::Text("Live"); ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (uint32_t i = 0; i < (uint32_t)AllocationTag::kLast; i++) {
+      auto tag = (AllocationTag)i;
+      HeapStats frame = GetHeapFrameStats(tag);
+      HeapStats total = GetHeapTotalStats(tag);
+
+      ImGui::Text("%s", ToString(tag)); ImGui::NextColumn();
+      if (frame.allocations > 0) {
+        ImGui::TextColored({1.0f, 0.4f, 0.4f, 1.0f}, "%llu",
+                           (unsigned long long)frame.allocations);
+      } else {
+        ImGui::Text("0");
+      }
+      ImGui::NextColumn();
+      ImGui::Text("%s", BytesToString(frame.allocated_bytes).c_str());
+      ImGui::NextColumn();
+      ImGui::Text("%s",
+                  BytesToString(total.allocated_bytes -
+                                total.freed_bytes).c_str());
+      ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+  }
+
+  ImGui::End();
+}
 
 }  // namespace imgui
 }  // namespace warhol
@@ -11,7 +11,6 @@ struct ImGuiIO;
 namespace warhol {
 
 struct InputState;
-struct MemoryTracker;
 struct PlatformTime;
 struct Renderer;
 struct RenderCommand;
@@ -46,7 +45,12 @@ void ImguiStartFrame(Window*, PlatformTime*, InputState*, ImguiContext*);
 // IMPORTANT: StartFrame *has* to be called each frame before this.
 RenderCommand ImguiEndFrame(ImguiContext*);
 
-void TrackImguiMemory(MemoryTracker*, ImguiContext*);
+// Tracks the imgui renderer pools in the global MemoryTracker.
+void TrackImguiMemory(ImguiContext*);
+
+// Stats of every allocator in the global MemoryTracker.
+// |open| is the window's close button (optional).
+void ImguiMemoryTrackerWindow(bool* open = nullptr);
 
 }  // namespace imgui
 }  // namespace warhol
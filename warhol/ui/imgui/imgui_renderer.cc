@@ -56,7 +56,8 @@ bool CreateMesh(Renderer* renderer, ImguiRenderer* imgui) {
   // 512 kb / 20 = 26214 vertices.
   // 512 kb / 4 = 131072 indices.
   imgui_mesh.vertex_size = AttributesSize(&imgui_mesh);
-  InitMeshPools(&imgui_mesh, KILOBYTES(512), KILOBYTES(512));
+  InitMeshPools(&imgui_mesh, KILOBYTES(512), KILOBYTES(512),
+                MeshPoolType::kScratch);
 
   if (!RendererStageMesh(renderer, &imgui_mesh))
     return false;
@@ -198,9 +199,11 @@ RenderCommand ImguiGetRenderCommand(ImguiRenderer* imgui_renderer) {
   uint64_t base_vertex_offset = 0;
   uint64_t total_size = 0;
 
-  std::vector<uint32_t> index_data;
-
-  auto mesh_actions = CreateList<MeshRenderAction>(KILOBYTES(1));
+  // Every imgui draw command becomes an action, so the array is sized once.
+  uint32_t action_count = 0;
+  for (int i = 0; i < draw_data->CmdListsCount; i++)
+    action_count += draw_data->CmdLists[i]->CmdBuffer.Size;
+  auto mesh_actions = CreateFrameArray<MeshRenderAction>(action_count);
 
   // Create the draw list.
   ImVec2 pos = draw_data->DisplayPos;
@@ -224,10 +227,6 @@ RenderCommand ImguiGetRenderCommand(ImguiRenderer* imgui_renderer) {
                           cmd_list->IdxBuffer.Size,
                           base_vertex_offset);
 
-    for (uint32_t index : cmd_list->IdxBuffer) {
-      index_data.push_back(index + base_index_offset / 4);
-    }
-
     // This will start appending drawing data into the mesh buffer that's
     // already staged into the renderer.
     for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
@@ -235,8 +234,8 @@ RenderCommand ImguiGetRenderCommand(ImguiRenderer* imgui_renderer) {
 
       // Each Imgui Draw Command is our MeshRenderCommand equivalent.
       MeshRenderAction render_action;
-      render_action.mesh = &imgui_renderer->mesh;
-      render_action.textures = &imgui_renderer->font_texture;
+      render_action.mesh = imgui_renderer->mesh.handle.value;
+      render_action.textures = &imgui_renderer->font_texture.handle.value;
 
       IndexRange range = 0;
       range = PushOffset(range, base_index_offset + index_offset);
@@ -283,7 +282,10 @@ RenderCommand ImguiGetRenderCommand(ImguiRenderer* imgui_renderer) {
   render_command.config.depth_test = false;
   render_command.config.scissor_test = true;
   render_command.camera = &imgui_renderer->camera;
-  render_command.shader = &imgui_renderer->shader;
+  render_command.shader = imgui_renderer->shader.handle.value;
+  // Imgui windows are painted over each other in order.
+  render_command.layer = kUIRenderLayer;
+  render_command.preserve_order = true;
   render_command.mesh_actions = std::move(mesh_actions);
 
   return render_command;
@@ -8,7 +8,8 @@
 namespace warhol {
 
 // A Unique represents a normal integer type that gets clear on move, instead
-// of the copying the compiler does.
+// of the copying the compiler does. Works for any small value type that is
+// comparable and whose default value means "empty" (eg. handles).
 template <typename T>
 struct ClearOnMove{
   T value;
@@ -22,22 +23,22 @@ struct ClearOnMove{
     return *this;
   }
 
-  bool has_value() const { return value != 0; }
+  bool has_value() const { return value != T(); }
 
   T& operator*() { return value; }
   T* operator->() { return &value; }
   const T& operator*() const { return value; }
   const T* operator->() const { return &value; }
 
-  void clear() { value = 0; }
+  void clear() { value = T(); }
 
   ClearOnMove(ClearOnMove&& other) {
     value = other.value;
-    other.value = 0;
+    other.value = T();
   }
   ClearOnMove& operator=(ClearOnMove&& other) {
     value = other.value;
-    other.value = 0;
+    other.value = T();
     return *this;
   }
 };
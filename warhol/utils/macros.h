@@ -67,6 +67,16 @@
 #define PRINTF_FORMAT(format_param, dots_param)
 #endif
 
+// For small functions in hot loops the compiler declines to inline (eg. because
+// they contain a loop).
+#if defined(_MSC_VER)
+#define ALWAYS_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
 // Ignore warnings for Windows because they don't have a good way
 // of ignoring warnings for certain includes
 // (I mean, they did add it in 2018...)
@@ -6,6 +6,7 @@
 
 #include <unordered_map>
 
+#include "warhol/memory/memory_tracker.h"
 #include "warhol/utils/log.h"
 
 namespace warhol {
@@ -81,6 +82,7 @@ void ShutdownWindow(Window* window) {
 List<WindowEvent>
 UpdateWindow(Window* window, InputState* input) {
   ASSERT(Valid(window));
+  SCOPED_ALLOCATION_TAG(kWindow);
   return window->backend->UpdateWindow(window, input);
 }
 